@@ -0,0 +1,121 @@
+// Measures what request accounting costs: a new/delete pair, an empty
+// RequestScope, and a RequestScope around a request-sized unit of work
+// (serializing one lot the way GET /lots/:id does), each with resource
+// accounting off and on.
+//
+// CMake builds this twice, as alloc_tracking_bench (with
+// AUCTION_ALLOC_TRACKING, so operator new/delete are the counting wrappers)
+// and alloc_tracking_bench_untracked (the default operator new/delete), so
+// the new/delete rows of the two runs compare directly. Most of the cost of
+// "accounting on" is the two CLOCK_THREAD_CPUTIME_ID reads, which are system
+// calls rather than vDSO reads.
+//
+//   alloc_tracking_bench [iterations]
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string>
+
+#include "alloc_tracking.h"
+#include "json.hpp"
+#include "lot.h"
+#include "metrics.h"
+
+namespace {
+
+// Keeps the compiler from dropping a result the benchmark never uses.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <typename Fn>
+double time_ns(int iterations, Fn&& fn) {
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn(i);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+    return elapsed / iterations;
+}
+
+Lot make_lot() {
+    Lot lot;
+    lot.id = 42;
+    lot.name = "vintage oak table";
+    lot.description = std::string(300, 'x');
+    lot.start_price = 120.0;
+    lot.current_price = 245.5;
+    lot.owner_id = "user-31337";
+    lot.created_at = "2024-03-01 12:34:56.789012+00";
+    lot.auction_end_date = "2024-04-01 18:00:00+00";
+    return lot;
+}
+
+double serialize_lot(const MetricsRegistry* registry, RouteMetrics& route, const Lot& lot, int iterations) {
+    return time_ns(iterations, [&](int) {
+        std::optional<RequestScope> scope;
+        if (registry) {
+            scope.emplace(*registry, route);
+        }
+        auto body = lot_to_json(lot).dump();
+        do_not_optimize(body.data());
+        if (scope) {
+            scope->finish(200);
+        }
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+    std::printf("iterations=%d alloc_tracking=%s\n", iterations, alloc_tracking_available() ? "on" : "off");
+    std::printf("%-36s %12s\n", "case", "ns/op");
+
+    const std::size_t sizes[] = {16, 48, 128, 512};
+    auto new_delete_ns = time_ns(iterations, [&](int i) {
+        auto* block = new char[sizes[i & 3]];
+        do_not_optimize(block);
+        delete[] block;
+    });
+    std::printf("%-36s %12.1f\n", "new/delete", new_delete_ns);
+
+    MetricsRegistry plain(false);
+    MetricsRegistry accounted(true);
+    auto& plain_route = plain.route("GET /lots/:id");
+    auto& accounted_route = accounted.route("GET /lots/:id");
+
+    auto scope_ns = time_ns(iterations, [&](int) {
+        RequestScope scope(plain, plain_route);
+        scope.finish(200);
+    });
+    auto accounted_scope_ns = time_ns(iterations, [&](int) {
+        RequestScope scope(accounted, accounted_route);
+        scope.finish(200);
+    });
+    std::printf("%-36s %12.1f\n", "scope (accounting off)", scope_ns);
+    std::printf("%-36s %12.1f\n", "scope (accounting on)", accounted_scope_ns);
+
+    const auto lot = make_lot();
+    const int request_iterations = iterations / 10 > 0 ? iterations / 10 : 1;
+    auto bare_ns = serialize_lot(nullptr, plain_route, lot, request_iterations);
+    auto plain_ns = serialize_lot(&plain, plain_route, lot, request_iterations);
+    auto accounted_ns = serialize_lot(&accounted, accounted_route, lot, request_iterations);
+    std::printf("%-36s %12.1f\n", "serialize lot (no scope)", bare_ns);
+    std::printf("%-36s %12.1f %+6.1f%%\n", "serialize lot (accounting off)", plain_ns,
+                100.0 * (plain_ns - bare_ns) / bare_ns);
+    std::printf("%-36s %12.1f %+6.1f%%\n", "serialize lot (accounting on)", accounted_ns,
+                100.0 * (accounted_ns - bare_ns) / bare_ns);
+
+    const auto sampled = accounted_route.sampled_requests.load();
+    if (alloc_tracking_available() && sampled > 0) {
+        std::printf("allocations per accounted request: %.1f (%.0f bytes)\n",
+                    static_cast<double>(accounted_route.alloc_count.load()) / static_cast<double>(sampled),
+                    static_cast<double>(accounted_route.alloc_bytes.load()) / static_cast<double>(sampled));
+    }
+    return 0;
+}
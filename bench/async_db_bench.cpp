@@ -0,0 +1,56 @@
+// Drives many concurrent queries through AsyncDatabase from a single reactor
+// thread and reports throughput and the peak number of queries in flight.
+//
+//   DATABASE_URL=postgresql://... async_db_bench [connections] [concurrency] [queries] [sleep_ms]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "async_database.h"
+
+namespace {
+
+Task<int> run_queries(AsyncDatabase& database, int queries, std::string sleep_seconds) {
+    for (int i = 0; i < queries; ++i) {
+        std::vector<std::string> params{sleep_seconds};
+        co_await database.execute("bench_sleep", "SELECT pg_sleep($1::float8)", std::move(params));
+    }
+    co_return queries;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* url = std::getenv("DATABASE_URL");
+    if (!url) {
+        std::fprintf(stderr, "DATABASE_URL is not set\n");
+        return 1;
+    }
+    const int connections = argc > 1 ? std::atoi(argv[1]) : 200;
+    const int concurrency = argc > 2 ? std::atoi(argv[2]) : 400;
+    const int queries = argc > 3 ? std::atoi(argv[3]) : 20;
+    const int sleep_ms = argc > 4 ? std::atoi(argv[4]) : 5;
+
+    QueryWatchdog watchdog(std::chrono::milliseconds(100));
+    AsyncDatabase database(url, static_cast<std::size_t>(connections), watchdog);
+    const auto sleep_seconds = std::to_string(sleep_ms / 1000.0);
+
+    const auto started = std::chrono::steady_clock::now();
+    std::vector<std::future<int>> workers;
+    for (int i = 0; i < concurrency; ++i) {
+        workers.push_back(start_task(run_queries(database, queries, sleep_seconds)));
+    }
+    long long completed = 0;
+    for (auto& worker : workers) {
+        completed += worker.get();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::printf("connections=%d concurrency=%d queries=%lld elapsed=%.2fs throughput=%.0f q/s\n", connections,
+                concurrency, completed, seconds, static_cast<double>(completed) / seconds);
+    std::printf("%s\n", database.stats().dump().c_str());
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Compares request latency to a running service over loopback TCP and over
+// its Unix domain socket, using one keep-alive connection per transport.
+//
+//   listener_latency <port> <socket_path> [requests] [path]
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "httplib.h"
+
+namespace {
+
+void report(const char* transport, httplib::Client& client, int requests, const std::string& path) {
+    client.set_keep_alive(true);
+    // Warm up the connection and the server-side route.
+    for (int i = 0; i < 100; ++i) {
+        client.Get(path);
+    }
+
+    std::vector<double> latencies_us;
+    latencies_us.reserve(static_cast<std::size_t>(requests));
+    int failures = 0;
+    for (int i = 0; i < requests; ++i) {
+        auto started = std::chrono::steady_clock::now();
+        auto response = client.Get(path);
+        auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+        if (!response || response->status != 200) {
+            ++failures;
+            continue;
+        }
+        latencies_us.push_back(elapsed);
+    }
+    if (latencies_us.empty()) {
+        std::printf("%-5s all %d requests failed\n", transport, requests);
+        return;
+    }
+    std::sort(latencies_us.begin(), latencies_us.end());
+    auto percentile = [&latencies_us](double p) {
+        return latencies_us[static_cast<std::size_t>(p * static_cast<double>(latencies_us.size() - 1))];
+    };
+    std::printf("%-5s p50=%.1fus p90=%.1fus p99=%.1fus max=%.1fus failures=%d\n", transport, percentile(0.50),
+                percentile(0.90), percentile(0.99), latencies_us.back(), failures);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <port> <socket_path> [requests] [path]\n", argv[0]);
+        return 1;
+    }
+    const int port = std::atoi(argv[1]);
+    const std::string socket_path = argv[2];
+    const int requests = argc > 3 ? std::atoi(argv[3]) : 20000;
+    const std::string path = argc > 4 ? argv[4] : "/health";
+
+    httplib::Client tcp("127.0.0.1", port);
+    report("tcp", tcp, requests, path);
+
+    httplib::Client uds(socket_path);
+    uds.set_address_family(AF_UNIX);
+    report("uds", uds, requests, path);
+    return 0;
+}
@@ -0,0 +1,152 @@
+// Measures memory per lot and lookup latency of LotCache against a cache of
+// plain nlohmann::json objects, and put latency while rewritten descriptions
+// keep the string arena compacting.
+//
+//   lot_cache_bench [lots] [lookups]
+#include <malloc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "json.hpp"
+#include "lot_cache.h"
+
+namespace {
+
+std::size_t heap_in_use() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+Lot make_lot(int id, std::mt19937& rng) {
+    static const char* const kWords[] = {"vintage", "oak", "table", "signed", "print", "rare", "coin",
+                                         "lamp", "brass", "watch", "first", "edition", "chair", "silver"};
+    auto word = [&rng] { return std::string(kWords[rng() % (sizeof(kWords) / sizeof(kWords[0]))]); };
+
+    std::string name = word() + " " + word();
+    if (rng() % 4 == 0) {
+        name += " " + word() + " " + word() + " " + word();
+    }
+    std::string description;
+    const auto description_words = 10 + rng() % 30;
+    for (unsigned i = 0; i < description_words; ++i) {
+        description += word() + ' ';
+    }
+
+    Lot lot;
+    lot.id = id;
+    lot.name = name;
+    lot.description = description;
+    lot.start_price = static_cast<double>(100 + rng() % 100000) / 100.0;
+    if (rng() % 3 != 0) {
+        lot.current_price = static_cast<double>(100 + rng() % 1000000) / 100.0;
+    }
+    lot.owner_id = "user-" + std::to_string(rng() % 50000);
+    // 2024-01-01 plus up to a year, rendered the way Postgres does.
+    const std::int64_t created_us = 1704067200LL * 1000000 + static_cast<std::int64_t>(rng() % 31536000) * 1000000 +
+                                    static_cast<std::int64_t>(rng() % 1000000);
+    lot.created_at = format_pg_timestamp(created_us, 0);
+    lot.auction_end_date = "2025-01-15 18:00:00+00";
+    return lot;
+}
+
+template <typename Lookup>
+double measure_lookups(std::size_t lookups, int max_id, int id_offset, Lookup&& lookup) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> pick(1, max_id);
+    std::vector<int> ids(lookups);
+    for (auto& id : ids) {
+        id = pick(rng) + id_offset;
+    }
+    std::size_t found = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (int id : ids) {
+        found += lookup(id) ? 1 : 0;
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+    if (found == 42) {
+        std::puts("");
+    }
+    return elapsed / static_cast<double>(lookups);
+}
+
+// Overwrites random lots with new descriptions, so every put leaves garbage
+// in the arena and compaction runs several times over.
+void measure_puts_while_compacting(LotCache& cache, int lots, std::size_t puts) {
+    std::mt19937 rng(11);
+    std::vector<double> latencies;
+    latencies.reserve(puts);
+    const auto compactions_before = cache.stats()["compactions"].get<std::uint64_t>();
+    for (std::size_t i = 0; i < puts; ++i) {
+        auto lot = make_lot(1 + static_cast<int>(rng() % static_cast<unsigned>(lots)), rng);
+        auto started = std::chrono::steady_clock::now();
+        cache.put(lot);
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[static_cast<std::size_t>(p * static_cast<double>(latencies.size() - 1))];
+    };
+    std::printf("compact: put p50 %.1f us, p99.9 %.1f us, max %.1f us over %zu puts (%llu compactions)\n",
+                percentile(0.5), percentile(0.999), latencies.back(), puts,
+                static_cast<unsigned long long>(cache.stats()["compactions"].get<std::uint64_t>() -
+                                                compactions_before));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int lots = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    const std::size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    const int baseline_lots = std::min(lots, 200000);
+
+    std::printf("lots=%d lookups=%zu sizeof(CompactLot)=%zu\n", lots, lookups, sizeof(CompactLot));
+
+    std::size_t heap_before = heap_in_use();
+    LotCache cache(static_cast<std::size_t>(lots));
+    std::mt19937 rng(1);
+    std::size_t payload_bytes = 0;
+    for (int id = 1; id <= lots; ++id) {
+        auto lot = make_lot(id, rng);
+        payload_bytes += lot.name.size() + lot.description->size();
+        if (!cache.put(lot)) {
+            std::fprintf(stderr, "failed to cache lot %d\n", id);
+            return 1;
+        }
+    }
+    const std::size_t compact_heap = heap_in_use() - heap_before;
+    std::printf("compact: %.1f bytes/lot (heap), %.1f bytes/lot (self-reported), %.1f of them name+description\n",
+                static_cast<double>(compact_heap) / lots, static_cast<double>(cache.memory_usage()) / lots,
+                static_cast<double>(payload_bytes) / lots);
+    std::printf("compact: projected %.2f GiB for 10M lots\n",
+                static_cast<double>(compact_heap) / lots * 1e7 / (1024.0 * 1024.0 * 1024.0));
+
+    std::printf("compact: hit  %.0f ns/lookup (decode to Lot)\n",
+                measure_lookups(lookups, lots, 0, [&cache](int id) { return cache.get(id).has_value(); }));
+    std::printf("compact: miss %.0f ns/lookup\n",
+                measure_lookups(lookups, lots, lots, [&cache](int id) { return cache.get(id).has_value(); }));
+    measure_puts_while_compacting(cache, lots, static_cast<std::size_t>(lots) * 2);
+
+    heap_before = heap_in_use();
+    std::unordered_map<int, nlohmann::json> baseline;
+    rng.seed(1);
+    for (int id = 1; id <= baseline_lots; ++id) {
+        baseline.emplace(id, lot_to_json(make_lot(id, rng)));
+    }
+    const std::size_t baseline_heap = heap_in_use() - heap_before;
+    std::printf("json map (%d lots): %.1f bytes/lot\n", baseline_lots,
+                static_cast<double>(baseline_heap) / baseline_lots);
+    std::printf("json map: hit  %.0f ns/lookup (copy)\n",
+                measure_lookups(lookups, baseline_lots, 0, [&baseline](int id) {
+                    auto it = baseline.find(id);
+                    return it != baseline.end() && !nlohmann::json(it->second).is_null();
+                }));
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Read throughput of LotCache as reader threads are added, against the same
+// lookups through a std::shared_mutex-protected map, while one writer keeps
+// publishing new lot versions as the bid path would.
+//
+//   lot_cache_scaling [max_threads] [seconds_per_step] [lots] [writes_per_second]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "lot_cache.h"
+
+namespace {
+
+// Keeps the compiler from dropping a result the benchmark never uses.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+Lot make_lot(int id, std::int64_t price_cents) {
+    Lot lot;
+    lot.id = id;
+    lot.name = "lot " + std::to_string(id);
+    lot.description = "a description long enough to live outside the struct";
+    lot.start_price = 1.0;
+    lot.current_price = static_cast<double>(price_cents) / 100.0;
+    lot.owner_id = "user-" + std::to_string(id % 1000);
+    lot.created_at = "2024-01-01 00:00:00+00";
+    lot.auction_end_date = "2024-02-01 00:00:00+00";
+    return lot;
+}
+
+// The lock-based design LotCache replaced, reduced to what bid_state reads.
+class SharedMutexMap {
+public:
+    void put(int id, CachedBidState state) {
+        std::unique_lock lock(mutex_);
+        map_[id] = state;
+    }
+
+    std::optional<CachedBidState> get(int id) const {
+        std::shared_lock lock(mutex_);
+        auto it = map_.find(id);
+        if (it == map_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<int, CachedBidState> map_;
+};
+
+// Runs `threads` readers for `seconds` alongside a rate-limited writer and
+// returns reads per second across all readers.
+template <typename Read, typename Write>
+double measure(int threads, double seconds, int lots, int writes_per_second, Read&& read, Write&& write) {
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> total{0};
+
+    std::thread writer([&] {
+        std::mt19937 rng(99);
+        const auto interval = std::chrono::nanoseconds(1000000000LL / std::max(writes_per_second, 1));
+        auto next = std::chrono::steady_clock::now();
+        std::int64_t price = 100;
+        while (!stop.load(std::memory_order_relaxed)) {
+            write(static_cast<int>(rng() % static_cast<unsigned>(lots)) + 1, ++price);
+            next += interval;
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < threads; ++t) {
+        readers.emplace_back([&, t] {
+            std::mt19937 rng(static_cast<unsigned>(t) + 1);
+            std::uint64_t reads = 0;
+            std::uint64_t found = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 256; ++i) {
+                    found += read(static_cast<int>(rng() % static_cast<unsigned>(lots)) + 1) ? 1 : 0;
+                }
+                reads += 256;
+            }
+            total.fetch_add(reads, std::memory_order_relaxed);
+            do_not_optimize(found);
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    writer.join();
+    return static_cast<double>(total.load()) / seconds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int max_threads = argc > 1 ? std::atoi(argv[1]) : 64;
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 2.0;
+    const int lots = argc > 3 ? std::atoi(argv[3]) : 100000;
+    const int writes_per_second = argc > 4 ? std::atoi(argv[4]) : 20000;
+
+    LotCache cache(static_cast<std::size_t>(lots));
+    SharedMutexMap baseline;
+    for (int id = 1; id <= lots; ++id) {
+        cache.put(make_lot(id, 100));
+        baseline.put(id, CachedBidState{100, 0});
+    }
+
+    std::printf("hardware_concurrency=%u lots=%d writes/s=%d seconds/step=%.1f\n",
+                std::thread::hardware_concurrency(), lots, writes_per_second, seconds);
+    if (static_cast<unsigned>(max_threads) >= std::thread::hardware_concurrency()) {
+        // The writer needs a core too; past that point readers time-slice.
+        std::printf("note: rows with readers >= %u share cores and say nothing about scaling\n",
+                    std::thread::hardware_concurrency());
+    }
+    std::printf("%8s %16s %12s %16s %12s\n", "readers", "lockfree_rd/s", "scaling", "shared_mtx_rd/s", "scaling");
+
+    double lockfree_single = 0;
+    double baseline_single = 0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        const double lockfree = measure(
+            threads, seconds, lots, writes_per_second,
+            [&cache](int id) { return cache.bid_state(id).has_value(); },
+            [&cache](int id, std::int64_t price) { cache.put(make_lot(id, price)); });
+        const double locked = measure(
+            threads, seconds, lots, writes_per_second,
+            [&baseline](int id) { return baseline.get(id).has_value(); },
+            [&baseline](int id, std::int64_t price) { baseline.put(id, CachedBidState{price, 0}); });
+        if (threads == 1) {
+            lockfree_single = lockfree;
+            baseline_single = locked;
+        }
+        std::printf("%8d %16.0f %11.2fx %16.0f %11.2fx\n", threads, lockfree, lockfree / lockfree_single, locked,
+                    locked / baseline_single);
+    }
+    std::printf("%s\n", cache.stats().dump().c_str());
+    return 0;
+}
@@ -0,0 +1,120 @@
+#!/usr/bin/env bash
+# Compares WAL generated per bid when the price is updated in the wide `lots`
+# row (the pre-split layout) versus the statements Database::place_bid runs
+# against the narrow `lot_prices` row, with and without a share lock on the
+# lot row. Each bid commits on its own, as it does in the service.
+#
+# Usage: DATABASE_URL=postgres://... bench/wal_bytes_per_bid.sh [bids] [description_bytes]
+#
+# Everything runs against scratch tables in a temporary schema that is dropped
+# afterwards, so it is safe to point at a development database. Needs
+# PostgreSQL 11 or later (COMMIT inside DO).
+set -euo pipefail
+
+: "${DATABASE_URL:?DATABASE_URL must be set}"
+BIDS="${1:-10000}"
+DESCRIPTION_BYTES="${2:-2000}"
+
+psql "$DATABASE_URL" -v ON_ERROR_STOP=1 -q -X <<SQL
+DROP SCHEMA IF EXISTS wal_bench CASCADE;
+CREATE SCHEMA wal_bench;
+SET search_path = wal_bench;
+
+-- Same definitions as Database::ensure_schema.
+CREATE TABLE lots (
+    id SERIAL PRIMARY KEY,
+    name VARCHAR(255) NOT NULL,
+    description TEXT,
+    start_price DECIMAL(12, 2) NOT NULL,
+    current_price DECIMAL(12, 2),
+    owner_id VARCHAR(255),
+    created_at TIMESTAMP WITH TIME ZONE DEFAULT CURRENT_TIMESTAMP,
+    auction_end_date TIMESTAMP WITH TIME ZONE NOT NULL
+);
+CREATE INDEX ON lots (auction_end_date);
+CREATE TABLE lot_prices (
+    lot_id INTEGER PRIMARY KEY REFERENCES lots (id) ON DELETE CASCADE,
+    current_price DECIMAL(12, 2),
+    version BIGINT NOT NULL DEFAULT 0,
+    bid_count INTEGER NOT NULL DEFAULT 0
+) WITH (fillfactor = 70);
+
+INSERT INTO lots (name, description, start_price, current_price, auction_end_date)
+SELECT 'lot ' || g, repeat('x', ${DESCRIPTION_BYTES}), 1, 1, CURRENT_TIMESTAMP + INTERVAL '1 day'
+FROM generate_series(1, 100) g;
+INSERT INTO lot_prices (lot_id, current_price) SELECT id, current_price FROM lots;
+CHECKPOINT;
+
+CREATE TABLE results (layout TEXT, bids INT, wal_bytes NUMERIC);
+
+-- Pre-split layout: every bid rewrites the wide lot row.
+DO \$\$
+DECLARE
+    start_lsn pg_lsn := pg_current_wal_insert_lsn();
+BEGIN
+    FOR i IN 1..${BIDS} LOOP
+        UPDATE wal_bench.lots SET current_price = current_price + 1 WHERE id = 1 + (i % 100);
+        COMMIT;
+    END LOOP;
+    INSERT INTO wal_bench.results
+    VALUES ('lots (wide row)', ${BIDS}, pg_wal_lsn_diff(pg_current_wal_insert_lsn(), start_lsn));
+END
+\$\$;
+
+-- The statements of Database::place_bid; keep them in sync. The outbox
+-- insert is left out since it is optional.
+DO \$\$
+DECLARE
+    start_lsn pg_lsn := pg_current_wal_insert_lsn();
+    price DECIMAL(12, 2);
+BEGIN
+    FOR i IN 1..${BIDS} LOOP
+        SELECT p.current_price INTO price
+        FROM wal_bench.lot_prices p
+        JOIN wal_bench.lots l ON l.id = p.lot_id
+        WHERE p.lot_id = 1 + (i % 100)
+        FOR UPDATE OF p;
+
+        UPDATE wal_bench.lot_prices p
+        SET current_price = price + 1, version = p.version + 1, bid_count = p.bid_count + 1
+        FROM wal_bench.lots l
+        WHERE p.lot_id = 1 + (i % 100) AND l.id = p.lot_id;
+        COMMIT;
+    END LOOP;
+    INSERT INTO wal_bench.results
+    VALUES ('place_bid', ${BIDS}, pg_wal_lsn_diff(pg_current_wal_insert_lsn(), start_lsn));
+END
+\$\$;
+
+-- As above, plus the share lock on the lot row that place_bid used to take.
+DO \$\$
+DECLARE
+    start_lsn pg_lsn := pg_current_wal_insert_lsn();
+    price DECIMAL(12, 2);
+BEGIN
+    FOR i IN 1..${BIDS} LOOP
+        SELECT p.current_price INTO price
+        FROM wal_bench.lot_prices p
+        JOIN wal_bench.lots l ON l.id = p.lot_id
+        WHERE p.lot_id = 1 + (i % 100)
+        FOR UPDATE OF p
+        FOR SHARE OF l;
+
+        UPDATE wal_bench.lot_prices p
+        SET current_price = price + 1, version = p.version + 1, bid_count = p.bid_count + 1
+        FROM wal_bench.lots l
+        WHERE p.lot_id = 1 + (i % 100) AND l.id = p.lot_id;
+        COMMIT;
+    END LOOP;
+    INSERT INTO wal_bench.results
+    VALUES ('place_bid + FOR SHARE OF lots', ${BIDS}, pg_wal_lsn_diff(pg_current_wal_insert_lsn(), start_lsn));
+END
+\$\$;
+
+SELECT layout, bids, wal_bytes, round(wal_bytes / bids, 1) AS wal_bytes_per_bid FROM results;
+SELECT relname, n_tup_upd, n_tup_hot_upd
+FROM pg_stat_user_tables
+WHERE schemaname = 'wal_bench';
+
+DROP SCHEMA wal_bench CASCADE;
+SQL
@@ -0,0 +1,103 @@
+// Compares the JSON, MessagePack, CBOR and columnar JSON encodings of a
+// GET /lots listing: payload size, encode time from Lot structs and decode
+// time into nlohmann::json (what most consumers do with the body).
+//
+//   wire_format_bench [lots] [iterations]
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "json.hpp"
+#include "lot.h"
+#include "wire_format.h"
+
+namespace {
+
+std::vector<Lot> make_lots(int count) {
+    static const char* const kWords[] = {"vintage", "oak", "table", "signed", "print", "rare", "coin",
+                                         "lamp", "brass", "watch", "first", "edition", "chair", "silver"};
+    std::mt19937 rng(1);
+    auto word = [&rng] { return std::string(kWords[rng() % (sizeof(kWords) / sizeof(kWords[0]))]); };
+
+    std::vector<Lot> lots;
+    lots.reserve(static_cast<std::size_t>(count));
+    for (int id = 1; id <= count; ++id) {
+        Lot lot;
+        lot.id = id;
+        lot.name = word() + " " + word();
+        if (rng() % 3 != 0) {
+            std::string description;
+            const auto words = 10 + rng() % 30;
+            for (unsigned i = 0; i < words; ++i) {
+                description += word() + ' ';
+            }
+            lot.description = description;
+        }
+        lot.start_price = static_cast<double>(100 + rng() % 100000) / 100.0;
+        if (rng() % 3 != 0) {
+            lot.current_price = static_cast<double>(100 + rng() % 1000000) / 100.0;
+        }
+        lot.owner_id = "user-" + std::to_string(rng() % 50000);
+        lot.created_at = "2024-03-0" + std::to_string(1 + rng() % 9) + " 12:34:56.789012+00";
+        lot.auction_end_date = "2024-04-01 18:00:00+00";
+        lots.push_back(std::move(lot));
+    }
+    return lots;
+}
+
+// Keeps the compiler from dropping a result the benchmark never uses.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <typename Fn>
+double time_ms(int iterations, Fn&& fn) {
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        do_not_optimize(fn());
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    return elapsed / iterations;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int count = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+    const auto lots = make_lots(count);
+
+    std::printf("lots=%d iterations=%d\n", count, iterations);
+    std::printf("%-12s %12s %12s %12s\n", "format", "bytes", "encode_ms", "decode_ms");
+
+    const auto reference = lots_to_json(lots);
+    const std::pair<WireFormat, const char*> formats[] = {
+        {WireFormat::Json, "json"}, {WireFormat::MessagePack, "msgpack"}, {WireFormat::Cbor, "cbor"}};
+    for (const auto& [format, name] : formats) {
+        const auto body = encode(lots, format);
+        if (decode(body, format) != reference) {
+            std::fprintf(stderr, "%s round trip does not match lots_to_json\n", content_type(format));
+            return 1;
+        }
+        const double encode_ms = time_ms(iterations, [&] { return encode(lots, format).size(); });
+        const double decode_ms = time_ms(iterations, [&] { return decode(body, format).size(); });
+        std::printf("%-12s %12zu %12.2f %12.2f\n", name, body.size(), encode_ms, decode_ms);
+    }
+
+    const auto columnar = encode_columnar(lots);
+    const double columnar_encode_ms = time_ms(iterations, [&] { return encode_columnar(lots).size(); });
+    const double columnar_decode_ms = time_ms(iterations, [&] { return nlohmann::json::parse(columnar).size(); });
+    std::printf("%-12s %12zu %12.2f %12.2f\n", "columnar", columnar.size(), columnar_encode_ms, columnar_decode_ms);
+
+    // The same binary formats produced by way of nlohmann::json, for comparison.
+    const double via_json_msgpack = time_ms(iterations, [&] { return nlohmann::json::to_msgpack(lots_to_json(lots)).size(); });
+    const double via_json_cbor = time_ms(iterations, [&] { return nlohmann::json::to_cbor(lots_to_json(lots)).size(); });
+    std::printf("via nlohmann::json: msgpack %.2f ms, cbor %.2f ms\n", via_json_msgpack, via_json_cbor);
+    return 0;
+}
@@ -0,0 +1,267 @@
+#include "access_log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+class AccessLog::Ring {
+public:
+    explicit Ring(std::size_t capacity)
+        : slots_(capacity), mask_(capacity - 1) {}
+
+    bool push(const AccessLogRecord& record) {
+        auto head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        slots_[head & mask_] = record;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(AccessLogRecord& record) {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        record = slots_[tail & mask_];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Only touched by the producing thread.
+    std::uint32_t sample_counter{0};
+
+private:
+    std::vector<AccessLogRecord> slots_;
+    std::size_t mask_;
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+namespace {
+
+struct ThreadRingSlot {
+    const AccessLog* owner{nullptr};
+    void* ring{nullptr};
+};
+
+thread_local ThreadRingSlot t_ring_slot;
+
+std::size_t round_up_to_power_of_two(std::size_t value) {
+    std::size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+void copy_truncated(char* target, std::size_t target_size, std::string_view source) {
+    auto length = std::min(source.size(), target_size - 1);
+    std::memcpy(target, source.data(), length);
+    target[length] = '\0';
+}
+
+void append_escaped(std::string& out, const char* value) {
+    for (const char* c = value; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out += '\\';
+        }
+        if (static_cast<unsigned char>(*c) >= 0x20) {
+            out += *c;
+        }
+    }
+}
+
+} // namespace
+
+AccessLog::AccessLog(AccessLogSettings settings)
+    : settings_(std::move(settings)) {
+    if (settings_.sink.empty()) {
+        return;
+    }
+    if (settings_.ring_capacity == 0) {
+        throw std::invalid_argument("Access log ring capacity must be positive");
+    }
+    settings_.ring_capacity = round_up_to_power_of_two(settings_.ring_capacity);
+    settings_.sample_every = std::max<std::uint32_t>(settings_.sample_every, 1);
+
+    if (settings_.sink == "stdout") {
+        sink_ = stdout;
+    } else if (settings_.sink == "stderr") {
+        sink_ = stderr;
+    } else {
+        sink_ = std::fopen(settings_.sink.c_str(), "a");
+        if (!sink_) {
+            throw std::runtime_error("Unable to open access log file: " + settings_.sink);
+        }
+        owns_sink_ = true;
+    }
+
+    writer_ = std::thread([this] { run(); });
+}
+
+AccessLog::~AccessLog() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    if (owns_sink_) {
+        std::fclose(sink_);
+    }
+}
+
+AccessLog::Ring* AccessLog::thread_ring() {
+    if (t_ring_slot.owner == this) {
+        return static_cast<Ring*>(t_ring_slot.ring);
+    }
+    // First request served by this thread: register its ring once.
+    auto ring = std::make_unique<Ring>(settings_.ring_capacity);
+    auto* raw = ring.get();
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(std::move(ring));
+    }
+    t_ring_slot = {this, raw};
+    return raw;
+}
+
+bool AccessLog::admit() {
+    if (settings_.max_records_per_second == 0) {
+        return true;
+    }
+    auto now_s = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    auto window = rate_window_.load(std::memory_order_relaxed);
+    if (window != now_s && rate_window_.compare_exchange_strong(window, now_s, std::memory_order_relaxed)) {
+        rate_count_.store(0, std::memory_order_relaxed);
+    }
+    if (rate_count_.fetch_add(1, std::memory_order_relaxed) >= settings_.max_records_per_second) {
+        dropped_rate_limited_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void AccessLog::record(const RequestContext& context, int status, std::size_t response_bytes) {
+    if (!sink_) {
+        return;
+    }
+
+    auto* ring = thread_ring();
+    if (status < 400 && settings_.sample_every > 1 && ring->sample_counter++ % settings_.sample_every != 0) {
+        sampled_out_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!admit()) {
+        return;
+    }
+
+    AccessLogRecord record;
+    record.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    copy_truncated(record.route, sizeof(record.route), context.route);
+    copy_truncated(record.error_code, sizeof(record.error_code), context.error_code);
+    record.status = status;
+    record.lot_id = context.lot_id;
+    record.latency_us = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - context.started_at).count());
+    record.response_bytes = response_bytes;
+    for (std::size_t i = 0; i < kRequestPhaseCount; ++i) {
+        record.phase_us[i] = static_cast<std::uint32_t>(context.phase_ns[i] / 1000);
+    }
+
+    if (!ring->push(record)) {
+        dropped_full_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+nlohmann::json AccessLog::stats() const {
+    return nlohmann::json{
+        {"enabled", enabled()},
+        {"written", written_.load(std::memory_order_relaxed)},
+        {"dropped_ring_full", dropped_full_.load(std::memory_order_relaxed)},
+        {"dropped_rate_limited", dropped_rate_limited_.load(std::memory_order_relaxed)},
+        {"sampled_out", sampled_out_.load(std::memory_order_relaxed)}
+    };
+}
+
+void AccessLog::run() {
+    for (;;) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_.wait_for(lock, settings_.flush_interval, [this] { return stopping_; });
+            stopping = stopping_;
+        }
+        if (drain() > 0) {
+            std::fflush(sink_);
+        }
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+std::size_t AccessLog::drain() {
+    std::vector<Ring*> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings.reserve(rings_.size());
+        for (const auto& ring : rings_) {
+            rings.push_back(ring.get());
+        }
+    }
+
+    std::size_t drained = 0;
+    AccessLogRecord record;
+    for (auto* ring : rings) {
+        while (ring->pop(record)) {
+            write_record(record);
+            ++drained;
+        }
+    }
+    written_.fetch_add(drained, std::memory_order_relaxed);
+    return drained;
+}
+
+void AccessLog::write_record(const AccessLogRecord& record) {
+    line_.clear();
+    line_ += "{\"ts_us\":";
+    line_ += std::to_string(record.timestamp_us);
+    line_ += ",\"route\":\"";
+    append_escaped(line_, record.route);
+    line_ += "\",\"status\":";
+    line_ += std::to_string(record.status);
+    line_ += ",\"latency_us\":";
+    line_ += std::to_string(record.latency_us);
+    line_ += ",\"bytes\":";
+    line_ += std::to_string(record.response_bytes);
+    if (record.lot_id >= 0) {
+        line_ += ",\"lot_id\":";
+        line_ += std::to_string(record.lot_id);
+    }
+    if (record.error_code[0] != '\0') {
+        line_ += ",\"error_code\":\"";
+        append_escaped(line_, record.error_code);
+        line_ += '"';
+    }
+    line_ += ",\"phases_us\":{";
+    for (std::size_t i = 0; i < kRequestPhaseCount; ++i) {
+        if (i > 0) {
+            line_ += ',';
+        }
+        line_ += '"';
+        line_ += request_phase_name(static_cast<RequestPhase>(i));
+        line_ += "\":";
+        line_ += std::to_string(record.phase_us[i]);
+    }
+    line_ += "}}\n";
+    std::fwrite(line_.data(), 1, line_.size(), sink_);
+}
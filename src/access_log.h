@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "json.hpp"
+#include "request_context.h"
+
+struct AccessLogSettings {
+    // "stdout", "stderr" or a file path. Empty disables the access log.
+    std::string sink;
+    std::size_t ring_capacity{4096};
+    // Successful requests are logged one in sample_every; 4xx/5xx are always offered.
+    std::uint32_t sample_every{1};
+    // Upper bound on records accepted per second across all threads; 0 means unlimited.
+    std::uint32_t max_records_per_second{0};
+    std::chrono::milliseconds flush_interval{100};
+};
+
+struct AccessLogRecord {
+    std::int64_t timestamp_us{0};
+    char route[40]{};
+    char error_code[40]{};
+    int status{0};
+    int lot_id{-1};
+    std::uint64_t latency_us{0};
+    std::uint64_t response_bytes{0};
+    std::array<std::uint32_t, kRequestPhaseCount> phase_us{};
+};
+
+// Structured access log. Worker threads push fixed-size records into their own
+// single-producer/single-consumer ring and never wait on the sink: when a ring
+// is full the record is dropped and counted. A background thread drains the
+// rings and writes one JSON object per line.
+class AccessLog {
+public:
+    explicit AccessLog(AccessLogSettings settings);
+    ~AccessLog();
+
+    AccessLog(const AccessLog&) = delete;
+    AccessLog& operator=(const AccessLog&) = delete;
+
+    bool enabled() const { return sink_ != nullptr; }
+
+    void record(const RequestContext& context, int status, std::size_t response_bytes);
+
+    nlohmann::json stats() const;
+
+private:
+    class Ring;
+
+    Ring* thread_ring();
+    bool admit();
+    void run();
+    std::size_t drain();
+    void write_record(const AccessLogRecord& record);
+
+    AccessLogSettings settings_;
+    std::FILE* sink_{nullptr};
+    bool owns_sink_{false};
+
+    std::mutex rings_mutex_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+
+    std::atomic<std::int64_t> rate_window_{0};
+    std::atomic<std::uint32_t> rate_count_{0};
+
+    std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> dropped_full_{0};
+    std::atomic<std::uint64_t> dropped_rate_limited_{0};
+    std::atomic<std::uint64_t> sampled_out_{0};
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stopping_{false};
+    std::thread writer_;
+    std::string line_;
+};
@@ -0,0 +1,115 @@
+#include "alloc_tracking.h"
+
+#ifdef AUCTION_ALLOC_TRACKING
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local std::uint64_t t_alloc_count = 0;
+thread_local std::uint64_t t_alloc_bytes = 0;
+
+void* tracked_alloc(std::size_t size) noexcept {
+    if (size == 0) {
+        size = 1;
+    }
+    void* ptr = std::malloc(size);
+    if (ptr) {
+        ++t_alloc_count;
+        t_alloc_bytes += size;
+    }
+    return ptr;
+}
+
+void* tracked_aligned_alloc(std::size_t size, std::align_val_t alignment) noexcept {
+    auto align = static_cast<std::size_t>(alignment);
+    if (align < sizeof(void*)) {
+        align = sizeof(void*);
+    }
+    // aligned_alloc requires the size to be a multiple of the alignment.
+    std::size_t rounded = (size + align - 1) / align * align;
+    if (rounded == 0) {
+        rounded = align;
+    }
+    void* ptr = std::aligned_alloc(align, rounded);
+    if (ptr) {
+        ++t_alloc_count;
+        t_alloc_bytes += size;
+    }
+    return ptr;
+}
+
+void* throwing_alloc(std::size_t size) {
+    for (;;) {
+        if (void* ptr = tracked_alloc(size)) {
+            return ptr;
+        }
+        auto handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* throwing_aligned_alloc(std::size_t size, std::align_val_t alignment) {
+    for (;;) {
+        if (void* ptr = tracked_aligned_alloc(size, alignment)) {
+            return ptr;
+        }
+        auto handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return throwing_alloc(size); }
+void* operator new[](std::size_t size) { return throwing_alloc(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return tracked_alloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return tracked_alloc(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return throwing_aligned_alloc(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return throwing_aligned_alloc(size, alignment); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return tracked_aligned_alloc(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return tracked_aligned_alloc(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+bool alloc_tracking_available() {
+    return true;
+}
+
+AllocSnapshot thread_alloc_snapshot() {
+    return {t_alloc_count, t_alloc_bytes};
+}
+
+#else
+
+bool alloc_tracking_available() {
+    return false;
+}
+
+AllocSnapshot thread_alloc_snapshot() {
+    return {};
+}
+
+#endif
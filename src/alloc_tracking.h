@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+struct AllocSnapshot {
+    std::uint64_t count{0};
+    std::uint64_t bytes{0};
+};
+
+// Allocation counters are only maintained when the service is built with
+// AUCTION_ALLOC_TRACKING, which replaces the global operator new/delete.
+bool alloc_tracking_available();
+
+AllocSnapshot thread_alloc_snapshot();
@@ -0,0 +1,200 @@
+#include "allocator.h"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#if defined(AUCTION_ALLOCATOR_JEMALLOC)
+#include <jemalloc/jemalloc.h>
+#elif defined(AUCTION_ALLOCATOR_MIMALLOC)
+#include <mimalloc.h>
+#else
+#include <malloc.h>
+#endif
+
+#if defined(AUCTION_ALLOCATOR_JEMALLOC)
+// Read by jemalloc on first use; MALLOC_CONF in the environment still
+// overrides it. httplib runs a thread per connection slot, far more threads
+// than cores, so arenas are bound to CPUs rather than threads to keep them
+// few and warm, with the per-thread caches in front of them absorbing the
+// small json allocations. Dirty pages are purged by a background thread
+// instead of on the request path.
+extern "C" {
+const char* malloc_conf =
+    "percpu_arena:percpu,background_thread:true,dirty_decay_ms:5000,muzzy_decay_ms:5000,lg_tcache_max:16";
+}
+#endif
+
+namespace {
+
+std::uint64_t process_resident_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    std::uint64_t size_pages = 0;
+    std::uint64_t resident_pages = 0;
+    if (!(statm >> size_pages >> resident_pages)) {
+        return 0;
+    }
+    return resident_pages * static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+}
+
+double ratio(std::uint64_t numerator, std::uint64_t denominator) {
+    return denominator == 0 ? 0.0 : static_cast<double>(numerator) / static_cast<double>(denominator);
+}
+
+#if defined(AUCTION_ALLOCATOR_JEMALLOC)
+
+template <typename T>
+T read_mallctl(const std::string& name) {
+    T value{};
+    std::size_t size = sizeof(value);
+    if (mallctl(name.c_str(), &value, &size, nullptr, 0) != 0) {
+        return T{};
+    }
+    return value;
+}
+
+nlohmann::json jemalloc_arenas() {
+    auto arena_count = read_mallctl<unsigned>("arenas.narenas");
+    auto page_size = read_mallctl<std::size_t>("arenas.page");
+    auto arenas = nlohmann::json::array();
+    for (unsigned i = 0; i < arena_count; ++i) {
+        const std::string prefix = "stats.arenas." + std::to_string(i) + ".";
+        auto threads = read_mallctl<unsigned>(prefix + "nthreads");
+        auto active_pages = read_mallctl<std::size_t>(prefix + "pactive");
+        if (threads == 0 && active_pages == 0) {
+            continue;
+        }
+        auto small = read_mallctl<std::size_t>(prefix + "small.allocated");
+        auto large = read_mallctl<std::size_t>(prefix + "large.allocated");
+        auto active = active_pages * page_size;
+        arenas.push_back({
+            {"arena", i},
+            {"threads", threads},
+            {"allocated_bytes", small + large},
+            {"active_bytes", active},
+            {"dirty_bytes", read_mallctl<std::size_t>(prefix + "pdirty") * page_size},
+            {"muzzy_bytes", read_mallctl<std::size_t>(prefix + "pmuzzy") * page_size},
+            {"resident_bytes", read_mallctl<std::size_t>(prefix + "resident")},
+            {"fragmentation", 1.0 - ratio(small + large, active)}
+        });
+    }
+    return arenas;
+}
+
+nlohmann::json collect_stats(bool per_arena) {
+    // Statistics are cached until the epoch is advanced.
+    std::uint64_t epoch = 1;
+    std::size_t epoch_size = sizeof(epoch);
+    mallctl("epoch", &epoch, &epoch_size, &epoch, epoch_size);
+
+    auto allocated = read_mallctl<std::size_t>("stats.allocated");
+    auto active = read_mallctl<std::size_t>("stats.active");
+    auto resident = read_mallctl<std::size_t>("stats.resident");
+    nlohmann::json stats{
+        {"allocated_bytes", allocated},
+        {"active_bytes", active},
+        {"resident_bytes", resident},
+        {"mapped_bytes", read_mallctl<std::size_t>("stats.mapped")},
+        {"retained_bytes", read_mallctl<std::size_t>("stats.retained")},
+        {"metadata_bytes", read_mallctl<std::size_t>("stats.metadata")},
+        {"fragmentation", 1.0 - ratio(allocated, active)},
+        {"resident_overhead", ratio(resident, allocated)},
+        {"arena_count", read_mallctl<unsigned>("arenas.narenas")},
+        {"background_threads", read_mallctl<bool>("background_thread")},
+        {"config", malloc_conf}
+    };
+    if (per_arena) {
+        stats["arenas"] = jemalloc_arenas();
+    }
+    return stats;
+}
+
+#elif defined(AUCTION_ALLOCATOR_MIMALLOC)
+
+nlohmann::json collect_stats(bool per_arena) {
+    std::size_t elapsed_ms = 0;
+    std::size_t user_ms = 0;
+    std::size_t system_ms = 0;
+    std::size_t current_rss = 0;
+    std::size_t peak_rss = 0;
+    std::size_t current_commit = 0;
+    std::size_t peak_commit = 0;
+    std::size_t page_faults = 0;
+    mi_process_info(&elapsed_ms, &user_ms, &system_ms, &current_rss, &peak_rss, &current_commit, &peak_commit,
+                    &page_faults);
+
+    // mimalloc has no counter for live bytes, so fragmentation is measured
+    // against what it has committed rather than what the program holds.
+    nlohmann::json stats{
+        {"resident_bytes", current_rss},
+        {"peak_resident_bytes", peak_rss},
+        {"committed_bytes", current_commit},
+        {"peak_committed_bytes", peak_commit},
+        {"page_faults", page_faults},
+        {"resident_overhead", ratio(current_rss, current_commit)}
+    };
+    if (per_arena) {
+        // Per-heap figures are only available as mimalloc's own report.
+        std::string report;
+        mi_stats_print_out(
+            [](const char* msg, void* arg) { static_cast<std::string*>(arg)->append(msg); }, &report);
+        stats["report"] = report;
+    }
+    return stats;
+}
+
+#else
+
+nlohmann::json collect_stats(bool per_arena) {
+    auto info = mallinfo2();
+    std::uint64_t allocated = info.uordblks + info.hblkhd;
+    std::uint64_t active = info.arena + info.hblkhd;
+    auto resident = process_resident_bytes();
+    nlohmann::json stats{
+        {"allocated_bytes", allocated},
+        {"active_bytes", active},
+        {"free_bytes", info.fordblks},
+        {"mmapped_bytes", info.hblkhd},
+        {"releasable_bytes", info.keepcost},
+        {"resident_bytes", resident},
+        {"fragmentation", 1.0 - ratio(allocated, active)},
+        {"resident_overhead", ratio(resident, allocated)}
+    };
+    if (per_arena) {
+        // glibc reports its per-arena breakdown only as XML.
+        char* buffer = nullptr;
+        std::size_t length = 0;
+        if (FILE* stream = open_memstream(&buffer, &length)) {
+            malloc_info(0, stream);
+            std::fclose(stream);
+            stats["malloc_info"] = std::string(buffer, length);
+            std::free(buffer);
+        }
+    }
+    return stats;
+}
+
+#endif
+
+}  // namespace
+
+const char* allocator_name() {
+#if defined(AUCTION_ALLOCATOR_JEMALLOC)
+    return "jemalloc";
+#elif defined(AUCTION_ALLOCATOR_MIMALLOC)
+    return "mimalloc";
+#else
+    return "system";
+#endif
+}
+
+nlohmann::json allocator_stats(bool per_arena) {
+    auto stats = collect_stats(per_arena);
+    stats["allocator"] = allocator_name();
+    stats["process_resident_bytes"] = process_resident_bytes();
+    return stats;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "json.hpp"
+
+// Name of the malloc implementation the service was built against
+// (AUCTION_ALLOCATOR in CMake): "system", "jemalloc" or "mimalloc".
+const char* allocator_name();
+
+// Heap statistics from the active allocator: bytes allocated by the program,
+// active and resident bytes, and the fragmentation between them. With
+// `per_arena` the breakdown per arena (jemalloc) or heap (glibc) is included.
+nlohmann::json allocator_stats(bool per_arena);
@@ -0,0 +1,74 @@
+#include "archiver.h"
+
+#include <iostream>
+#include <utility>
+
+LotArchiver::LotArchiver(Database& database, ArchiverSettings settings)
+    : database_(database), settings_(std::move(settings)) {}
+
+LotArchiver::~LotArchiver() {
+    stop();
+}
+
+void LotArchiver::start() {
+    if (worker_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+    }
+    worker_ = std::thread([this] { run(); });
+}
+
+void LotArchiver::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void LotArchiver::update_settings(ArchiverSettings settings) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        settings_ = std::move(settings);
+    }
+    wake_.notify_all();
+}
+
+bool LotArchiver::wait_for(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return !wake_.wait_for(lock, duration, [this] { return stopping_; });
+}
+
+void LotArchiver::run() {
+    ArchiverSettings settings;
+    do {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            settings = settings_;
+        }
+        if (settings.retention_days <= 0) {
+            continue;
+        }
+        try {
+            int total = 0;
+            for (;;) {
+                int moved = database_.archive_closed_lots(settings.retention_days, settings.batch_size);
+                total += moved;
+                if (moved < settings.batch_size || !wait_for(settings.batch_pause)) {
+                    break;
+                }
+            }
+            if (total > 0) {
+                std::cout << "Archived " << total << " closed lots" << std::endl;
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << "Lot archiving failed: " << ex.what() << std::endl;
+        }
+    } while (wait_for(std::chrono::duration_cast<std::chrono::milliseconds>(settings.interval)));
+}
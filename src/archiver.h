@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "database.h"
+
+struct ArchiverSettings {
+    int retention_days{30};
+    int batch_size{500};
+    std::chrono::seconds interval{60};
+    std::chrono::milliseconds batch_pause{100};
+};
+
+// Periodically moves lots whose auction ended more than retention_days ago
+// from `lots` into `lots_archive`, one short transaction per batch. A
+// retention of zero days pauses archiving.
+class LotArchiver {
+public:
+    LotArchiver(Database& database, ArchiverSettings settings);
+    ~LotArchiver();
+
+    LotArchiver(const LotArchiver&) = delete;
+    LotArchiver& operator=(const LotArchiver&) = delete;
+
+    void start();
+    void stop();
+    void update_settings(ArchiverSettings settings);
+
+private:
+    void run();
+    bool wait_for(std::chrono::milliseconds duration);
+
+    Database& database_;
+    ArchiverSettings settings_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_{false};
+    std::thread worker_;
+};
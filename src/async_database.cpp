@@ -0,0 +1,485 @@
+#include "async_database.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include "database_common.h"
+#include "request_context.h"
+
+namespace {
+
+Lot lot_from_result(const PGresult* result, int row) {
+    auto text = [&](const char* column) -> const char* {
+        int index = PQfnumber(result, column);
+        return PQgetisnull(result, row, index) ? nullptr : PQgetvalue(result, row, index);
+    };
+    auto nullable_string = [&](const char* column) -> std::optional<std::string> {
+        const char* value = text(column);
+        return value ? std::optional<std::string>(value) : std::nullopt;
+    };
+
+    Lot lot;
+    lot.id = std::atoi(text("id"));
+    lot.name = text("name");
+    lot.description = nullable_string("description");
+    lot.start_price = std::strtod(text("start_price"), nullptr);
+    if (const char* current_price = text("current_price")) {
+        lot.current_price = std::strtod(current_price, nullptr);
+    }
+    lot.owner_id = nullable_string("owner_id");
+    lot.created_at = text("created_at");
+    lot.auction_end_date = text("auction_end_date");
+    return lot;
+}
+
+int epoll_timeout_ms(SteadyTime next_deadline) {
+    if (next_deadline == SteadyTime::max()) {
+        return -1;
+    }
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(next_deadline - std::chrono::steady_clock::now());
+    return static_cast<int>(std::clamp<std::chrono::milliseconds::rep>(remaining.count(), 0, 60000));
+}
+
+} // namespace
+
+PgReactor::PgReactor() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        throw std::system_error(errno, std::generic_category(), "Failed to create database reactor");
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+    worker_ = std::thread([this] { run(); });
+}
+
+PgReactor::~PgReactor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake();
+    worker_.join();
+    close(wake_fd_);
+    close(epoll_fd_);
+}
+
+bool PgReactor::SocketWait::await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    std::lock_guard<std::mutex> lock(reactor_.mutex_);
+    epoll_event event{};
+    event.events = events_ | EPOLLONESHOT;
+    event.data.fd = fd_;
+    if (epoll_ctl(reactor_.epoll_fd_, EPOLL_CTL_ADD, fd_, &event) != 0) {
+        error_ = errno;
+        return false;
+    }
+    reactor_.waiting_[fd_] = this;
+    if (deadline_ != SteadyTime::max()) {
+        // Let the loop recompute its timeout to include this deadline.
+        reactor_.wake();
+    }
+    return true;
+}
+
+bool PgReactor::SocketWait::await_resume() {
+    if (error_ != 0) {
+        throw std::system_error(error_, std::generic_category(), "Failed to watch database socket");
+    }
+    return ready_;
+}
+
+void PgReactor::post(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        posted_.push_back(handle);
+    }
+    wake();
+}
+
+void PgReactor::schedule(Timer& timer, SteadyTime when) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        timers_.emplace(when, &timer);
+    }
+    wake();
+}
+
+void PgReactor::cancel(Timer& timer, SteadyTime when) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timers_.erase({when, &timer});
+}
+
+void PgReactor::wake() {
+    std::uint64_t one = 1;
+    [[maybe_unused]] auto written = write(wake_fd_, &one, sizeof(one));
+}
+
+void PgReactor::run() {
+    std::vector<epoll_event> events(64);
+    std::vector<std::coroutine_handle<>> runnable;
+    std::vector<Timer*> expired;
+    for (;;) {
+        SteadyTime next_deadline = SteadyTime::max();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return;
+            }
+            for (const auto& [fd, waiter] : waiting_) {
+                next_deadline = std::min(next_deadline, waiter->deadline_);
+            }
+            if (!timers_.empty()) {
+                next_deadline = std::min(next_deadline, timers_.begin()->first);
+            }
+        }
+
+        int count = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), epoll_timeout_ms(next_deadline));
+        if (count < 0 && errno != EINTR) {
+            throw std::system_error(errno, std::generic_category(), "epoll_wait failed");
+        }
+
+        runnable.clear();
+        expired.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto finish = [&](std::unordered_map<int, SocketWait*>::iterator it, bool ready) {
+                epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->first, nullptr);
+                it->second->ready_ = ready;
+                runnable.push_back(it->second->handle_);
+                return waiting_.erase(it);
+            };
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == wake_fd_) {
+                    std::uint64_t drained;
+                    [[maybe_unused]] auto read_bytes = read(wake_fd_, &drained, sizeof(drained));
+                    continue;
+                }
+                if (auto it = waiting_.find(fd); it != waiting_.end()) {
+                    finish(it, true);
+                }
+            }
+            const auto now = std::chrono::steady_clock::now();
+            for (auto it = waiting_.begin(); it != waiting_.end();) {
+                it = it->second->deadline_ <= now ? finish(it, false) : std::next(it);
+            }
+            while (!timers_.empty() && timers_.begin()->first <= now) {
+                expired.push_back(timers_.begin()->second);
+                timers_.erase(timers_.begin());
+            }
+            runnable.insert(runnable.end(), posted_.begin(), posted_.end());
+            posted_.clear();
+        }
+        // Before resuming anything, so no coroutine that owns one of these
+        // timers can finish in between.
+        for (auto* timer : expired) {
+            timer->expire();
+        }
+        for (auto handle : runnable) {
+            handle.resume();
+        }
+    }
+}
+
+AsyncPgConnection::~AsyncPgConnection() {
+    PQfinish(connection_);
+}
+
+Task<std::unique_ptr<AsyncPgConnection>> AsyncPgConnection::connect(PgReactor& reactor, std::string uri,
+                                                                    SteadyTime deadline) {
+    PGconn* raw = PQconnectStart(uri.c_str());
+    if (!raw) {
+        throw std::bad_alloc();
+    }
+    auto connection = std::make_unique<AsyncPgConnection>(reactor, raw);
+    if (PQstatus(raw) == CONNECTION_BAD) {
+        connection->fail("Failed to connect to database");
+    }
+
+    auto status = PGRES_POLLING_WRITING;
+    while (status != PGRES_POLLING_OK) {
+        if (status == PGRES_POLLING_FAILED) {
+            connection->fail("Failed to connect to database");
+        }
+        const std::uint32_t events = status == PGRES_POLLING_READING ? EPOLLIN : EPOLLOUT;
+        if (!co_await reactor.wait(PQsocket(raw), events, deadline)) {
+            throw DeadlineExceededError("Database connection exceeded the request deadline");
+        }
+        status = PQconnectPoll(raw);
+    }
+    if (PQsetnonblocking(raw, 1) != 0) {
+        connection->fail("Failed to switch connection to non-blocking mode");
+    }
+    co_return connection;
+}
+
+Task<PgResult> AsyncPgConnection::execute_prepared(std::string name, std::string sql, std::vector<std::string> params,
+                                                   SteadyTime deadline) {
+    const int param_count = static_cast<int>(params.size());
+    if (prepared_.count(name) == 0) {
+        if (!PQsendPrepare(connection_, name.c_str(), sql.c_str(), param_count, nullptr)) {
+            fail("Failed to prepare statement");
+        }
+        auto prepared = co_await collect_result(deadline);
+        if (PQresultStatus(prepared.get()) != PGRES_COMMAND_OK) {
+            throw std::runtime_error(PQresultErrorMessage(prepared.get()));
+        }
+        prepared_.insert(name);
+    }
+
+    std::vector<const char*> values;
+    values.reserve(params.size());
+    for (const auto& param : params) {
+        values.push_back(param.c_str());
+    }
+    if (!PQsendQueryPrepared(connection_, name.c_str(), param_count, values.data(), nullptr, nullptr, 0)) {
+        fail("Failed to send query");
+    }
+    auto result = co_await collect_result(deadline);
+    auto status = PQresultStatus(result.get());
+    if (status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK) {
+        throw std::runtime_error(PQresultErrorMessage(result.get()));
+    }
+    co_return result;
+}
+
+Task<PgResult> AsyncPgConnection::collect_result(SteadyTime deadline) {
+    const int fd = PQsocket(connection_);
+    for (;;) {
+        int flushed = PQflush(connection_);
+        if (flushed == 0) {
+            break;
+        }
+        if (flushed < 0) {
+            fail("Failed to send query");
+        }
+        if (!co_await reactor_.wait(fd, EPOLLIN | EPOLLOUT, deadline)) {
+            fail_deadline();
+        }
+        if (!PQconsumeInput(connection_)) {
+            fail("Failed to read from database");
+        }
+    }
+
+    // The first error wins; later results of the same command are drained.
+    PgResult result;
+    for (;;) {
+        while (PQisBusy(connection_)) {
+            if (!co_await reactor_.wait(fd, EPOLLIN, deadline)) {
+                fail_deadline();
+            }
+            if (!PQconsumeInput(connection_)) {
+                fail("Failed to read from database");
+            }
+        }
+        PgResult next(PQgetResult(connection_));
+        if (!next) {
+            break;
+        }
+        const auto status = PQresultStatus(next.get());
+        const bool failed = status == PGRES_FATAL_ERROR || status == PGRES_BAD_RESPONSE;
+        if (!result || (failed && PQresultStatus(result.get()) != PGRES_FATAL_ERROR)) {
+            result = std::move(next);
+        }
+    }
+    if (!result) {
+        fail("Database returned no result");
+    }
+    co_return result;
+}
+
+void AsyncPgConnection::fail(const std::string& what) {
+    if (PQstatus(connection_) != CONNECTION_OK) {
+        broken_ = true;
+    }
+    throw std::runtime_error(what + ": " + PQerrorMessage(connection_));
+}
+
+void AsyncPgConnection::fail_deadline() {
+    // The protocol state is unknown after giving up mid-query, so ask the
+    // server to stop and never reuse this connection.
+    if (PGcancel* cancel = PQgetCancel(connection_)) {
+        char error[256];
+        PQcancel(cancel, error, sizeof(error));
+        PQfreeCancel(cancel);
+    }
+    broken_ = true;
+    throw DeadlineExceededError("Database query exceeded the request deadline");
+}
+
+AsyncDatabase::Lease::~Lease() {
+    if (database_) {
+        database_->release(std::move(connection_));
+    }
+}
+
+AsyncDatabase::AsyncDatabase(std::string connection_uri, std::size_t max_connections, QueryWatchdog& watchdog)
+    : connection_uri_(std::move(connection_uri)),
+      max_connections_(std::max<std::size_t>(1, max_connections)),
+      watchdog_(watchdog) {}
+
+AsyncDatabase::~AsyncDatabase() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.clear();
+}
+
+bool AsyncDatabase::try_take(AcquireAwaiter& awaiter) {
+    if (!idle_.empty()) {
+        awaiter.connection = std::move(idle_.back());
+        idle_.pop_back();
+        return true;
+    }
+    if (open_ < max_connections_) {
+        ++open_;
+        awaiter.may_open = true;
+        return true;
+    }
+    return false;
+}
+
+bool AsyncDatabase::AcquireAwaiter::await_ready() {
+    std::lock_guard<std::mutex> lock(database.mutex_);
+    return database.try_take(*this);
+}
+
+bool AsyncDatabase::AcquireAwaiter::await_suspend(std::coroutine_handle<> awaiting) {
+    handle = awaiting;
+    std::lock_guard<std::mutex> lock(database.mutex_);
+    if (database.try_take(*this)) {
+        return false;
+    }
+    database.waiters_.push_back(this);
+    if (deadline != SteadyTime::max()) {
+        database.reactor_.schedule(*this, deadline);
+        timer_scheduled = true;
+    }
+    return true;
+}
+
+void AsyncDatabase::AcquireAwaiter::await_resume() {
+    // Waiters are resumed on the reactor thread, where timers may be cancelled.
+    if (timer_scheduled) {
+        database.reactor_.cancel(*this, deadline);
+    }
+    if (timed_out) {
+        database.acquire_timeouts_.fetch_add(1, std::memory_order_relaxed);
+        throw DeadlineExceededError("Timed out waiting for a database connection");
+    }
+}
+
+void AsyncDatabase::AcquireAwaiter::expire() {
+    {
+        std::lock_guard<std::mutex> lock(database.mutex_);
+        auto it = std::find(database.waiters_.begin(), database.waiters_.end(), this);
+        if (it == database.waiters_.end()) {
+            // Already handed a connection; its resumption is posted.
+            return;
+        }
+        database.waiters_.erase(it);
+        timed_out = true;
+    }
+    database.reactor_.post(handle);
+}
+
+void AsyncDatabase::release(std::unique_ptr<AsyncPgConnection> connection) {
+    AcquireAwaiter* waiter = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (connection && connection->broken()) {
+            connection.reset();
+        }
+        if (!connection) {
+            --open_;
+        }
+        if (waiters_.empty()) {
+            if (connection) {
+                idle_.push_back(std::move(connection));
+            }
+            return;
+        }
+        waiter = waiters_.front();
+        waiters_.pop_front();
+        if (connection) {
+            waiter->connection = std::move(connection);
+        } else {
+            ++open_;
+            waiter->may_open = true;
+        }
+    }
+    // Resume on the reactor rather than deep inside the releasing coroutine.
+    reactor_.post(waiter->handle);
+}
+
+Task<AsyncDatabase::Lease> AsyncDatabase::acquire(SteadyTime deadline) {
+    AcquireAwaiter awaiter(*this, deadline);
+    co_await awaiter;
+    if (awaiter.may_open) {
+        try {
+            awaiter.connection = co_await AsyncPgConnection::connect(reactor_, connection_uri_, deadline);
+        } catch (...) {
+            release(nullptr);
+            throw;
+        }
+    }
+    co_return Lease(*this, std::move(awaiter.connection));
+}
+
+Task<PgResult> AsyncDatabase::execute(std::string name, std::string sql, std::vector<std::string> params,
+                                      SteadyTime deadline) {
+    // Still on the calling thread: nothing has suspended yet.
+    const RequestContext* context = current_request();
+    simulate_database_fault();
+
+    auto lease = co_await acquire(deadline);
+    if (std::chrono::steady_clock::now() >= deadline) {
+        // Queued behind other queries for the whole budget; keep the connection healthy.
+        throw DeadlineExceededError("Database query exceeded the request deadline");
+    }
+    queries_.fetch_add(1, std::memory_order_relaxed);
+    const auto in_flight = in_flight_.fetch_add(1, std::memory_order_relaxed) + 1;
+    auto peak = max_in_flight_.load(std::memory_order_relaxed);
+    while (in_flight > peak && !max_in_flight_.compare_exchange_weak(peak, in_flight, std::memory_order_relaxed)) {
+    }
+    struct InFlightGuard {
+        std::atomic<std::uint64_t>& counter;
+        ~InFlightGuard() { counter.fetch_sub(1, std::memory_order_relaxed); }
+    } in_flight_guard{in_flight_};
+
+    auto cancel_guard = context ? watchdog_.watch(lease->native(), *context) : QueryWatchdog::Registration();
+    co_return co_await lease->execute_prepared(std::move(name), std::move(sql), std::move(params), deadline);
+}
+
+Task<std::optional<Lot>> AsyncDatabase::get_lot_by_id(int lot_id, SteadyTime deadline) {
+    DbProbe probe("get_lot_by_id", lot_id);
+    std::vector<std::string> params{std::to_string(lot_id)};
+    auto result = co_await execute(std::string("get_lot_by_id"), kLotByIdQuery, std::move(params), deadline);
+    if (PQntuples(result.get()) == 0) {
+        co_return std::nullopt;
+    }
+    co_return lot_from_result(result.get(), 0);
+}
+
+nlohmann::json AsyncDatabase::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {
+        {"max_connections", max_connections_},
+        {"open", open_},
+        {"idle", idle_.size()},
+        {"waiting", waiters_.size()},
+        {"queries", queries_.load(std::memory_order_relaxed)},
+        {"acquire_timeouts", acquire_timeouts_.load(std::memory_order_relaxed)},
+        {"in_flight", in_flight_.load(std::memory_order_relaxed)},
+        {"max_in_flight", max_in_flight_.load(std::memory_order_relaxed)}
+    };
+}
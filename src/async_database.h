@@ -0,0 +1,209 @@
+#pragma once
+
+#include <libpq-fe.h>
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "json.hpp"
+#include "lot.h"
+#include "query_watchdog.h"
+#include "task.h"
+
+using SteadyTime = std::chrono::steady_clock::time_point;
+
+struct PgResultDeleter {
+    void operator()(PGresult* result) const { PQclear(result); }
+};
+using PgResult = std::unique_ptr<PGresult, PgResultDeleter>;
+
+// Single-threaded epoll loop that resumes coroutines waiting on Postgres
+// sockets. Coroutines resumed here must not block.
+class PgReactor {
+public:
+    class SocketWait {
+    public:
+        SocketWait(PgReactor& reactor, int fd, std::uint32_t events, SteadyTime deadline)
+            : reactor_(reactor), fd_(fd), events_(events), deadline_(deadline) {}
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        // True if the socket became ready, false if the deadline passed first.
+        bool await_resume();
+
+    private:
+        friend class PgReactor;
+
+        PgReactor& reactor_;
+        int fd_;
+        std::uint32_t events_;
+        SteadyTime deadline_;
+        std::coroutine_handle<> handle_;
+        bool ready_{false};
+        int error_{0};
+    };
+
+    // Gets expire() called on the reactor thread once its deadline passes,
+    // unless cancelled first. Cancel only on the reactor thread, so a timer is
+    // never destroyed while it is expiring.
+    class Timer {
+    public:
+        virtual void expire() = 0;
+
+    protected:
+        ~Timer() = default;
+    };
+
+    PgReactor();
+    ~PgReactor();
+
+    PgReactor(const PgReactor&) = delete;
+    PgReactor& operator=(const PgReactor&) = delete;
+
+    SocketWait wait(int fd, std::uint32_t events, SteadyTime deadline) { return {*this, fd, events, deadline}; }
+    // Resumes `handle` on the reactor thread.
+    void post(std::coroutine_handle<> handle);
+    void schedule(Timer& timer, SteadyTime when);
+    void cancel(Timer& timer, SteadyTime when);
+
+private:
+    void run();
+    void wake();
+
+    int epoll_fd_{-1};
+    int wake_fd_{-1};
+
+    std::mutex mutex_;
+    std::unordered_map<int, SocketWait*> waiting_;
+    std::vector<std::coroutine_handle<>> posted_;
+    std::set<std::pair<SteadyTime, Timer*>> timers_;
+    bool stopping_{false};
+
+    std::thread worker_;
+};
+
+// A libpq connection in non-blocking mode. Statements are prepared on first
+// use and executed with PQsendQueryPrepared.
+class AsyncPgConnection {
+public:
+    AsyncPgConnection(PgReactor& reactor, PGconn* connection) : reactor_(reactor), connection_(connection) {}
+    ~AsyncPgConnection();
+
+    AsyncPgConnection(const AsyncPgConnection&) = delete;
+    AsyncPgConnection& operator=(const AsyncPgConnection&) = delete;
+
+    static Task<std::unique_ptr<AsyncPgConnection>> connect(PgReactor& reactor, std::string uri, SteadyTime deadline);
+
+    // On a deadline the running query is cancelled, the connection is marked
+    // broken and DeadlineExceededError is thrown.
+    Task<PgResult> execute_prepared(std::string name, std::string sql, std::vector<std::string> params,
+                                    SteadyTime deadline);
+
+    bool broken() const { return broken_; }
+    PGconn* native() const { return connection_; }
+
+private:
+    Task<PgResult> collect_result(SteadyTime deadline);
+    [[noreturn]] void fail(const std::string& what);
+    [[noreturn]] void fail_deadline();
+
+    PgReactor& reactor_;
+    PGconn* connection_;
+    std::unordered_set<std::string> prepared_;
+    bool broken_{false};
+};
+
+// Coroutine counterpart of Database for hot read paths: up to
+// max_connections queries run concurrently, all driven by one reactor thread
+// instead of one blocked worker thread per query. Queries are cancelled by
+// `watchdog` like Database's are.
+class AsyncDatabase {
+public:
+    class Lease {
+    public:
+        Lease(AsyncDatabase& database, std::unique_ptr<AsyncPgConnection> connection)
+            : database_(&database), connection_(std::move(connection)) {}
+        ~Lease();
+
+        Lease(Lease&& other) noexcept
+            : database_(std::exchange(other.database_, nullptr)), connection_(std::move(other.connection_)) {}
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+
+        AsyncPgConnection& operator*() const { return *connection_; }
+        AsyncPgConnection* operator->() const { return connection_.get(); }
+
+    private:
+        AsyncDatabase* database_;
+        std::unique_ptr<AsyncPgConnection> connection_;
+    };
+
+    AsyncDatabase(std::string connection_uri, std::size_t max_connections, QueryWatchdog& watchdog);
+    ~AsyncDatabase();
+
+    AsyncDatabase(const AsyncDatabase&) = delete;
+    AsyncDatabase& operator=(const AsyncDatabase&) = delete;
+
+    // Start these on the thread serving the request, as sync_wait does: the
+    // request context and any injected fault are taken there, before the
+    // first suspension. Waiting for a connection counts against `deadline`.
+    Task<std::optional<Lot>> get_lot_by_id(int lot_id, SteadyTime deadline = SteadyTime::max());
+    Task<PgResult> execute(std::string name, std::string sql, std::vector<std::string> params,
+                           SteadyTime deadline = SteadyTime::max());
+
+    nlohmann::json stats() const;
+
+private:
+    // Queued waiters are dropped from waiters_ at their deadline and resumed
+    // with DeadlineExceededError.
+    struct AcquireAwaiter : PgReactor::Timer {
+        AcquireAwaiter(AsyncDatabase& database, SteadyTime deadline) : database(database), deadline(deadline) {}
+
+        AsyncDatabase& database;
+        SteadyTime deadline;
+        std::unique_ptr<AsyncPgConnection> connection;
+        bool may_open{false};
+        bool timer_scheduled{false};
+        bool timed_out{false};
+        std::coroutine_handle<> handle;
+
+        bool await_ready();
+        bool await_suspend(std::coroutine_handle<> awaiting);
+        void await_resume();
+        void expire() override;
+    };
+
+    Task<Lease> acquire(SteadyTime deadline);
+    bool try_take(AcquireAwaiter& awaiter);
+    // Returns a connection (or, if null, a connection slot) to the pool.
+    void release(std::unique_ptr<AsyncPgConnection> connection);
+
+    PgReactor reactor_;
+    std::string connection_uri_;
+    std::size_t max_connections_;
+    QueryWatchdog& watchdog_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<AsyncPgConnection>> idle_;
+    std::deque<AcquireAwaiter*> waiters_;
+    std::size_t open_{0};
+
+    std::atomic<std::uint64_t> queries_{0};
+    std::atomic<std::uint64_t> acquire_timeouts_{0};
+    std::atomic<std::uint64_t> in_flight_{0};
+    std::atomic<std::uint64_t> max_in_flight_{0};
+};
@@ -0,0 +1,81 @@
+#include "bulkhead.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+Bulkhead::Permit::~Permit() {
+    if (bulkhead_) {
+        bulkhead_->release();
+    }
+}
+
+Bulkhead::Bulkhead(std::string name, BulkheadSettings settings)
+    : name_(std::move(name)), settings_(settings) {
+    if (settings_.max_concurrent == 0) {
+        throw std::invalid_argument("Bulkhead '" + name_ + "' must allow at least one concurrent request");
+    }
+}
+
+std::optional<Bulkhead::Permit> Bulkhead::acquire(std::chrono::steady_clock::time_point deadline,
+                                                  RequestPriority priority) {
+    const bool urgent = priority == RequestPriority::Urgent;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (active_ < settings_.max_concurrent && waiters_.empty() && urgent_waiters_.empty()) {
+        ++active_;
+        ++admitted_;
+        urgent_admitted_ += urgent ? 1 : 0;
+        return Permit(*this);
+    }
+    if (waiters_.size() + urgent_waiters_.size() >= settings_.max_queue) {
+        ++rejected_queue_full_;
+        return std::nullopt;
+    }
+
+    auto& queue = urgent ? urgent_waiters_ : waiters_;
+    Waiter waiter;
+    queue.push_back(&waiter);
+    ++queued_;
+    urgent_waited_ += urgent ? 1 : 0;
+    auto wait_until = std::min(deadline, std::chrono::steady_clock::now() + settings_.queue_timeout);
+    bool granted = waiter.ready.wait_until(lock, wait_until, [&waiter] { return waiter.granted; });
+    if (!granted) {
+        queue.erase(std::find(queue.begin(), queue.end(), &waiter));
+        ++rejected_timeout_;
+        return std::nullopt;
+    }
+    ++admitted_;
+    urgent_admitted_ += urgent ? 1 : 0;
+    return Permit(*this);
+}
+
+void Bulkhead::release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& queue = urgent_waiters_.empty() ? waiters_ : urgent_waiters_;
+    if (queue.empty()) {
+        --active_;
+        return;
+    }
+    // Hand the slot directly to the oldest waiter so it cannot be overtaken.
+    auto* next = queue.front();
+    queue.pop_front();
+    next->granted = true;
+    next->ready.notify_one();
+}
+
+nlohmann::json Bulkhead::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nlohmann::json{
+        {"max_concurrent", settings_.max_concurrent},
+        {"max_queue", settings_.max_queue},
+        {"active", active_},
+        {"queued", waiters_.size() + urgent_waiters_.size()},
+        {"urgent_queued", urgent_waiters_.size()},
+        {"admitted", admitted_},
+        {"waited", queued_},
+        {"rejected_queue_full", rejected_queue_full_},
+        {"rejected_timeout", rejected_timeout_},
+        {"urgent_admitted", urgent_admitted_},
+        {"urgent_waited", urgent_waited_}
+    };
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "json.hpp"
+#include "request_context.h"
+
+struct BulkheadSettings {
+    std::size_t max_concurrent{16};
+    std::size_t max_queue{32};
+    std::chrono::milliseconds queue_timeout{1000};
+};
+
+// Concurrency limit for one class of traffic. At most max_concurrent requests
+// of the class run at once and at most max_queue wait for a slot (in FIFO
+// order); anything beyond that is rejected immediately, so one saturated class
+// cannot occupy every server worker thread. Urgent requests share the queue
+// limit but are handed a free slot before any normal waiter.
+class Bulkhead {
+public:
+    class Permit {
+    public:
+        explicit Permit(Bulkhead& bulkhead) : bulkhead_(&bulkhead) {}
+        ~Permit();
+
+        Permit(Permit&& other) noexcept : bulkhead_(other.bulkhead_) { other.bulkhead_ = nullptr; }
+        Permit(const Permit&) = delete;
+        Permit& operator=(const Permit&) = delete;
+        Permit& operator=(Permit&&) = delete;
+
+    private:
+        Bulkhead* bulkhead_;
+    };
+
+    Bulkhead(std::string name, BulkheadSettings settings);
+
+    Bulkhead(const Bulkhead&) = delete;
+    Bulkhead& operator=(const Bulkhead&) = delete;
+
+    const std::string& name() const { return name_; }
+    const BulkheadSettings& settings() const { return settings_; }
+
+    // Returns std::nullopt when the queue is full or the queue timeout (or the
+    // caller's deadline, if earlier) expires.
+    std::optional<Permit> acquire(
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(),
+        RequestPriority priority = RequestPriority::Normal);
+
+    nlohmann::json stats() const;
+
+private:
+    struct Waiter {
+        std::condition_variable ready;
+        bool granted{false};
+    };
+
+    void release();
+
+    std::string name_;
+    BulkheadSettings settings_;
+
+    mutable std::mutex mutex_;
+    std::deque<Waiter*> waiters_;
+    std::deque<Waiter*> urgent_waiters_;
+    std::size_t active_{0};
+    std::uint64_t admitted_{0};
+    std::uint64_t queued_{0};
+    std::uint64_t rejected_queue_full_{0};
+    std::uint64_t rejected_timeout_{0};
+    std::uint64_t urgent_admitted_{0};
+    std::uint64_t urgent_waited_{0};
+};
@@ -0,0 +1,402 @@
+#include "config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <pthread.h>
+
+#include "token_verifier.h"
+
+namespace {
+
+std::string env_name(const std::string& key) {
+    std::string name = key;
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+        return static_cast<char>(std::toupper(c));
+    });
+    return name;
+}
+
+std::map<std::string, std::string> read_config_file(const std::string& path) {
+    std::map<std::string, std::string> values;
+    if (path.empty()) {
+        return values;
+    }
+
+    std::ifstream input(path);
+    if (!input) {
+        throw std::runtime_error("Unable to open configuration file: " + path);
+    }
+    auto document = nlohmann::json::parse(input, nullptr, false, true);
+    if (document.is_discarded() || !document.is_object()) {
+        throw std::runtime_error("Configuration file must contain a JSON object: " + path);
+    }
+    for (const auto& [key, value] : document.items()) {
+        if (value.is_string()) {
+            values[key] = value.get<std::string>();
+        } else if (value.is_number() || value.is_boolean()) {
+            values[key] = value.dump();
+        } else {
+            throw std::runtime_error("Configuration key '" + key + "' must be a string, number or boolean");
+        }
+    }
+    return values;
+}
+
+class ConfigReader {
+public:
+    explicit ConfigReader(std::map<std::string, std::string> file_values)
+        : file_values_(std::move(file_values)) {}
+
+    void set_startup_section(bool startup) { startup_ = startup; }
+
+    std::optional<std::string> raw(const std::string& key) {
+        known_keys_.insert(key);
+        std::optional<std::string> value;
+        if (const char* env = std::getenv(env_name(key).c_str()); env && *env) {
+            value = env;
+        } else if (auto it = file_values_.find(key); it != file_values_.end()) {
+            value = it->second;
+        }
+        if (startup_) {
+            startup_values_[key] = value.value_or("");
+        }
+        return value;
+    }
+
+    std::string required_string(const std::string& key) {
+        auto value = raw(key);
+        if (!value || value->empty()) {
+            throw std::runtime_error("Missing configuration value: " + env_name(key));
+        }
+        return *value;
+    }
+
+    std::string string(const std::string& key, std::string default_value) {
+        auto value = raw(key);
+        return value ? *value : std::move(default_value);
+    }
+
+    long long integer(const std::string& key, long long default_value, long long min_value, long long max_value) {
+        auto value = raw(key);
+        if (!value || value->empty()) {
+            return default_value;
+        }
+        long long parsed = 0;
+        try {
+            std::size_t consumed = 0;
+            parsed = std::stoll(*value, &consumed);
+            if (consumed != value->size()) {
+                throw std::invalid_argument("trailing characters");
+            }
+        } catch (...) {
+            throw std::runtime_error(env_name(key) + " must be a valid integer");
+        }
+        if (parsed < min_value || parsed > max_value) {
+            throw std::runtime_error(env_name(key) + " must be between " + std::to_string(min_value) +
+                                     " and " + std::to_string(max_value));
+        }
+        return parsed;
+    }
+
+    bool flag(const std::string& key, bool default_value) {
+        auto value = raw(key);
+        if (!value || value->empty()) {
+            return default_value;
+        }
+        if (*value == "1" || *value == "true" || *value == "yes" || *value == "on") {
+            return true;
+        }
+        if (*value == "0" || *value == "false" || *value == "no" || *value == "off") {
+            return false;
+        }
+        throw std::runtime_error(env_name(key) + " must be a boolean");
+    }
+
+    void reject_unknown_file_keys() const {
+        for (const auto& [key, value] : file_values_) {
+            if (known_keys_.count(key) == 0) {
+                throw std::runtime_error("Unknown configuration key in file: " + key);
+            }
+        }
+    }
+
+    std::map<std::string, std::string> take_startup_values() { return std::move(startup_values_); }
+
+private:
+    std::map<std::string, std::string> file_values_;
+    std::set<std::string> known_keys_;
+    std::map<std::string, std::string> startup_values_;
+    bool startup_{true};
+};
+
+constexpr long long kMaxInt = std::numeric_limits<int>::max();
+
+} // namespace
+
+ServiceConfig load_config(const std::string& config_file) {
+    ConfigReader reader(read_config_file(config_file));
+    ServiceConfig config;
+
+    auto& startup = config.startup;
+    startup.database_url = reader.required_string("database_url");
+    startup.registry_service_url = reader.required_string("registry_service_url");
+    startup.payment_service_url = reader.required_string("payment_service_url");
+    startup.service_port = static_cast<int>(reader.integer("service_port", 0, 1, 65535));
+    if (startup.service_port == 0) {
+        throw std::runtime_error("Missing configuration value: SERVICE_PORT");
+    }
+    startup.tcp_listener = reader.flag("tcp_listener", startup.tcp_listener);
+    startup.unix_socket_path = reader.string("unix_socket_path", startup.unix_socket_path);
+    if (!startup.tcp_listener && startup.unix_socket_path.empty()) {
+        throw std::runtime_error("TCP_LISTENER=false requires UNIX_SOCKET_PATH");
+    }
+    // sockaddr_un::sun_path holds 108 bytes including the terminator.
+    if (startup.unix_socket_path.size() > 107) {
+        throw std::runtime_error("UNIX_SOCKET_PATH must be at most 107 characters");
+    }
+
+    auto read_bulkhead = [&reader](const std::string& prefix, BulkheadSettings& settings) {
+        settings.max_concurrent = static_cast<std::size_t>(
+            reader.integer(prefix + "_pool_size", static_cast<long long>(settings.max_concurrent), 1, 4096));
+        settings.max_queue = static_cast<std::size_t>(
+            reader.integer(prefix + "_queue_limit", static_cast<long long>(settings.max_queue), 0, 4096));
+    };
+    read_bulkhead("read", startup.read_pool);
+    read_bulkhead("write", startup.write_pool);
+    read_bulkhead("admin", startup.admin_pool);
+    auto queue_timeout = std::chrono::milliseconds(
+        reader.integer("pool_queue_timeout_ms", startup.read_pool.queue_timeout.count(), 1, 600000));
+    startup.read_pool.queue_timeout = queue_timeout;
+    startup.write_pool.queue_timeout = queue_timeout;
+    startup.admin_pool.queue_timeout = queue_timeout;
+
+    long long default_threads = 0;
+    for (const auto* pool : {&startup.read_pool, &startup.write_pool, &startup.admin_pool}) {
+        default_threads += static_cast<long long>(pool->max_concurrent + pool->max_queue);
+    }
+    startup.http_threads = static_cast<std::size_t>(reader.integer("http_threads", default_threads, 1, 16384));
+    startup.keep_alive_max_count = static_cast<std::size_t>(
+        reader.integer("keep_alive_max_count", static_cast<long long>(startup.keep_alive_max_count), 1, kMaxInt));
+    startup.keep_alive_timeout = std::chrono::seconds(
+        reader.integer("keep_alive_timeout_seconds", startup.keep_alive_timeout.count(), 0, 3600));
+    startup.payload_max_bytes = static_cast<std::size_t>(
+        reader.integer("payload_max_bytes", static_cast<long long>(startup.payload_max_bytes), 1,
+                       std::numeric_limits<long long>::max()));
+    startup.db_pool_size = static_cast<std::size_t>(
+        reader.integer("db_pool_size", static_cast<long long>(startup.db_pool_size), 1, 1024));
+    startup.db_acquire_timeout = std::chrono::milliseconds(
+        reader.integer("db_acquire_timeout_ms", startup.db_acquire_timeout.count(), 1, 600000));
+    startup.query_cancel_poll_interval = std::chrono::milliseconds(
+        reader.integer("query_cancel_poll_ms", startup.query_cancel_poll_interval.count(), 1, 10000));
+    startup.urgent_db_connections = static_cast<std::size_t>(
+        reader.integer("urgent_db_connections", static_cast<long long>(startup.urgent_db_connections), 0, 1023));
+    if (startup.urgent_db_connections >= startup.db_pool_size) {
+        throw std::runtime_error("URGENT_DB_CONNECTIONS must be less than DB_POOL_SIZE");
+    }
+    startup.lot_cache_capacity = static_cast<std::size_t>(
+        reader.integer("lot_cache_capacity", static_cast<long long>(startup.lot_cache_capacity), 0, 100000000));
+    startup.async_db_connections = static_cast<std::size_t>(
+        reader.integer("async_db_connections", static_cast<long long>(startup.async_db_connections), 0, 1024));
+    startup.outbox_sink = reader.string("outbox_sink", startup.outbox_sink);
+    startup.outbox_batch_size = static_cast<int>(
+        reader.integer("outbox_batch_size", startup.outbox_batch_size, 1, 100000));
+    startup.outbox_poll_interval = std::chrono::milliseconds(
+        reader.integer("outbox_poll_ms", startup.outbox_poll_interval.count(), 1, 600000));
+    startup.outbox_webhook_timeout = std::chrono::milliseconds(
+        reader.integer("outbox_webhook_timeout_ms", startup.outbox_webhook_timeout.count(), 1, 600000));
+    startup.request_accounting = reader.flag("request_accounting", startup.request_accounting);
+    startup.access_log = reader.string("access_log", startup.access_log);
+    startup.access_log_sample_every = static_cast<std::uint32_t>(
+        reader.integer("access_log_sample_every", startup.access_log_sample_every, 1, kMaxInt));
+    startup.access_log_max_per_second = static_cast<std::uint32_t>(
+        reader.integer("access_log_max_per_second", startup.access_log_max_per_second, 0, kMaxInt));
+    startup.token_deny_list_refresh = std::chrono::milliseconds(
+        reader.integer("token_deny_list_refresh_ms", startup.token_deny_list_refresh.count(), 100, 3600000));
+    startup.token_deny_list_max_age = std::chrono::milliseconds(
+        reader.integer("token_deny_list_max_age_ms", startup.token_deny_list_max_age.count(), 100, 86400000));
+    startup.fault_injection = reader.string("fault_injection", startup.fault_injection);
+
+    reader.set_startup_section(false);
+    auto& runtime = config.runtime;
+    runtime.payment_timeout = std::chrono::milliseconds(
+        reader.integer("payment_timeout_ms", runtime.payment_timeout.count(), 1, 600000));
+    runtime.registry_timeout = std::chrono::milliseconds(
+        reader.integer("registry_timeout_ms", runtime.registry_timeout.count(), 1, 600000));
+    runtime.read_deadline = std::chrono::milliseconds(
+        reader.integer("read_deadline_ms", runtime.read_deadline.count(), 1, 600000));
+    runtime.write_deadline = std::chrono::milliseconds(
+        reader.integer("write_deadline_ms", runtime.write_deadline.count(), 1, 600000));
+    runtime.admin_deadline = std::chrono::milliseconds(
+        reader.integer("admin_deadline_ms", runtime.admin_deadline.count(), 1, 600000));
+    runtime.default_auction_duration = std::chrono::seconds(
+        reader.integer("default_auction_duration_seconds", runtime.default_auction_duration.count(), 1,
+                       3650LL * 24 * 3600));
+    runtime.bid_priority_window = std::chrono::milliseconds(
+        reader.integer("bid_priority_window_ms", runtime.bid_priority_window.count(), 0, 3600000));
+    runtime.lot_cache_fresh_for = std::chrono::seconds(
+        reader.integer("lot_cache_fresh_for_seconds", runtime.lot_cache_fresh_for.count(), 0, 86400));
+    runtime.lot_cache_max_stale = std::chrono::seconds(
+        reader.integer("lot_cache_max_stale_seconds", runtime.lot_cache_max_stale.count(), 0, 86400));
+    runtime.archive_retention_days = static_cast<int>(
+        reader.integer("archive_retention_days", runtime.archive_retention_days, 0, 36500));
+    runtime.archive_batch_size = static_cast<int>(
+        reader.integer("archive_batch_size", runtime.archive_batch_size, 1, 100000));
+    runtime.archive_interval = std::chrono::seconds(
+        reader.integer("archive_interval_seconds", runtime.archive_interval.count(), 1, 86400));
+    runtime.admin_token = reader.string("admin_token", runtime.admin_token);
+    runtime.token_hmac_secret = reader.string("token_hmac_secret", runtime.token_hmac_secret);
+    auto ed25519_key = reader.string("token_ed25519_public_key", "");
+    if (!ed25519_key.empty() &&
+        (!base64_decode(ed25519_key, runtime.token_ed25519_public_key) || runtime.token_ed25519_public_key.size() != 32)) {
+        throw std::runtime_error("TOKEN_ED25519_PUBLIC_KEY must be a base64-encoded 32-byte key");
+    }
+
+    reader.reject_unknown_file_keys();
+    config.startup_values = reader.take_startup_values();
+    return config;
+}
+
+ConfigStore::ConfigStore(ServiceConfig initial, std::string config_file)
+    : config_file_(std::move(config_file)),
+      current_(std::make_shared<const ServiceConfig>(std::move(initial))) {}
+
+std::shared_ptr<const ServiceConfig> ConfigStore::current() const {
+    return std::atomic_load(&current_);
+}
+
+void ConfigStore::on_reload(std::function<void(const ServiceConfig&)> listener) {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    listeners_.push_back(std::move(listener));
+}
+
+ConfigReloadResult ConfigStore::reload() {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    ConfigReloadResult result;
+
+    ServiceConfig loaded;
+    try {
+        loaded = load_config(config_file_);
+    } catch (const std::exception& ex) {
+        result.error = ex.what();
+        return result;
+    }
+
+    auto previous = current();
+    for (const auto& [key, value] : loaded.startup_values) {
+        auto it = previous->startup_values.find(key);
+        if (it == previous->startup_values.end() || it->second != value) {
+            result.restart_required.push_back(key);
+        }
+    }
+
+    auto next = std::make_shared<ServiceConfig>(*previous);
+    next->runtime = loaded.runtime;
+    std::shared_ptr<const ServiceConfig> published = next;
+    std::atomic_store(&current_, published);
+
+    for (const auto& listener : listeners_) {
+        listener(*published);
+    }
+
+    result.ok = true;
+    return result;
+}
+
+nlohmann::json config_to_json(const ServiceConfig& config) {
+    const auto& startup = config.startup;
+    const auto& runtime = config.runtime;
+    return nlohmann::json{
+        {"startup", {
+            {"service_port", startup.service_port},
+            {"tcp_listener", startup.tcp_listener},
+            {"unix_socket_path", startup.unix_socket_path},
+            {"http_threads", startup.http_threads},
+            {"read_pool_size", startup.read_pool.max_concurrent},
+            {"read_queue_limit", startup.read_pool.max_queue},
+            {"write_pool_size", startup.write_pool.max_concurrent},
+            {"write_queue_limit", startup.write_pool.max_queue},
+            {"admin_pool_size", startup.admin_pool.max_concurrent},
+            {"admin_queue_limit", startup.admin_pool.max_queue},
+            {"pool_queue_timeout_ms", startup.read_pool.queue_timeout.count()},
+            {"keep_alive_max_count", startup.keep_alive_max_count},
+            {"keep_alive_timeout_seconds", startup.keep_alive_timeout.count()},
+            {"payload_max_bytes", startup.payload_max_bytes},
+            {"db_pool_size", startup.db_pool_size},
+            {"db_acquire_timeout_ms", startup.db_acquire_timeout.count()},
+            {"query_cancel_poll_ms", startup.query_cancel_poll_interval.count()},
+            {"urgent_db_connections", startup.urgent_db_connections},
+            {"lot_cache_capacity", startup.lot_cache_capacity},
+            {"async_db_connections", startup.async_db_connections},
+            {"outbox_sink", startup.outbox_sink},
+            {"outbox_batch_size", startup.outbox_batch_size},
+            {"outbox_poll_ms", startup.outbox_poll_interval.count()},
+            {"outbox_webhook_timeout_ms", startup.outbox_webhook_timeout.count()},
+            {"request_accounting", startup.request_accounting},
+            {"access_log", startup.access_log},
+            {"access_log_sample_every", startup.access_log_sample_every},
+            {"access_log_max_per_second", startup.access_log_max_per_second},
+            {"token_deny_list_refresh_ms", startup.token_deny_list_refresh.count()},
+            {"token_deny_list_max_age_ms", startup.token_deny_list_max_age.count()},
+            {"fault_injection", startup.fault_injection}
+        }},
+        {"runtime", {
+            {"payment_timeout_ms", runtime.payment_timeout.count()},
+            {"registry_timeout_ms", runtime.registry_timeout.count()},
+            {"read_deadline_ms", runtime.read_deadline.count()},
+            {"write_deadline_ms", runtime.write_deadline.count()},
+            {"admin_deadline_ms", runtime.admin_deadline.count()},
+            {"default_auction_duration_seconds", runtime.default_auction_duration.count()},
+            {"bid_priority_window_ms", runtime.bid_priority_window.count()},
+            {"lot_cache_fresh_for_seconds", runtime.lot_cache_fresh_for.count()},
+            {"lot_cache_max_stale_seconds", runtime.lot_cache_max_stale.count()},
+            {"archive_retention_days", runtime.archive_retention_days},
+            {"archive_batch_size", runtime.archive_batch_size},
+            {"archive_interval_seconds", runtime.archive_interval.count()},
+            {"admin_token_configured", !runtime.admin_token.empty()},
+            {"token_hmac_secret_configured", !runtime.token_hmac_secret.empty()},
+            {"token_ed25519_public_key_configured", !runtime.token_ed25519_public_key.empty()}
+        }}
+    };
+}
+
+void block_reload_signal() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+}
+
+void watch_reload_signal(ConfigStore& store) {
+    std::thread([&store] {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGHUP);
+        for (;;) {
+            int signal = 0;
+            if (sigwait(&signals, &signal) != 0) {
+                continue;
+            }
+            auto result = store.reload();
+            if (!result.ok) {
+                std::cerr << "Configuration reload failed: " << result.error << std::endl;
+                continue;
+            }
+            std::cout << "Configuration reloaded" << std::endl;
+            for (const auto& key : result.restart_required) {
+                std::cerr << "Configuration change to '" << key << "' requires a restart" << std::endl;
+            }
+        }
+    }).detach();
+}
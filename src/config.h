@@ -0,0 +1,150 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "bulkhead.h"
+#include "json.hpp"
+
+// Settings that are read once at startup; changing them requires a restart.
+struct StartupSettings {
+    std::string database_url;
+    std::string registry_service_url;
+    std::string payment_service_url;
+    int service_port{0};
+    // Serve on TCP service_port and/or a Unix domain socket for co-located
+    // clients such as a sidecar gateway. Both listeners expose the same routes.
+    bool tcp_listener{true};
+    std::string unix_socket_path;
+
+    // Defaults to the sum of the bulkhead sizes and queue limits so that a
+    // saturated traffic class can never hold every server thread.
+    std::size_t http_threads{0};
+    std::size_t keep_alive_max_count{5};
+    std::chrono::seconds keep_alive_timeout{5};
+    std::size_t payload_max_bytes{1024 * 1024};
+
+    BulkheadSettings read_pool{16, 32, std::chrono::milliseconds(1000)};
+    BulkheadSettings write_pool{8, 16, std::chrono::milliseconds(1000)};
+    BulkheadSettings admin_pool{2, 4, std::chrono::milliseconds(1000)};
+
+    std::size_t db_pool_size{16};
+    std::chrono::milliseconds db_acquire_timeout{5000};
+    std::chrono::milliseconds query_cancel_poll_interval{50};
+    // Pool connections only urgent requests may use; see bid_priority_window.
+    std::size_t urgent_db_connections{2};
+
+    // Lots kept in the in-process cache; 0 disables it. The cache is filled from
+    // this instance's own reads and writes, so only enable it when a single
+    // instance owns the data or slightly stale reads are acceptable.
+    std::size_t lot_cache_capacity{0};
+
+    // Connections for the coroutine-based read path (AsyncDatabase); 0 keeps
+    // all reads on the blocking pool.
+    std::size_t async_db_connections{0};
+
+    // "stdout", "file:<path>" or an http(s) webhook URL. Empty disables the outbox.
+    std::string outbox_sink;
+    int outbox_batch_size{200};
+    std::chrono::milliseconds outbox_poll_interval{500};
+    std::chrono::milliseconds outbox_webhook_timeout{5000};
+
+    bool request_accounting{false};
+    std::string access_log;
+    std::uint32_t access_log_sample_every{1};
+    std::uint32_t access_log_max_per_second{0};
+
+    std::chrono::milliseconds token_deny_list_refresh{30000};
+    std::chrono::milliseconds token_deny_list_max_age{120000};
+
+    // Fault rules applied at startup, as JSON in the format accepted by
+    // PUT /debug/faults. Requires a build with AUCTION_FAULT_INJECTION.
+    std::string fault_injection;
+};
+
+// Settings that can be swapped at runtime via SIGHUP or POST /admin/config/reload.
+struct RuntimeSettings {
+    std::chrono::milliseconds payment_timeout{5000};
+    std::chrono::milliseconds registry_timeout{5000};
+
+    // Default and maximum request budget per traffic class; clients may ask for
+    // less with the X-Request-Timeout-Ms header.
+    std::chrono::milliseconds read_deadline{2000};
+    std::chrono::milliseconds write_deadline{10000};
+    std::chrono::milliseconds admin_deadline{5000};
+    std::chrono::seconds default_auction_duration{std::chrono::hours(24 * 7)};
+    // Bids on lots closing within this window are urgent. The closing time
+    // comes from the lot cache, so this needs lot_cache_capacity > 0; 0 disables.
+    std::chrono::milliseconds bid_priority_window{10000};
+    // Cached lots older than lot_cache_fresh_for are served stale (with Age
+    // and Warning headers) while they are reloaded in the background, for up
+    // to lot_cache_max_stale longer. Warning 111 marks a copy served while
+    // reloads are failing. Past max_stale a read goes to the database and
+    // gets its error if the database is down; no copy is served that old.
+    // 0 keeps entries fresh until they are overwritten or evicted.
+    std::chrono::seconds lot_cache_fresh_for{0};
+    std::chrono::seconds lot_cache_max_stale{300};
+
+    int archive_retention_days{30};
+    int archive_batch_size{500};
+    std::chrono::seconds archive_interval{60};
+
+    std::string admin_token;
+
+    // Keys for verifying signed payment tokens locally; with neither set every
+    // token is checked with the payment service. The Ed25519 key is configured
+    // as base64 and held here as the raw 32 bytes.
+    std::string token_hmac_secret;
+    std::string token_ed25519_public_key;
+};
+
+struct ServiceConfig {
+    StartupSettings startup;
+    RuntimeSettings runtime;
+    // Raw values of the startup settings, used to report changes that need a restart.
+    std::map<std::string, std::string> startup_values;
+};
+
+// Loads the configuration from an optional JSON file (CONFIG_FILE) overlaid by
+// environment variables. Each key `foo_bar` in the file can be overridden by
+// the environment variable `FOO_BAR`. Throws std::runtime_error on invalid or
+// unknown settings.
+ServiceConfig load_config(const std::string& config_file);
+
+struct ConfigReloadResult {
+    bool ok{false};
+    std::string error;
+    std::vector<std::string> restart_required;
+};
+
+class ConfigStore {
+public:
+    ConfigStore(ServiceConfig initial, std::string config_file);
+
+    std::shared_ptr<const ServiceConfig> current() const;
+
+    // Callbacks run on the reloading thread after a new configuration is published.
+    void on_reload(std::function<void(const ServiceConfig&)> listener);
+
+    ConfigReloadResult reload();
+
+private:
+    std::string config_file_;
+    std::shared_ptr<const ServiceConfig> current_;
+    std::mutex reload_mutex_;
+    std::vector<std::function<void(const ServiceConfig&)>> listeners_;
+};
+
+nlohmann::json config_to_json(const ServiceConfig& config);
+
+// SIGHUP must be blocked before any thread is started so that only the watcher
+// thread receives it.
+void block_reload_signal();
+void watch_reload_signal(ConfigStore& store);
@@ -0,0 +1,108 @@
+#include "connection_pool.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include <pqxx/pqxx>
+
+ConnectionPool::Lease::Lease(ConnectionPool& pool, std::unique_ptr<pqxx::connection> connection)
+    : pool_(&pool), connection_(std::move(connection)) {}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), connection_(std::move(other.connection_)) {}
+
+ConnectionPool::Lease::~Lease() {
+    if (connection_) {
+        pool_->release(std::move(connection_));
+    }
+}
+
+ConnectionPool::ConnectionPool(std::string connection_uri, std::size_t max_size,
+                               std::chrono::milliseconds acquire_timeout, std::size_t reserved_urgent)
+    : connection_uri_(std::move(connection_uri)),
+      max_size_(max_size),
+      acquire_timeout_(acquire_timeout),
+      reserved_urgent_(reserved_urgent) {
+    if (max_size_ == 0) {
+        throw std::invalid_argument("Connection pool size must be positive");
+    }
+    if (reserved_urgent_ >= max_size_) {
+        throw std::invalid_argument("Connections reserved for urgent requests must be fewer than the pool size");
+    }
+}
+
+// Free capacity counts idle connections and ones not yet opened.
+bool ConnectionPool::can_take(RequestPriority priority) const {
+    auto free = idle_.size() + (max_size_ - open_);
+    return priority == RequestPriority::Urgent ? free > 0 : free > reserved_urgent_;
+}
+
+ConnectionPool::~ConnectionPool() = default;
+
+ConnectionPool::Lease ConnectionPool::acquire(std::chrono::steady_clock::time_point deadline,
+                                              RequestPriority priority) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!can_take(priority)) {
+        ++waits_;
+        auto wait_until = std::min(deadline, std::chrono::steady_clock::now() + acquire_timeout_);
+        bool ready = available_.wait_until(lock, wait_until, [this, priority] { return can_take(priority); });
+        if (!ready) {
+            ++timeouts_;
+            throw std::runtime_error("Timed out waiting for a database connection");
+        }
+    }
+    if (priority == RequestPriority::Urgent) {
+        ++urgent_acquired_;
+    }
+
+    if (!idle_.empty()) {
+        auto connection = std::move(idle_.back());
+        idle_.pop_back();
+        ++in_use_;
+        return Lease(*this, std::move(connection));
+    }
+
+    // Reserve the slot before connecting so the lock is not held during the handshake.
+    ++open_;
+    ++in_use_;
+    lock.unlock();
+    try {
+        return Lease(*this, std::make_unique<pqxx::connection>(connection_uri_));
+    } catch (...) {
+        lock.lock();
+        --open_;
+        --in_use_;
+        lock.unlock();
+        available_.notify_all();
+        throw;
+    }
+}
+
+void ConnectionPool::release(std::unique_ptr<pqxx::connection> connection) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --in_use_;
+        if (connection->is_open()) {
+            idle_.push_back(std::move(connection));
+        } else {
+            --open_;
+        }
+    }
+    // Waiters differ in how much free capacity they need, so wake them all.
+    available_.notify_all();
+}
+
+nlohmann::json ConnectionPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nlohmann::json{
+        {"max_size", max_size_},
+        {"open", open_},
+        {"in_use", in_use_},
+        {"idle", idle_.size()},
+        {"waits", waits_},
+        {"timeouts", timeouts_},
+        {"reserved_urgent", reserved_urgent_},
+        {"urgent_acquired", urgent_acquired_}
+    };
+}
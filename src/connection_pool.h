@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "request_context.h"
+
+namespace pqxx {
+class connection;
+}
+
+// Bounded pool of libpqxx connections. Connections are opened lazily up to
+// max_size; callers wait up to acquire_timeout for one to become free. The last
+// reserved_urgent connections are only handed to urgent requests, so a burst
+// of normal traffic cannot starve them.
+class ConnectionPool {
+public:
+    class Lease {
+    public:
+        Lease(ConnectionPool& pool, std::unique_ptr<pqxx::connection> connection);
+        ~Lease();
+
+        Lease(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+
+        pqxx::connection& operator*() const { return *connection_; }
+        pqxx::connection* operator->() const { return connection_.get(); }
+
+    private:
+        ConnectionPool* pool_;
+        std::unique_ptr<pqxx::connection> connection_;
+    };
+
+    ConnectionPool(std::string connection_uri, std::size_t max_size, std::chrono::milliseconds acquire_timeout,
+                   std::size_t reserved_urgent = 0);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Waits for a free connection until acquire_timeout or `deadline`, whichever comes first.
+    Lease acquire(std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(),
+                  RequestPriority priority = RequestPriority::Normal);
+
+    nlohmann::json stats() const;
+
+private:
+    void release(std::unique_ptr<pqxx::connection> connection);
+    bool can_take(RequestPriority priority) const;
+
+    std::string connection_uri_;
+    std::size_t max_size_;
+    std::chrono::milliseconds acquire_timeout_;
+    std::size_t reserved_urgent_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    std::vector<std::unique_ptr<pqxx::connection>> idle_;
+    std::size_t open_{0};
+    std::size_t in_use_{0};
+    std::uint64_t waits_{0};
+    std::uint64_t timeouts_{0};
+    std::uint64_t urgent_acquired_{0};
+};
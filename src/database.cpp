@@ -5,45 +5,69 @@
 
 #include <pqxx/pqxx>
 
+#include "database_common.h"
+#include "probes.h"
+#include "request_context.h"
+
 namespace {
 
-nlohmann::json row_to_json(const pqxx::row& row) {
-    nlohmann::json lot;
-    lot["id"] = row["id"].as<int>();
-    lot["name"] = row["name"].as<std::string>();
-    if (row["description"].is_null()) {
-        lot["description"] = nullptr;
-    } else {
-        lot["description"] = row["description"].as<std::string>();
+// Bounds the transaction by the remaining request budget so a slow query or a
+// lock wait fails instead of outliving the request.
+void apply_request_deadline(pqxx::work& txn) {
+    auto* context = current_request();
+    if (!context) {
+        return;
     }
-    lot["start_price"] = row["start_price"].as<double>();
-    if (row["current_price"].is_null()) {
-        lot["current_price"] = nullptr;
-    } else {
-        lot["current_price"] = row["current_price"].as<double>();
+    ensure_request_alive();
+    auto remaining = context->remaining();
+    if (!remaining) {
+        return;
     }
-    if (row["owner_id"].is_null()) {
-        lot["owner_id"] = nullptr;
-    } else {
-        lot["owner_id"] = row["owner_id"].as<std::string>();
-    }
-    lot["created_at"] = row["created_at"].as<std::string>();
-    lot["auction_end_date"] = row["auction_end_date"].as<std::string>();
+    // Round up so Postgres gives up no earlier than the deadline itself.
+    auto timeout_ms = std::to_string(remaining->count() + 1);
+    txn.exec("SET LOCAL statement_timeout = " + timeout_ms + "; SET LOCAL lock_timeout = " + timeout_ms);
+}
+
+// Arbitrary constant identifying the outbox relay's advisory lock.
+constexpr long long kOutboxRelayLockKey = 0x4155435452454C41LL;
+
+void enqueue_event(pqxx::work& txn, int lot_id, const char* event_type, const nlohmann::json& payload) {
+    txn.exec_params(
+        "INSERT INTO outbox (lot_id, event_type, payload) VALUES ($1, $2, $3::jsonb)",
+        lot_id,
+        event_type,
+        payload.dump()
+    );
+}
+
+Lot row_to_lot(const pqxx::row& row) {
+    Lot lot;
+    lot.id = row["id"].as<int>();
+    lot.name = row["name"].as<std::string>();
+    lot.description = row["description"].as<std::optional<std::string>>();
+    lot.start_price = row["start_price"].as<double>();
+    lot.current_price = row["current_price"].as<std::optional<double>>();
+    lot.owner_id = row["owner_id"].as<std::optional<std::string>>();
+    lot.created_at = row["created_at"].as<std::string>();
+    lot.auction_end_date = row["auction_end_date"].as<std::string>();
     return lot;
 }
 
 } // namespace
 
-Database::Database(std::string connection_uri)
-    : connection_uri_(std::move(connection_uri)) {
+Database::Database(std::string connection_uri, std::size_t pool_size, std::chrono::milliseconds acquire_timeout,
+                   std::chrono::milliseconds cancel_poll_interval, std::size_t urgent_connections)
+    : connection_uri_(std::move(connection_uri)),
+      pool_(connection_uri_, pool_size, acquire_timeout, urgent_connections),
+      watchdog_(cancel_poll_interval) {
     if (connection_uri_.empty()) {
         throw std::invalid_argument("Database connection string must not be empty");
     }
 }
 
 void Database::ensure_schema() {
-    pqxx::connection conn(connection_uri_);
-    pqxx::work txn(conn);
+    auto conn = pool_.acquire();
+    pqxx::work txn(*conn);
     txn.exec(R"SQL(
         CREATE TABLE IF NOT EXISTS lots (
             id SERIAL PRIMARY KEY,
@@ -56,70 +80,182 @@ void Database::ensure_schema() {
             auction_end_date TIMESTAMP WITH TIME ZONE NOT NULL
         )
     )SQL");
+    txn.exec("CREATE INDEX IF NOT EXISTS lots_auction_end_date_idx ON lots (auction_end_date)");
+    txn.exec(R"SQL(
+        CREATE TABLE IF NOT EXISTS lots_archive (
+            id INTEGER PRIMARY KEY,
+            name VARCHAR(255) NOT NULL,
+            description TEXT,
+            start_price DECIMAL(12, 2) NOT NULL,
+            current_price DECIMAL(12, 2),
+            owner_id VARCHAR(255),
+            created_at TIMESTAMP WITH TIME ZONE,
+            auction_end_date TIMESTAMP WITH TIME ZONE NOT NULL,
+            archived_at TIMESTAMP WITH TIME ZONE DEFAULT CURRENT_TIMESTAMP
+        )
+    )SQL");
+    txn.exec(R"SQL(
+        CREATE TABLE IF NOT EXISTS lot_prices (
+            lot_id INTEGER PRIMARY KEY REFERENCES lots (id) ON DELETE CASCADE,
+            current_price DECIMAL(12, 2),
+            version BIGINT NOT NULL DEFAULT 0,
+            bid_count INTEGER NOT NULL DEFAULT 0
+        ) WITH (fillfactor = 70)
+    )SQL");
+    // Older binaries insert lots without a price row; the trigger adds one for
+    // them. It is created before the backfill so no insert falls in between.
+    txn.exec(R"SQL(
+        CREATE OR REPLACE FUNCTION lots_insert_price() RETURNS trigger AS $$
+        BEGIN
+            INSERT INTO lot_prices (lot_id, current_price)
+            VALUES (NEW.id, NEW.current_price)
+            ON CONFLICT (lot_id) DO NOTHING;
+            RETURN NULL;
+        END
+        $$ LANGUAGE plpgsql
+    )SQL");
+    txn.exec("DROP TRIGGER IF EXISTS lots_insert_price ON lots");
+    txn.exec(R"SQL(
+        CREATE TRIGGER lots_insert_price AFTER INSERT ON lots
+        FOR EACH ROW EXECUTE FUNCTION lots_insert_price()
+    )SQL");
+    txn.exec(R"SQL(
+        INSERT INTO lot_prices (lot_id, current_price)
+        SELECT l.id, l.current_price
+        FROM lots l
+        WHERE NOT EXISTS (SELECT 1 FROM lot_prices p WHERE p.lot_id = l.id)
+    )SQL");
+    txn.exec(R"SQL(
+        CREATE TABLE IF NOT EXISTS outbox (
+            id BIGSERIAL PRIMARY KEY,
+            lot_id INTEGER NOT NULL,
+            event_type VARCHAR(64) NOT NULL,
+            payload JSONB NOT NULL,
+            created_at TIMESTAMP WITH TIME ZONE DEFAULT CURRENT_TIMESTAMP
+        )
+    )SQL");
     txn.commit();
 }
 
-nlohmann::json Database::get_all_lots() {
-    pqxx::connection conn(connection_uri_);
-    pqxx::work txn(conn);
-
-    nlohmann::json items = nlohmann::json::array();
-    auto result = txn.exec("SELECT * FROM lots ORDER BY id");
+std::vector<Lot> Database::get_all_lots(LotListScope scope) {
+    DbProbe probe("get_all_lots", -1);
+    PhaseTimer db_phase(RequestPhase::Database);
+    auto conn = acquire_connection();
+    pqxx::work txn(*conn);
+    auto cancel_guard = watchdog_.watch(*conn);
+    apply_request_deadline(txn);
+
+    std::vector<Lot> items;
+    pqxx::result result;
+    if (scope == LotListScope::Active) {
+        result = txn.exec("SELECT " + kLotColumns + " FROM " + kLotSource +
+                          " WHERE l.auction_end_date > CURRENT_TIMESTAMP ORDER BY l.id");
+    } else {
+        result = txn.exec("SELECT " + kLotColumns + " FROM " + kLotSource +
+                          " UNION ALL SELECT " + kArchiveColumns + " FROM lots_archive ORDER BY id");
+    }
+    items.reserve(result.size());
     for (const auto& row : result) {
-        items.push_back(row_to_json(row));
+        items.push_back(row_to_lot(row));
     }
     txn.commit();
 
     return items;
 }
 
-std::optional<nlohmann::json> Database::get_lot_by_id(int lot_id) {
-    pqxx::connection conn(connection_uri_);
-    pqxx::work txn(conn);
+std::optional<Lot> Database::get_lot_by_id(int lot_id) {
+    DbProbe probe("get_lot_by_id", lot_id);
+    PhaseTimer db_phase(RequestPhase::Database);
+    auto conn = acquire_connection();
+    pqxx::work txn(*conn);
+    auto cancel_guard = watchdog_.watch(*conn);
+    apply_request_deadline(txn);
 
-    auto result = txn.exec_params("SELECT * FROM lots WHERE id = $1", lot_id);
+    auto result = txn.exec_params(kLotByIdQuery, lot_id);
     txn.commit();
 
     if (result.empty()) {
         return std::nullopt;
     }
-    return row_to_json(result[0]);
+    return row_to_lot(result[0]);
 }
 
-nlohmann::json Database::create_lot(const LotCreateParams& params) {
-    pqxx::connection conn(connection_uri_);
-    pqxx::work txn(conn);
+Lot Database::create_lot(const LotCreateParams& params) {
+    DbProbe probe("create_lot", -1);
+    PhaseTimer db_phase(RequestPhase::Database);
+    auto conn = acquire_connection();
+    pqxx::work txn(*conn);
+    auto cancel_guard = watchdog_.watch(*conn);
+    apply_request_deadline(txn);
 
     auto result = txn.exec_params(
         R"SQL(
-            INSERT INTO lots (name, description, start_price, current_price, owner_id, auction_end_date)
-            VALUES ($1, $2, $3, $3, $4, COALESCE($5::timestamptz, CURRENT_TIMESTAMP + INTERVAL '7 days'))
-            RETURNING *
+            WITH inserted AS (
+                INSERT INTO lots (name, description, start_price, owner_id, auction_end_date)
+                VALUES ($1, $2, $3, $4, COALESCE($5::timestamptz, CURRENT_TIMESTAMP + make_interval(secs => $6)))
+                RETURNING *
+            ), price AS (
+                INSERT INTO lot_prices (lot_id, current_price)
+                SELECT id, start_price FROM inserted
+                RETURNING lot_id, current_price
+            )
+            SELECT l.id, l.name, l.description, l.start_price, p.current_price, l.owner_id, l.created_at, l.auction_end_date
+            FROM inserted l
+            JOIN price p ON p.lot_id = l.id
         )SQL",
         params.name,
         params.description ? params.description->c_str() : pqxx::null(),
         params.start_price,
         params.owner_id ? params.owner_id->c_str() : pqxx::null(),
-        params.auction_end_date ? params.auction_end_date->c_str() : pqxx::null()
+        params.auction_end_date ? params.auction_end_date->c_str() : pqxx::null(),
+        static_cast<long long>(params.default_auction_duration.count())
     );
 
-    txn.commit();
-
     if (result.empty()) {
         throw std::runtime_error("Failed to insert lot");
     }
 
-    return row_to_json(result[0]);
+    auto lot = row_to_lot(result[0]);
+    if (outbox_enabled_) {
+        enqueue_event(txn, lot.id, "lot.created", lot_to_json(lot));
+    }
+    txn.commit();
+
+    return lot;
 }
 
-std::optional<nlohmann::json> Database::update_lot(int lot_id, const LotUpdateParams& params) {
+Expected<Lot, UpdateError> Database::update_lot(int lot_id, const LotUpdateParams& params) {
+    DbProbe probe("update_lot", lot_id);
     if (!params.name_present && !params.description_present && !params.owner_id_present &&
         !params.auction_end_date_present && !params.current_price_present) {
-        return get_lot_by_id(lot_id);
+        auto lot = get_lot_by_id(lot_id);
+        if (!lot) {
+            return Unexpected(UpdateError::LotNotFound);
+        }
+        return std::move(*lot);
     }
 
-    pqxx::connection conn(connection_uri_);
-    pqxx::work txn(conn);
+    PhaseTimer db_phase(RequestPhase::Database);
+    auto conn = acquire_connection();
+    pqxx::work txn(*conn);
+    auto cancel_guard = watchdog_.watch(*conn);
+    apply_request_deadline(txn);
+
+    // A lot missing from `lots` may have been archived, which makes it read-only.
+    auto missing = [&txn, lot_id] {
+        bool archived = !txn.exec_params("SELECT 1 FROM lots_archive WHERE id = $1", lot_id).empty();
+        txn.abort();
+        return Unexpected(archived ? UpdateError::LotArchived : UpdateError::LotNotFound);
+    };
+
+    // Bids hold the price row while they check the end date, so changing it
+    // waits for them (and they for it) through the same row lock. With the
+    // outbox on, every update takes it: writers of one lot then enqueue in
+    // commit order, which is the order the relay reads the outbox in.
+    if ((params.auction_end_date_present || outbox_enabled_) &&
+        txn.exec_params("SELECT 1 FROM lot_prices WHERE lot_id = $1 FOR UPDATE", lot_id).empty()) {
+        return missing();
+    }
 
     std::vector<std::string> updates;
 
@@ -151,106 +287,156 @@ std::optional<nlohmann::json> Database::update_lot(int lot_id, const LotUpdatePa
             updates.emplace_back("auction_end_date = NULL");
         }
     }
+
     if (params.current_price_present) {
-        if (params.current_price) {
-            updates.emplace_back("current_price = " + pqxx::to_string(*params.current_price));
-        } else {
-            updates.emplace_back("current_price = NULL");
+        auto price_result = txn.exec_params(
+            "UPDATE lot_prices SET current_price = $2, version = version + 1 WHERE lot_id = $1",
+            lot_id,
+            params.current_price ? pqxx::to_string(*params.current_price).c_str() : pqxx::null()
+        );
+        if (price_result.affected_rows() == 0) {
+            return missing();
         }
     }
 
-    if (updates.empty()) {
-        txn.abort();
-        return get_lot_by_id(lot_id);
-    }
+    if (!updates.empty()) {
+        std::string sql = "UPDATE lots SET ";
+        for (std::size_t i = 0; i < updates.size(); ++i) {
+            sql += updates[i];
+            if (i + 1 < updates.size()) {
+                sql += ", ";
+            }
+        }
+        sql += " WHERE id = " + txn.quote(lot_id);
 
-    std::string sql = "UPDATE lots SET ";
-    for (std::size_t i = 0; i < updates.size(); ++i) {
-        sql += updates[i];
-        if (i + 1 < updates.size()) {
-            sql += ", ";
+        if (txn.exec(sql).affected_rows() == 0) {
+            return missing();
         }
     }
-    sql += " WHERE id = " + txn.quote(lot_id) + " RETURNING *";
-
-    auto result = txn.exec(sql);
-    txn.commit();
 
+    auto result = txn.exec_params("SELECT " + kLotColumns + " FROM " + kLotSource + " WHERE l.id = $1", lot_id);
     if (result.empty()) {
-        return std::nullopt;
+        return missing();
     }
 
-    return row_to_json(result[0]);
+    auto lot = row_to_lot(result[0]);
+    if (outbox_enabled_) {
+        enqueue_event(txn, lot_id, "lot.updated", lot_to_json(lot));
+    }
+    txn.commit();
+
+    return lot;
 }
 
 bool Database::delete_lot(int lot_id) {
-    pqxx::connection conn(connection_uri_);
-    pqxx::work txn(conn);
+    DbProbe probe("delete_lot", lot_id);
+    PhaseTimer db_phase(RequestPhase::Database);
+    auto conn = acquire_connection();
+    pqxx::work txn(*conn);
+    auto cancel_guard = watchdog_.watch(*conn);
+    apply_request_deadline(txn);
     auto result = txn.exec_params("DELETE FROM lots WHERE id = $1", lot_id);
     auto affected = result.affected_rows();
+    if (affected == 0) {
+        affected = txn.exec_params("DELETE FROM lots_archive WHERE id = $1", lot_id).affected_rows();
+    }
+    if (affected > 0 && outbox_enabled_) {
+        enqueue_event(txn, lot_id, "lot.deleted", nlohmann::json{{"id", lot_id}});
+    }
     txn.commit();
     return affected > 0;
 }
 
-std::optional<nlohmann::json> Database::place_bid(int lot_id, double bid_amount, std::string& error_reason) {
-    pqxx::connection conn(connection_uri_);
-    pqxx::work txn(conn);
-
-    auto select_result = txn.exec_params("SELECT * FROM lots WHERE id = $1 FOR UPDATE", lot_id);
+Expected<Lot, BidError> Database::place_bid(int lot_id, double bid_amount) {
+    DbProbe probe("place_bid", lot_id);
+    PhaseTimer db_phase(RequestPhase::Database);
+    auto conn = acquire_connection();
+    pqxx::work txn(*conn);
+    auto cancel_guard = watchdog_.watch(*conn);
+    apply_request_deadline(txn);
+
+    // Only the narrow price row is locked. Any row lock on lots, even FOR KEY
+    // SHARE, writes xmax into the wide lot row on every bid. update_lot takes
+    // the same price-row lock before changing the end date, so the lot is read
+    // in a separate statement once the lock is held: a statement that waited
+    // for the lock would still see the end date from before it waited.
+    AUCTION_PROBE1(bid__lock__start, lot_id);
+    auto price_result = txn.exec_params("SELECT current_price FROM lot_prices WHERE lot_id = $1 FOR UPDATE", lot_id);
+    AUCTION_PROBE1(bid__lock__acquired, lot_id);
+    pqxx::result select_result;
+    if (!price_result.empty()) {
+        select_result = txn.exec_params(
+            "SELECT start_price, auction_end_date > CURRENT_TIMESTAMP AS auction_open FROM lots WHERE id = $1",
+            lot_id
+        );
+    }
     if (select_result.empty()) {
-        error_reason = "Lot not found";
+        auto archived = txn.exec_params("SELECT 1 FROM lots_archive WHERE id = $1", lot_id);
         txn.commit();
-        return std::nullopt;
+        return Unexpected(archived.empty() ? BidError::LotNotFound : BidError::AuctionEnded);
     }
 
     const auto& row = select_result[0];
-    double baseline_price = row["current_price"].is_null() ? row["start_price"].as<double>() : row["current_price"].as<double>();
+    const auto& current_price = price_result[0]["current_price"];
+    double baseline_price = current_price.is_null() ? row["start_price"].as<double>() : current_price.as<double>();
     if (bid_amount <= baseline_price) {
-        error_reason = "Bid must be greater than current price";
         txn.commit();
-        return std::nullopt;
+        return Unexpected(BidError::BidTooLow);
     }
 
-    auto auction_open_result = txn.exec_params(
-        "SELECT $1::timestamptz > CURRENT_TIMESTAMP",
-        row["auction_end_date"].as<std::string>()
-    );
-    bool auction_open = !auction_open_result.empty() && auction_open_result[0][0].as<bool>();
-
-    if (!auction_open) {
-        error_reason = "Auction has ended";
+    if (!row["auction_open"].as<bool>()) {
         txn.commit();
-        return std::nullopt;
+        return Unexpected(BidError::AuctionEnded);
     }
 
     auto update_result = txn.exec_params(
         R"SQL(
-            UPDATE lots
-            SET current_price = $2
-            WHERE id = $1
-            RETURNING *
+            UPDATE lot_prices p
+            SET current_price = $2, version = p.version + 1, bid_count = p.bid_count + 1
+            FROM lots l
+            WHERE p.lot_id = $1 AND l.id = p.lot_id
+            RETURNING l.id, l.name, l.description, l.start_price, p.current_price, l.owner_id, l.created_at, l.auction_end_date
         )SQL",
         lot_id,
         bid_amount
     );
 
     if (update_result.empty()) {
-        error_reason = "Failed to update bid";
         txn.commit();
-        return std::nullopt;
+        return Unexpected(BidError::UpdateFailed);
     }
 
+    auto lot = row_to_lot(update_result[0]);
+    if (outbox_enabled_) {
+        enqueue_event(txn, lot_id, "bid.placed", lot_to_json(lot));
+    }
     txn.commit();
-    return row_to_json(update_result[0]);
+    return lot;
+}
+
+const char* bid_error_message(BidError error) {
+    switch (error) {
+        case BidError::LotNotFound:
+            return "Lot not found";
+        case BidError::BidTooLow:
+            return "Bid must be greater than current price";
+        case BidError::AuctionEnded:
+            return "Auction has ended";
+        case BidError::UpdateFailed:
+            return "Failed to update bid";
+    }
+    return "Bid rejected";
 }
 
 void Database::check_connection() {
-    pqxx::connection conn(connection_uri_);
-    if (!conn.is_open()) {
+    auto conn = acquire_connection();
+    if (!conn->is_open()) {
         throw std::runtime_error("Database connection is not open");
     }
 
-    pqxx::work txn(conn);
+    pqxx::work txn(*conn);
+    auto cancel_guard = watchdog_.watch(*conn);
+    apply_request_deadline(txn);
     auto result = txn.exec("SELECT 1");
     txn.commit();
 
@@ -259,3 +445,116 @@ void Database::check_connection() {
     }
 }
 
+int Database::archive_closed_lots(int retention_days, int batch_size) {
+    DbProbe probe("archive_closed_lots", -1);
+    auto conn = pool_.acquire();
+    pqxx::work txn(*conn);
+
+    // Rows locked by in-flight bids or updates are skipped and picked up by a later batch.
+    auto result = txn.exec_params(
+        R"SQL(
+            WITH moved AS (
+                DELETE FROM lots
+                WHERE id IN (
+                    SELECT id FROM lots
+                    WHERE auction_end_date < CURRENT_TIMESTAMP - make_interval(days => $1)
+                    ORDER BY auction_end_date
+                    LIMIT $2
+                    FOR UPDATE SKIP LOCKED
+                )
+                RETURNING id, name, description, start_price, owner_id, created_at, auction_end_date
+            )
+            INSERT INTO lots_archive (id, name, description, start_price, current_price, owner_id, created_at, auction_end_date)
+            SELECT m.id, m.name, m.description, m.start_price, p.current_price, m.owner_id, m.created_at, m.auction_end_date
+            FROM moved m
+            LEFT JOIN lot_prices p ON p.lot_id = m.id
+        )SQL",
+        retention_days,
+        batch_size
+    );
+    auto moved = result.affected_rows();
+    txn.commit();
+
+    return static_cast<int>(moved);
+}
+
+ConnectionPool::Lease Database::acquire_connection() {
+    simulate_database_fault();
+    auto* context = current_request();
+    if (!context) {
+        return pool_.acquire();
+    }
+    ensure_request_alive();
+    return pool_.acquire(context->deadline, context->priority);
+}
+
+int Database::relay_outbox(int batch_size, const std::function<void(const std::vector<OutboxEvent>&)>& publish) {
+    DbProbe probe("relay_outbox", -1);
+    auto conn = pool_.acquire();
+
+    // A session-level lock keeps relays on other instances out while the sink is
+    // called, without holding a transaction open for the duration of the publish.
+    {
+        pqxx::nontransaction session(*conn);
+        auto locked = session.exec_params("SELECT pg_try_advisory_lock($1)", kOutboxRelayLockKey);
+        if (locked.empty() || !locked[0][0].as<bool>()) {
+            return 0;
+        }
+    }
+    struct SessionLock {
+        pqxx::connection& conn;
+        ~SessionLock() {
+            try {
+                pqxx::nontransaction session(conn);
+                session.exec_params("SELECT pg_advisory_unlock($1)", kOutboxRelayLockKey);
+            } catch (const std::exception&) {
+                // A broken connection drops the session lock along with it.
+            }
+        }
+    } session_lock{*conn};
+
+    std::vector<OutboxEvent> events;
+    std::string ids = "{";
+    {
+        pqxx::nontransaction claim(*conn);
+        auto result = claim.exec_params(
+            "SELECT id, lot_id, event_type, payload::text AS payload, created_at FROM outbox ORDER BY id LIMIT $1",
+            batch_size
+        );
+        events.reserve(result.size());
+        for (const auto& row : result) {
+            OutboxEvent event;
+            event.id = row["id"].as<long long>();
+            event.lot_id = row["lot_id"].as<int>();
+            event.event_type = row["event_type"].as<std::string>();
+            event.payload = row["payload"].as<std::string>();
+            event.created_at = row["created_at"].as<std::string>();
+            if (ids.size() > 1) {
+                ids += ',';
+            }
+            ids += std::to_string(event.id);
+            events.push_back(std::move(event));
+        }
+    }
+    ids += '}';
+    if (events.empty()) {
+        return 0;
+    }
+
+    // A failing sink throws here and the events stay in the outbox for the next attempt.
+    publish(events);
+
+    pqxx::work txn(*conn);
+    txn.exec_params("DELETE FROM outbox WHERE id = ANY($1::bigint[])", ids);
+    txn.commit();
+
+    return static_cast<int>(events.size());
+}
+
+nlohmann::json Database::pool_stats() const {
+    return pool_.stats();
+}
+
+nlohmann::json Database::watchdog_stats() const {
+    return watchdog_.stats();
+}
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <functional>
 #include <optional>
 #include <string>
+#include <vector>
 
+#include "connection_pool.h"
+#include "expected.h"
 #include "json.hpp"
+#include "lot.h"
+#include "query_watchdog.h"
 
 struct LotCreateParams {
     std::string name;
@@ -11,6 +19,7 @@ struct LotCreateParams {
     double start_price;
     std::optional<std::string> owner_id;
     std::optional<std::string> auction_end_date;
+    std::chrono::seconds default_auction_duration{std::chrono::hours(24 * 7)};
 };
 
 struct LotUpdateParams {
@@ -26,21 +35,71 @@ struct LotUpdateParams {
     std::optional<double> current_price;
 };
 
+struct OutboxEvent {
+    long long id{0};
+    int lot_id{0};
+    std::string event_type;
+    // Event body as JSON text, exactly as stored.
+    std::string payload;
+    std::string created_at;
+};
+
+// Why a bid was rejected; these are expected outcomes, not exceptions.
+enum class BidError {
+    LotNotFound,
+    BidTooLow,
+    AuctionEnded,
+    UpdateFailed
+};
+
+const char* bid_error_message(BidError error);
+
+enum class UpdateError {
+    LotNotFound,
+    // Archived lots are read-only.
+    LotArchived
+};
+
+enum class LotListScope {
+    Active,
+    All
+};
+
 class Database {
 public:
-    explicit Database(std::string connection_uri);
+    Database(std::string connection_uri, std::size_t pool_size, std::chrono::milliseconds acquire_timeout,
+             std::chrono::milliseconds cancel_poll_interval, std::size_t urgent_connections = 0);
 
     void ensure_schema();
 
-    nlohmann::json get_all_lots();
-    std::optional<nlohmann::json> get_lot_by_id(int lot_id);
-    nlohmann::json create_lot(const LotCreateParams& params);
-    std::optional<nlohmann::json> update_lot(int lot_id, const LotUpdateParams& params);
+    std::vector<Lot> get_all_lots(LotListScope scope = LotListScope::Active);
+    std::optional<Lot> get_lot_by_id(int lot_id);
+    Lot create_lot(const LotCreateParams& params);
+    Expected<Lot, UpdateError> update_lot(int lot_id, const LotUpdateParams& params);
     bool delete_lot(int lot_id);
-    std::optional<nlohmann::json> place_bid(int lot_id, double bid_amount, std::string& error_reason);
+    Expected<Lot, BidError> place_bid(int lot_id, double bid_amount);
     void check_connection();
+    int archive_closed_lots(int retention_days, int batch_size);
+
+    // When enabled, every lot write also records an event in the `outbox`
+    // table within the same transaction.
+    void enable_outbox() { outbox_enabled_ = true; }
+    // Hands the oldest pending events to `publish` and deletes them once it
+    // returns. Per-lot order only: see OutboxRelay. Only one instance relays at
+    // a time; returns the number of events published (0 if another instance
+    // holds the relay lock).
+    int relay_outbox(int batch_size, const std::function<void(const std::vector<OutboxEvent>&)>& publish);
+    nlohmann::json pool_stats() const;
+    nlohmann::json watchdog_stats() const;
+    // Shared with AsyncDatabase, so one thread cancels queries on both paths.
+    QueryWatchdog& watchdog() { return watchdog_; }
 
 private:
+    ConnectionPool::Lease acquire_connection();
+
     std::string connection_uri_;
+    ConnectionPool pool_;
+    QueryWatchdog watchdog_;
+    bool outbox_enabled_{false};
 };
 
@@ -0,0 +1,33 @@
+#include "database_common.h"
+
+#include <stdexcept>
+#include <thread>
+
+#include <pqxx/pqxx>
+
+#include "fault_injection.h"
+#include "request_context.h"
+
+void simulate_database_fault() {
+    auto fault = draw_fault(FaultTarget::Database);
+    if (fault.delay.count() == 0 && fault.outcome == FaultOutcome::None) {
+        return;
+    }
+    auto* context = current_request();
+    auto budget = context ? context->remaining() : std::nullopt;
+    if (budget && (fault.outcome == FaultOutcome::Timeout || fault.delay >= *budget)) {
+        std::this_thread::sleep_for(*budget);
+        throw DeadlineExceededError("Request deadline exceeded (injected database fault)");
+    }
+    std::this_thread::sleep_for(fault.delay);
+    switch (fault.outcome) {
+        case FaultOutcome::None:
+            return;
+        case FaultOutcome::Error:
+            throw std::runtime_error("Injected database error");
+        case FaultOutcome::Drop:
+            throw pqxx::broken_connection("Injected database connection drop");
+        case FaultOutcome::Timeout:
+            throw std::runtime_error("Injected database timeout");
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+
+#include "probes.h"
+
+// Pieces shared by Database and AsyncDatabase, so both read lots with the same
+// SQL and look the same to tracers and fault injection.
+
+// Lot metadata lives in `lots`; the bidding state that changes on every bid
+// lives in the narrow `lot_prices` table so bids do not rewrite lot rows.
+inline const std::string kLotColumns =
+    "l.id, l.name, l.description, l.start_price, p.current_price, l.owner_id, l.created_at, l.auction_end_date";
+inline const std::string kLotSource = "lots l LEFT JOIN lot_prices p ON p.lot_id = l.id";
+inline const std::string kArchiveColumns =
+    "id, name, description, start_price, current_price, owner_id, created_at, auction_end_date";
+
+// One lot by id ($1), falling back to the archive.
+inline const std::string kLotByIdQuery =
+    "SELECT " + kLotColumns + " FROM " + kLotSource + " WHERE l.id = $1"
+    " UNION ALL SELECT " + kArchiveColumns + " FROM lots_archive WHERE id = $1 LIMIT 1";
+
+// Fires db__start/db__end around a database method.
+class DbProbe {
+public:
+    DbProbe(const char* method, int lot_id) : method_(method), lot_id_(lot_id) {
+        AUCTION_PROBE2(db__start, method_, lot_id_);
+    }
+    ~DbProbe() { AUCTION_PROBE2(db__end, method_, lot_id_); }
+
+    DbProbe(const DbProbe&) = delete;
+    DbProbe& operator=(const DbProbe&) = delete;
+
+private:
+    const char* method_;
+    int lot_id_;
+};
+
+// Plays out an injected fault before a query, sleeping on the calling thread.
+// A timeout holds the call until the request deadline, as a hung query
+// cancelled by statement_timeout would.
+void simulate_database_fault();
@@ -0,0 +1,154 @@
+#include "epoch.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kQuiescent = ~0ULL;
+// Retired objects are collected in batches to amortise scanning the threads.
+constexpr std::size_t kCollectBatch = 64;
+
+struct alignas(64) ThreadRecord {
+    // Global epoch observed on entering the outermost guard, or kQuiescent.
+    std::atomic<std::uint64_t> epoch{kQuiescent};
+    std::atomic<bool> in_use{false};
+    ThreadRecord* next{nullptr};
+};
+
+struct Retired {
+    void* object;
+    void (*destroy)(void*);
+    std::uint64_t epoch;
+};
+
+alignas(64) std::atomic<std::uint64_t> g_epoch{0};
+// Records are never freed; a thread that exits hands its record to the next.
+std::atomic<ThreadRecord*> g_records{nullptr};
+
+std::mutex g_retired_mutex;
+std::vector<Retired> g_retired;
+// Collect once this many objects are pending. Reset after each collect so a
+// backlog that a long reader keeps alive is rescanned after another batch
+// rather than on exact multiples of the batch size.
+std::size_t g_collect_at = kCollectBatch;
+std::uint64_t g_freed = 0;
+
+ThreadRecord* claim_record() {
+    for (auto* record = g_records.load(std::memory_order_acquire); record; record = record->next) {
+        bool expected = false;
+        if (!record->in_use.load(std::memory_order_relaxed) &&
+            record->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return record;
+        }
+    }
+    auto* record = new ThreadRecord;
+    record->in_use.store(true, std::memory_order_relaxed);
+    record->next = g_records.load(std::memory_order_relaxed);
+    while (!g_records.compare_exchange_weak(record->next, record, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+    return record;
+}
+
+struct ThreadSlot {
+    ThreadRecord* record{nullptr};
+    unsigned depth{0};
+
+    ~ThreadSlot() {
+        if (record) {
+            record->in_use.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadSlot t_slot;
+
+// The epoch advances only when every active reader has observed the current
+// one, so an object retired in epoch e is unreachable once the epoch reaches
+// e + 2. Called with g_retired_mutex held.
+void collect() {
+    auto epoch = g_epoch.load(std::memory_order_seq_cst);
+    bool all_current = true;
+    for (auto* record = g_records.load(std::memory_order_acquire); record; record = record->next) {
+        auto observed = record->epoch.load(std::memory_order_seq_cst);
+        if (observed != kQuiescent && observed != epoch) {
+            all_current = false;
+            break;
+        }
+    }
+    if (all_current && g_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst)) {
+        ++epoch;
+    }
+
+    std::size_t freed = 0;
+    while (freed < g_retired.size() && g_retired[freed].epoch + 2 <= epoch) {
+        g_retired[freed].destroy(g_retired[freed].object);
+        ++freed;
+    }
+    g_retired.erase(g_retired.begin(), g_retired.begin() + static_cast<std::ptrdiff_t>(freed));
+    g_freed += freed;
+    g_collect_at = g_retired.size() + kCollectBatch;
+}
+
+} // namespace
+
+EpochGuard::EpochGuard() {
+    auto& slot = t_slot;
+    if (slot.depth++ > 0) {
+        return;
+    }
+    if (!slot.record) {
+        slot.record = claim_record();
+    }
+    // Publish, then confirm the epoch did not move in between; otherwise a
+    // collector could have advanced twice past a value this thread never
+    // announced while it was active.
+    auto epoch = g_epoch.load(std::memory_order_seq_cst);
+    for (;;) {
+        slot.record->epoch.store(epoch, std::memory_order_seq_cst);
+        auto current = g_epoch.load(std::memory_order_seq_cst);
+        if (current == epoch) {
+            break;
+        }
+        epoch = current;
+    }
+}
+
+EpochGuard::~EpochGuard() {
+    auto& slot = t_slot;
+    if (--slot.depth == 0) {
+        slot.record->epoch.store(kQuiescent, std::memory_order_release);
+    }
+}
+
+void epoch_retire(void* object, void (*destroy)(void*)) {
+    std::lock_guard<std::mutex> lock(g_retired_mutex);
+    g_retired.push_back(Retired{object, destroy, g_epoch.load(std::memory_order_seq_cst)});
+    if (g_retired.size() >= g_collect_at) {
+        collect();
+    }
+}
+
+std::uint64_t epoch_current() {
+    return g_epoch.load(std::memory_order_seq_cst);
+}
+
+bool epoch_passed(std::uint64_t epoch) {
+    return g_epoch.load(std::memory_order_seq_cst) >= epoch + 2;
+}
+
+nlohmann::json epoch_stats() {
+    std::lock_guard<std::mutex> lock(g_retired_mutex);
+    std::size_t threads = 0;
+    for (auto* record = g_records.load(std::memory_order_acquire); record; record = record->next) {
+        ++threads;
+    }
+    return nlohmann::json{
+        {"epoch", g_epoch.load(std::memory_order_relaxed)},
+        {"threads", threads},
+        {"retired_pending", g_retired.size()},
+        {"freed", g_freed}
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "json.hpp"
+
+// Epoch-based reclamation for data that is read without locks. A reader holds
+// an EpochGuard while it dereferences shared pointers; a writer that unlinks
+// an object hands it to epoch_retire(), and the object is freed only once
+// every guard that might still see it has been released. Entering and leaving
+// a guard touches only the calling thread's own record, so readers on
+// different cores never contend. Guards nest.
+class EpochGuard {
+public:
+    EpochGuard();
+    ~EpochGuard();
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+// `object` must already be unreachable for new readers. `destroy` runs on the
+// thread of a later epoch_retire() call.
+void epoch_retire(void* object, void (*destroy)(void*));
+
+template <typename T>
+void epoch_retire(T* object) {
+    epoch_retire(static_cast<void*>(object), [](void* retired) { delete static_cast<T*>(retired); });
+}
+
+// For state that cannot be handed to epoch_retire(), such as an index a
+// writer wants to reuse: anything unlinked before epoch_current() returned
+// `epoch` is out of every reader's reach once epoch_passed(epoch) is true.
+std::uint64_t epoch_current();
+bool epoch_passed(std::uint64_t epoch);
+
+nlohmann::json epoch_stats();
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cassert>
+#include <utility>
+#include <variant>
+
+template <typename E>
+class Unexpected {
+public:
+    explicit Unexpected(E error) : error_(std::move(error)) {}
+
+    E& error() & { return error_; }
+    E&& error() && { return std::move(error_); }
+
+private:
+    E error_;
+};
+
+// Holds either a value or an error, in the spirit of C++23 std::expected, so
+// that expected failures (bad input, business-rule rejections) are returned
+// rather than thrown. Accessing the wrong alternative is a programming error.
+template <typename T, typename E>
+class Expected {
+public:
+    Expected(T value) : storage_(std::in_place_index<0>, std::move(value)) {}
+    Expected(Unexpected<E> error) : storage_(std::in_place_index<1>, std::move(error).error()) {}
+
+    bool has_value() const noexcept { return storage_.index() == 0; }
+    explicit operator bool() const noexcept { return has_value(); }
+
+    T& value() & {
+        assert(has_value());
+        return *std::get_if<0>(&storage_);
+    }
+    const T& value() const& {
+        assert(has_value());
+        return *std::get_if<0>(&storage_);
+    }
+    T&& value() && {
+        assert(has_value());
+        return std::move(*std::get_if<0>(&storage_));
+    }
+    T& operator*() & { return value(); }
+    const T& operator*() const& { return value(); }
+    T* operator->() { return &value(); }
+    const T* operator->() const { return &value(); }
+
+    const E& error() const {
+        assert(!has_value());
+        return *std::get_if<1>(&storage_);
+    }
+
+private:
+    std::variant<T, E> storage_;
+};
@@ -0,0 +1,251 @@
+#include "fault_injection.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <random>
+
+namespace {
+
+enum class LatencyDistribution {
+    Fixed,
+    Uniform,
+    Exponential,
+    LogNormal
+};
+
+struct FaultRule {
+    LatencyDistribution distribution{LatencyDistribution::Fixed};
+    double latency_ms{0.0};
+    double latency_max_ms{0.0};
+    double latency_sigma{1.0};
+    double latency_rate{1.0};
+    double error_rate{0.0};
+    double drop_rate{0.0};
+    double timeout_rate{0.0};
+};
+
+constexpr std::size_t kTargetCount = static_cast<std::size_t>(FaultTarget::Count);
+constexpr const char* kTargetNames[kTargetCount] = {"database", "payment_service", "registry_service"};
+constexpr const char* kDistributionNames[] = {"fixed", "uniform", "exponential", "lognormal"};
+
+struct TargetState {
+    std::atomic<bool> active{false};
+    std::optional<FaultRule> rule;
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> delayed{0};
+    std::atomic<std::uint64_t> errors{0};
+    std::atomic<std::uint64_t> drops{0};
+    std::atomic<std::uint64_t> timeouts{0};
+};
+
+std::mutex rules_mutex;
+std::array<TargetState, kTargetCount> targets;
+
+nlohmann::json rule_to_json(const FaultRule& rule) {
+    return {
+        {"latency_distribution", kDistributionNames[static_cast<int>(rule.distribution)]},
+        {"latency_ms", rule.latency_ms},
+        {"latency_max_ms", rule.latency_max_ms},
+        {"latency_sigma", rule.latency_sigma},
+        {"latency_rate", rule.latency_rate},
+        {"error_rate", rule.error_rate},
+        {"drop_rate", rule.drop_rate},
+        {"timeout_rate", rule.timeout_rate}
+    };
+}
+
+Expected<FaultRule, std::string> parse_rule(const std::string& target, const nlohmann::json& value) {
+    if (!value.is_object()) {
+        return Unexpected("'" + target + "' must be an object");
+    }
+    FaultRule rule;
+    for (const auto& [key, field] : value.items()) {
+        const std::string where = target + "." + key;
+        if (key == "latency_distribution") {
+            if (!field.is_string()) {
+                return Unexpected("'" + where + "' must be a string");
+            }
+            auto name = field.get<std::string>();
+            auto it = std::find(std::begin(kDistributionNames), std::end(kDistributionNames), name);
+            if (it == std::end(kDistributionNames)) {
+                return Unexpected("'" + where + "' must be fixed, uniform, exponential or lognormal");
+            }
+            rule.distribution = static_cast<LatencyDistribution>(it - std::begin(kDistributionNames));
+            continue;
+        }
+        double* number = nullptr;
+        bool probability = key.size() > 5 && key.compare(key.size() - 5, 5, "_rate") == 0;
+        if (key == "latency_ms") {
+            number = &rule.latency_ms;
+        } else if (key == "latency_max_ms") {
+            number = &rule.latency_max_ms;
+        } else if (key == "latency_sigma") {
+            number = &rule.latency_sigma;
+        } else if (key == "latency_rate") {
+            number = &rule.latency_rate;
+        } else if (key == "error_rate") {
+            number = &rule.error_rate;
+        } else if (key == "drop_rate") {
+            number = &rule.drop_rate;
+        } else if (key == "timeout_rate") {
+            number = &rule.timeout_rate;
+        } else {
+            return Unexpected("Unknown fault setting '" + where + "'");
+        }
+        if (!field.is_number() || field.get<double>() < 0.0 || (probability && field.get<double>() > 1.0)) {
+            return Unexpected("'" + where + "' must be a number" + (probability ? " between 0 and 1" : " >= 0"));
+        }
+        *number = field.get<double>();
+    }
+    if (rule.error_rate + rule.drop_rate + rule.timeout_rate > 1.0) {
+        return Unexpected("'" + target + "' error, drop and timeout rates must add up to at most 1");
+    }
+    if (rule.distribution == LatencyDistribution::Uniform && rule.latency_max_ms < rule.latency_ms) {
+        return Unexpected("'" + target + ".latency_max_ms' must be at least latency_ms for uniform latency");
+    }
+    return rule;
+}
+
+#ifdef AUCTION_FAULT_INJECTION
+
+std::mt19937_64& thread_rng() {
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    return rng;
+}
+
+double draw_latency_ms(const FaultRule& rule, std::mt19937_64& rng) {
+    double latency = rule.latency_ms;
+    switch (rule.distribution) {
+        case LatencyDistribution::Fixed:
+            return latency;
+        case LatencyDistribution::Uniform:
+            return std::uniform_real_distribution<double>(rule.latency_ms, rule.latency_max_ms)(rng);
+        case LatencyDistribution::Exponential:
+            latency = rule.latency_ms > 0.0 ? std::exponential_distribution<double>(1.0 / rule.latency_ms)(rng) : 0.0;
+            break;
+        case LatencyDistribution::LogNormal:
+            latency = rule.latency_ms > 0.0
+                          ? std::lognormal_distribution<double>(std::log(rule.latency_ms), rule.latency_sigma)(rng)
+                          : 0.0;
+            break;
+    }
+    return rule.latency_max_ms > 0.0 ? std::min(latency, rule.latency_max_ms) : latency;
+}
+
+#endif
+
+} // namespace
+
+bool fault_injection_available() {
+#ifdef AUCTION_FAULT_INJECTION
+    return true;
+#else
+    return false;
+#endif
+}
+
+Expected<nlohmann::json, std::string> configure_faults(const nlohmann::json& config) {
+    if (!fault_injection_available()) {
+        return Unexpected(std::string("Built without AUCTION_FAULT_INJECTION"));
+    }
+    if (!config.is_object()) {
+        return Unexpected(std::string("Fault configuration must be a JSON object"));
+    }
+    std::array<std::optional<FaultRule>, kTargetCount> rules;
+    for (const auto& [key, value] : config.items()) {
+        auto name = std::find(std::begin(kTargetNames), std::end(kTargetNames), key);
+        if (name == std::end(kTargetNames)) {
+            return Unexpected("Unknown fault target '" + key + "'");
+        }
+        auto rule = parse_rule(key, value);
+        if (!rule) {
+            return Unexpected(rule.error());
+        }
+        rules[static_cast<std::size_t>(name - std::begin(kTargetNames))] = *rule;
+    }
+
+    std::lock_guard<std::mutex> lock(rules_mutex);
+    for (std::size_t i = 0; i < kTargetCount; ++i) {
+        targets[i].rule = rules[i];
+        targets[i].active.store(rules[i].has_value(), std::memory_order_release);
+    }
+    nlohmann::json active = nlohmann::json::object();
+    for (std::size_t i = 0; i < kTargetCount; ++i) {
+        if (rules[i]) {
+            active[kTargetNames[i]] = rule_to_json(*rules[i]);
+        }
+    }
+    return active;
+}
+
+void clear_faults() {
+    std::lock_guard<std::mutex> lock(rules_mutex);
+    for (auto& target : targets) {
+        target.rule.reset();
+        target.active.store(false, std::memory_order_release);
+    }
+}
+
+nlohmann::json fault_stats() {
+    nlohmann::json stats{{"available", fault_injection_available()}};
+    std::lock_guard<std::mutex> lock(rules_mutex);
+    for (std::size_t i = 0; i < kTargetCount; ++i) {
+        const auto& target = targets[i];
+        stats[kTargetNames[i]] = {
+            {"rule", target.rule ? rule_to_json(*target.rule) : nlohmann::json(nullptr)},
+            {"calls", target.calls.load(std::memory_order_relaxed)},
+            {"delayed", target.delayed.load(std::memory_order_relaxed)},
+            {"errors", target.errors.load(std::memory_order_relaxed)},
+            {"drops", target.drops.load(std::memory_order_relaxed)},
+            {"timeouts", target.timeouts.load(std::memory_order_relaxed)}
+        };
+    }
+    return stats;
+}
+
+#ifdef AUCTION_FAULT_INJECTION
+
+InjectedFault draw_fault(FaultTarget which) {
+    auto& target = targets[static_cast<std::size_t>(which)];
+    if (!target.active.load(std::memory_order_acquire)) {
+        return {};
+    }
+    std::optional<FaultRule> rule;
+    {
+        std::lock_guard<std::mutex> lock(rules_mutex);
+        rule = target.rule;
+    }
+    if (!rule) {
+        return {};
+    }
+    target.calls.fetch_add(1, std::memory_order_relaxed);
+
+    auto& rng = thread_rng();
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    InjectedFault fault;
+    if (unit(rng) < rule->latency_rate) {
+        fault.delay = std::chrono::milliseconds(std::llround(draw_latency_ms(*rule, rng)));
+        if (fault.delay.count() > 0) {
+            target.delayed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    double roll = unit(rng);
+    if (roll < rule->error_rate) {
+        fault.outcome = FaultOutcome::Error;
+        target.errors.fetch_add(1, std::memory_order_relaxed);
+    } else if (roll < rule->error_rate + rule->drop_rate) {
+        fault.outcome = FaultOutcome::Drop;
+        target.drops.fetch_add(1, std::memory_order_relaxed);
+    } else if (roll < rule->error_rate + rule->drop_rate + rule->timeout_rate) {
+        fault.outcome = FaultOutcome::Timeout;
+        target.timeouts.fetch_add(1, std::memory_order_relaxed);
+    }
+    return fault;
+}
+
+#endif
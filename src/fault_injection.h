@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "expected.h"
+#include "json.hpp"
+
+// Latency and failure injection around dependency calls, for measuring how
+// the service degrades when Postgres or the payment service misbehaves. Only
+// compiled in with AUCTION_FAULT_INJECTION; otherwise draw_fault() is an
+// inline no-op and configure_faults() refuses every configuration.
+
+enum class FaultTarget {
+    Database,
+    PaymentService,
+    RegistryService,
+    Count
+};
+
+enum class FaultOutcome {
+    None,
+    // The dependency answers with an error.
+    Error,
+    // The connection is lost before an answer arrives.
+    Drop,
+    // The dependency never answers; the caller waits out its own timeout.
+    Timeout
+};
+
+struct InjectedFault {
+    std::chrono::milliseconds delay{0};
+    FaultOutcome outcome{FaultOutcome::None};
+};
+
+bool fault_injection_available();
+
+// Replaces every rule. `config` maps "database", "payment_service" and
+// "registry_service" to an object with any of:
+//   latency_ms, latency_max_ms, latency_distribution ("fixed", "uniform",
+//   "exponential", "lognormal"), latency_sigma, latency_rate, error_rate,
+//   drop_rate, timeout_rate
+// For "uniform" latency_ms..latency_max_ms is the range; for "exponential" and
+// "lognormal" latency_ms is the mean and median, capped at latency_max_ms when
+// set. Rates are probabilities per call. Returns the configuration now in
+// effect, or why it was rejected.
+Expected<nlohmann::json, std::string> configure_faults(const nlohmann::json& config);
+void clear_faults();
+
+// Active rules and the number of faults injected per target.
+nlohmann::json fault_stats();
+
+#ifdef AUCTION_FAULT_INJECTION
+// Draws what should happen to one call to `target`. The caller sleeps for
+// `delay` and then simulates the outcome.
+InjectedFault draw_fault(FaultTarget target);
+#else
+inline InjectedFault draw_fault(FaultTarget) {
+    return {};
+}
+#endif
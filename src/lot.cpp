@@ -0,0 +1,31 @@
+#include "lot.h"
+
+namespace {
+
+template <typename T>
+nlohmann::json nullable(const std::optional<T>& value) {
+    return value ? nlohmann::json(*value) : nlohmann::json(nullptr);
+}
+
+} // namespace
+
+nlohmann::json lot_to_json(const Lot& lot) {
+    return nlohmann::json{
+        {"id", lot.id},
+        {"name", lot.name},
+        {"description", nullable(lot.description)},
+        {"start_price", lot.start_price},
+        {"current_price", nullable(lot.current_price)},
+        {"owner_id", nullable(lot.owner_id)},
+        {"created_at", lot.created_at},
+        {"auction_end_date", lot.auction_end_date}
+    };
+}
+
+nlohmann::json lots_to_json(const std::vector<Lot>& lots) {
+    nlohmann::json items = nlohmann::json::array();
+    for (const auto& lot : lots) {
+        items.push_back(lot_to_json(lot));
+    }
+    return items;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+// A lot as served by the API. Timestamps keep Postgres' text output so that
+// every encoding renders them identically.
+struct Lot {
+    int id{0};
+    std::string name;
+    std::optional<std::string> description;
+    double start_price{0.0};
+    std::optional<double> current_price;
+    std::optional<std::string> owner_id;
+    std::string created_at;
+    std::string auction_end_date;
+};
+
+nlohmann::json lot_to_json(const Lot& lot);
+nlohmann::json lots_to_json(const std::vector<Lot>& lots);
@@ -0,0 +1,815 @@
+#include "lot_cache.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+
+namespace {
+
+constexpr std::uint64_t kChunkBits = 22;
+constexpr std::uint64_t kOffsetBits = 20;
+constexpr std::uint64_t kLengthBits = 22;
+constexpr std::uint64_t kMicrosPerSecond = 1000000;
+constexpr std::size_t kCompactionMinGarbage = std::size_t{8} << 20;
+// Work one write does for a compaction in progress: index positions scanned,
+// entries moved and bytes of text copied, whichever limit is reached first.
+constexpr std::size_t kCompactionStepPositions = 256;
+constexpr std::size_t kCompactionStepLots = 16;
+constexpr std::size_t kCompactionStepBytes = std::size_t{64} << 10;
+
+ArenaRef make_ref(std::uint64_t chunk, std::uint64_t offset, std::uint64_t length) {
+    return ArenaRef{(chunk << (kOffsetBits + kLengthBits)) | (offset << kLengthBits) | length};
+}
+
+ArenaRef name_ref(const CompactLot& lot) {
+    ArenaRef ref;
+    std::memcpy(&ref.bits, lot.name.data, sizeof(ref.bits));
+    return ref;
+}
+
+std::uint32_t hash_id(std::int32_t id) {
+    auto x = static_cast<std::uint32_t>(id);
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+std::size_t index_size_for(std::size_t capacity) {
+    // Keep the load factor at or below three quarters so probe chains stay short.
+    std::size_t size = 16;
+    while (size * 3 < capacity * 4) {
+        size <<= 1;
+    }
+    return size;
+}
+
+// Howard Hinnant's days_from_civil / civil_from_days.
+std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const auto yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+void civil_from_days(std::int64_t z, std::int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const auto doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+bool read_digits(std::string_view text, std::size_t& pos, std::size_t count, int& value) {
+    if (pos + count > text.size()) {
+        return false;
+    }
+    value = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        char c = text[pos + i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + (c - '0');
+    }
+    pos += count;
+    return true;
+}
+
+bool expect(std::string_view text, std::size_t& pos, char c) {
+    if (pos >= text.size() || text[pos] != c) {
+        return false;
+    }
+    ++pos;
+    return true;
+}
+
+std::optional<std::int64_t> to_cents(double value) {
+    double cents = std::round(value * 100.0);
+    if (!(std::fabs(cents) < 9.0e15)) {
+        return std::nullopt;
+    }
+    return static_cast<std::int64_t>(cents);
+}
+
+} // namespace
+
+StringArena::~StringArena() {
+    // Retired chunks are freed by the epoch collector.
+    for (std::size_t i = 0; i < chunk_sizes_.size(); ++i) {
+        if (chunk_sizes_[i] != 0) {
+            delete[] chunks_.get(i);
+        }
+    }
+}
+
+std::optional<std::uint32_t> StringArena::new_chunk(std::size_t size) {
+    std::uint32_t index;
+    if (!retired_.empty() && epoch_passed(retired_.front().epoch)) {
+        index = retired_.front().index;
+        retired_.pop_front();
+        chunks_.set(index, new char[size]);
+        chunk_sizes_[index] = size;
+        chunk_sealed_[index] = false;
+    } else {
+        if (chunk_sizes_.size() >= (std::size_t{1} << kChunkBits) - 1) {
+            return std::nullopt;
+        }
+        index = static_cast<std::uint32_t>(chunk_sizes_.size());
+        chunks_.push_back(new char[size]);
+        chunk_sizes_.push_back(size);
+        chunk_used_.push_back(0);
+        chunk_sealed_.push_back(false);
+    }
+    reserved_ += size;
+    return index;
+}
+
+std::optional<ArenaRef> StringArena::append(std::string_view value) {
+    if (value.size() > kMaxLength) {
+        return std::nullopt;
+    }
+    if (value.empty()) {
+        return make_ref(0, 0, 0);
+    }
+    if (value.size() > kChunkSize) {
+        // Oversized strings get a dedicated chunk of their own.
+        auto chunk = new_chunk(value.size());
+        if (!chunk) {
+            return std::nullopt;
+        }
+        std::memcpy(chunks_.get(*chunk), value.data(), value.size());
+        chunk_used_[*chunk] = value.size();
+        used_ += value.size();
+        return make_ref(*chunk, 0, value.size());
+    }
+    if (tail_offset_ + value.size() > kChunkSize) {
+        auto chunk = new_chunk(kChunkSize);
+        if (!chunk) {
+            return std::nullopt;
+        }
+        tail_ = *chunk;
+        tail_offset_ = 0;
+    }
+    std::memcpy(chunks_.get(tail_) + tail_offset_, value.data(), value.size());
+    auto ref = make_ref(tail_, tail_offset_, value.size());
+    tail_offset_ += value.size();
+    chunk_used_[tail_] += value.size();
+    used_ += value.size();
+    return ref;
+}
+
+std::string_view StringArena::view(ArenaRef ref) const {
+    if (ref.is_null()) {
+        return {};
+    }
+    const auto chunk = ref.bits >> (kOffsetBits + kLengthBits);
+    const auto offset = (ref.bits >> kLengthBits) & ((1ULL << kOffsetBits) - 1);
+    const auto length = ref.bits & ((1ULL << kLengthBits) - 1);
+    if (length == 0) {
+        return {};
+    }
+    return {chunks_.get(chunk) + offset, length};
+}
+
+std::vector<std::uint32_t> StringArena::seal() {
+    std::vector<std::uint32_t> sealed;
+    for (std::size_t i = 0; i < chunk_sizes_.size(); ++i) {
+        if (chunk_sizes_[i] != 0 && !chunk_sealed_[i]) {
+            sealed.push_back(static_cast<std::uint32_t>(i));
+            chunk_sealed_[i] = true;
+        }
+    }
+    tail_offset_ = kChunkSize;
+    return sealed;
+}
+
+void StringArena::retire(const std::vector<std::uint32_t>& chunks) {
+    for (auto index : chunks) {
+        epoch_retire(chunks_.get(index), [](void* retired) { delete[] static_cast<char*>(retired); });
+        reserved_ -= chunk_sizes_[index];
+        used_ -= chunk_used_[index];
+        chunk_sizes_[index] = 0;
+        chunk_used_[index] = 0;
+        chunk_sealed_[index] = false;
+        // Read after epoch_retire, so the index is reused no earlier than the
+        // memory it named is freed.
+        retired_.push_back(RetiredChunk{index, epoch_current()});
+    }
+}
+
+bool StringArena::sealed(ArenaRef ref) const {
+    if (ref.is_null() || (ref.bits & ((1ULL << kLengthBits) - 1)) == 0) {
+        return false;
+    }
+    return chunk_sealed_[ref.bits >> (kOffsetBits + kLengthBits)];
+}
+
+std::size_t StringArena::bytes_reserved() const {
+    return reserved_ + chunks_.memory_usage() +
+           (chunk_sizes_.capacity() + chunk_used_.capacity()) * sizeof(std::size_t) +
+           retired_.size() * sizeof(RetiredChunk);
+}
+
+OwnerInterner::OwnerInterner() {
+    owners_.push_back({});
+}
+
+std::uint32_t OwnerInterner::intern(std::string_view owner) {
+    auto it = index_.find(owner);
+    if (it != index_.end()) {
+        return it->second;
+    }
+    auto ref = arena_.append(owner);
+    if (!ref) {
+        return 0;
+    }
+    auto stored = arena_.view(*ref);
+    auto index = static_cast<std::uint32_t>(owners_.size());
+    owners_.push_back(stored);
+    index_.emplace(stored, index);
+    return index;
+}
+
+std::size_t OwnerInterner::memory_usage() const {
+    // Rough per-node cost of the hash map: key, value, next pointer, cached hash.
+    constexpr std::size_t kNodeBytes = sizeof(std::string_view) + sizeof(std::uint32_t) + 2 * sizeof(void*);
+    return arena_.bytes_reserved() + owners_.memory_usage() + index_.size() * kNodeBytes +
+           index_.bucket_count() * sizeof(void*);
+}
+
+std::optional<std::int64_t> parse_pg_timestamp(std::string_view text, std::int16_t& offset_minutes) {
+    std::size_t pos = 0;
+    int year, month, day, hour, minute, second;
+    if (!read_digits(text, pos, 4, year) || !expect(text, pos, '-') || !read_digits(text, pos, 2, month) ||
+        !expect(text, pos, '-') || !read_digits(text, pos, 2, day) || !expect(text, pos, ' ') ||
+        !read_digits(text, pos, 2, hour) || !expect(text, pos, ':') || !read_digits(text, pos, 2, minute) ||
+        !expect(text, pos, ':') || !read_digits(text, pos, 2, second)) {
+        return std::nullopt;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return std::nullopt;
+    }
+
+    std::int64_t fraction = 0;
+    if (pos < text.size() && text[pos] == '.') {
+        ++pos;
+        std::size_t digits = 0;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+            if (++digits > 6) {
+                return std::nullopt;
+            }
+            fraction = fraction * 10 + (text[pos++] - '0');
+        }
+        if (digits == 0) {
+            return std::nullopt;
+        }
+        for (; digits < 6; ++digits) {
+            fraction *= 10;
+        }
+    }
+
+    if (pos >= text.size() || (text[pos] != '+' && text[pos] != '-')) {
+        return std::nullopt;
+    }
+    const int sign = text[pos++] == '-' ? -1 : 1;
+    int offset_hours = 0;
+    int offset_mins = 0;
+    if (!read_digits(text, pos, 2, offset_hours)) {
+        return std::nullopt;
+    }
+    if (pos < text.size() && text[pos] == ':') {
+        ++pos;
+        if (!read_digits(text, pos, 2, offset_mins)) {
+            return std::nullopt;
+        }
+    }
+    // Anything else (second-resolution offsets, " BC") is not representable.
+    if (pos != text.size()) {
+        return std::nullopt;
+    }
+
+    offset_minutes = static_cast<std::int16_t>(sign * (offset_hours * 60 + offset_mins));
+    const std::int64_t days = days_from_civil(year, static_cast<unsigned>(month), static_cast<unsigned>(day));
+    const std::int64_t local_seconds = days * 86400 + hour * 3600 + minute * 60 + second;
+    return (local_seconds - std::int64_t{offset_minutes} * 60) * static_cast<std::int64_t>(kMicrosPerSecond) +
+           fraction;
+}
+
+std::string format_pg_timestamp(std::int64_t micros, std::int16_t offset_minutes) {
+    std::int64_t local = micros + std::int64_t{offset_minutes} * 60 * static_cast<std::int64_t>(kMicrosPerSecond);
+    std::int64_t seconds = local / static_cast<std::int64_t>(kMicrosPerSecond);
+    std::int64_t fraction = local % static_cast<std::int64_t>(kMicrosPerSecond);
+    if (fraction < 0) {
+        fraction += kMicrosPerSecond;
+        --seconds;
+    }
+    std::int64_t days = seconds / 86400;
+    std::int64_t second_of_day = seconds % 86400;
+    if (second_of_day < 0) {
+        second_of_day += 86400;
+        --days;
+    }
+    std::int64_t year;
+    unsigned month, day;
+    civil_from_days(days, year, month, day);
+
+    char buffer[48];
+    int length = std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u %02lld:%02lld:%02lld",
+                               static_cast<long long>(year), month, day,
+                               static_cast<long long>(second_of_day / 3600),
+                               static_cast<long long>(second_of_day / 60 % 60),
+                               static_cast<long long>(second_of_day % 60));
+    std::string out(buffer, static_cast<std::size_t>(length));
+    if (fraction != 0) {
+        // Postgres trims trailing zeros from the fractional part.
+        std::snprintf(buffer, sizeof(buffer), ".%06lld", static_cast<long long>(fraction));
+        std::string digits(buffer);
+        digits.erase(digits.find_last_not_of('0') + 1);
+        out += digits;
+    }
+    const int abs_offset = offset_minutes < 0 ? -offset_minutes : offset_minutes;
+    std::snprintf(buffer, sizeof(buffer), "%c%02d", offset_minutes < 0 ? '-' : '+', abs_offset / 60);
+    out += buffer;
+    if (abs_offset % 60 != 0) {
+        std::snprintf(buffer, sizeof(buffer), ":%02d", abs_offset % 60);
+        out += buffer;
+    }
+    return out;
+}
+
+void StripedCounter::add() {
+    static std::atomic<std::size_t> next_stripe{0};
+    thread_local const std::size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % kStripes;
+    stripes_[stripe].value.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::uint64_t StripedCounter::load() const {
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < kStripes; ++i) {
+        total += stripes_[i].value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+LotCache::LotCache(std::size_t capacity)
+    : capacity_(capacity),
+      created_(std::chrono::steady_clock::now()),
+      index_(std::make_unique<std::atomic<const CompactLot*>[]>(index_size_for(capacity))),
+      index_mask_(index_size_for(capacity) - 1) {}
+
+LotCache::~LotCache() {
+    // No reader can outlive the cache, so versions are freed directly.
+    for (std::size_t i = 0; i <= index_mask_; ++i) {
+        delete index_[i].load(std::memory_order_relaxed);
+    }
+}
+
+const CompactLot* LotCache::find(std::int32_t id) const {
+    for (std::size_t i = hash_id(id) & index_mask_;; i = (i + 1) & index_mask_) {
+        const auto* lot = index_[i].load(std::memory_order_acquire);
+        if (!lot || lot->id == id) {
+            return lot;
+        }
+    }
+}
+
+std::size_t LotCache::find_position(std::int32_t id) const {
+    for (std::size_t i = hash_id(id) & index_mask_;; i = (i + 1) & index_mask_) {
+        const auto* lot = index_[i].load(std::memory_order_relaxed);
+        if (!lot) {
+            return kNotFound;
+        }
+        if (lot->id == id) {
+            return i;
+        }
+    }
+}
+
+void LotCache::insert(const CompactLot* lot) {
+    for (std::size_t i = hash_id(lot->id) & index_mask_;; i = (i + 1) & index_mask_) {
+        if (!index_[i].load(std::memory_order_relaxed)) {
+            index_[i].store(lot, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+void LotCache::replace_at(std::size_t position, Version version) {
+    const auto* previous = index_[position].load(std::memory_order_relaxed);
+    count_version(*previous, -1);
+    count_version(*version, 1);
+    release_strings(*previous, version.get());
+    index_[position].store(version.release(), std::memory_order_release);
+    epoch_retire(const_cast<CompactLot*>(previous));
+}
+
+void LotCache::remove_at(std::size_t position) {
+    const auto* removed = index_[position].load(std::memory_order_relaxed);
+    // Backward-shift deletion keeps probe chains intact without tombstones.
+    // Each entry is copied before its old position is cleared, so a
+    // concurrent reader can miss an entry that moves past it but never finds
+    // a wrong one.
+    std::size_t hole = position;
+    for (std::size_t next = (hole + 1) & index_mask_;; next = (next + 1) & index_mask_) {
+        const auto* lot = index_[next].load(std::memory_order_relaxed);
+        if (!lot) {
+            break;
+        }
+        const std::size_t home = hash_id(lot->id) & index_mask_;
+        const bool movable = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (movable) {
+            index_[hole].store(lot, std::memory_order_release);
+            hole = next;
+        }
+    }
+    index_[hole].store(nullptr, std::memory_order_release);
+    --live_;
+    count_version(*removed, -1);
+    release_strings(*removed, nullptr);
+    epoch_retire(const_cast<CompactLot*>(removed));
+}
+
+// Counts the arena text only `lot` used as garbage; text a replacement
+// version shares with it stays live.
+void LotCache::release_strings(const CompactLot& lot, const CompactLot* replacement) {
+    auto discard = [this](ArenaRef ref) {
+        const auto size = strings_.view(ref).size();
+        garbage_bytes_ += size;
+        if (strings_.sealed(ref)) {
+            sealed_garbage_bytes_ += size;
+        }
+    };
+    if (!lot.description.is_null() && !(replacement && replacement->description == lot.description)) {
+        discard(lot.description);
+    }
+    if (lot.name.length == InlineName::kOutOfLine &&
+        !(replacement && replacement->name.length == InlineName::kOutOfLine &&
+          name_ref(*replacement) == name_ref(lot))) {
+        discard(name_ref(lot));
+    }
+}
+
+void LotCache::count_version(const CompactLot& lot, int delta) {
+    if (in_arena(lot)) {
+        arena_lots_ += static_cast<std::size_t>(delta);
+    }
+    if (compacting_ && in_sealed(lot)) {
+        sealed_lots_ += static_cast<std::size_t>(delta);
+    }
+}
+
+bool LotCache::in_arena(const CompactLot& lot) const {
+    return !strings_.view(lot.description).empty() ||
+           (lot.name.length == InlineName::kOutOfLine && !strings_.view(name_ref(lot)).empty());
+}
+
+bool LotCache::in_sealed(const CompactLot& lot) const {
+    return strings_.sealed(lot.description) ||
+           (lot.name.length == InlineName::kOutOfLine && strings_.sealed(name_ref(lot)));
+}
+
+// CLOCK over index positions: recently read entries get a second chance.
+void LotCache::evict_one() {
+    for (;;) {
+        const auto position = clock_hand_;
+        clock_hand_ = (clock_hand_ + 1) & index_mask_;
+        const auto* lot = index_[position].load(std::memory_order_relaxed);
+        if (!lot) {
+            continue;
+        }
+        if (lot->referenced.exchange(0, std::memory_order_relaxed) == 0) {
+            remove_at(position);
+            ++evictions_;
+            return;
+        }
+    }
+}
+
+// Versions are immutable, so compaction seals the arena and re-encodes every
+// live version with text in it, copying the text to fresh chunks. That is
+// spread over later writes, a step each (see compact_step()); the sealed
+// chunks are retired as a whole once no version uses them.
+void LotCache::maybe_compact() {
+    if (!compacting_) {
+        if (garbage_bytes_ < kCompactionMinGarbage || garbage_bytes_ * 2 < strings_.bytes_used()) {
+            return;
+        }
+        // Everything written so far is sealed, so is all garbage and every
+        // version with arena text.
+        sealed_chunks_ = strings_.seal();
+        sealed_garbage_bytes_ = garbage_bytes_;
+        sealed_lots_ = arena_lots_;
+        compacting_ = true;
+    }
+    compact_step();
+}
+
+// Scans on from where the previous step stopped. Removals can shift an
+// unvisited entry back behind the cursor, so the scan wraps around until the
+// count of versions in sealed chunks reaches zero rather than stopping at the
+// end of the index.
+void LotCache::compact_step() {
+    std::size_t moved = 0;
+    std::size_t copied = 0;
+    for (std::size_t scanned = 0; sealed_lots_ > 0 && scanned < kCompactionStepPositions &&
+                                  moved < kCompactionStepLots && copied < kCompactionStepBytes;
+         ++scanned) {
+        const auto position = compact_cursor_;
+        const auto* lot = index_[position].load(std::memory_order_relaxed);
+        if (lot && in_sealed(*lot)) {
+            ++moved;
+            std::size_t string_bytes = 0;
+            auto version = encode(decode(*lot), nullptr, string_bytes);
+            copied += string_bytes;
+            if (!version) {
+                garbage_bytes_ += string_bytes;
+                // The next entry may have shifted into this position.
+                remove_at(position);
+                continue;
+            }
+            version->cached_at_s = lot->cached_at_s;
+            version->referenced.store(lot->referenced.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            replace_at(position, std::move(version));
+        }
+        compact_cursor_ = (compact_cursor_ + 1) & index_mask_;
+    }
+    if (sealed_lots_ > 0) {
+        return;
+    }
+    strings_.retire(sealed_chunks_);
+    sealed_chunks_.clear();
+    garbage_bytes_ -= sealed_garbage_bytes_;
+    sealed_garbage_bytes_ = 0;
+    compacting_ = false;
+    ++compactions_;
+}
+
+// Ages are in whole seconds, so the coarse clock (a few nanoseconds, ticking
+// every few milliseconds) is plenty; a precise read would dominate bid_state().
+// It is the same clock as steady_clock, only read at tick resolution.
+std::uint32_t LotCache::now_seconds() const {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return seconds_at(std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec))));
+}
+
+std::uint32_t LotCache::seconds_at(std::chrono::steady_clock::time_point time) const {
+    if (time <= created_) {
+        return 0;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(time - created_);
+    return static_cast<std::uint32_t>(elapsed.count());
+}
+
+std::string_view LotCache::name_of(const CompactLot& lot) const {
+    if (lot.name.length != InlineName::kOutOfLine) {
+        return {lot.name.data, lot.name.length};
+    }
+    return strings_.view(name_ref(lot));
+}
+
+// Text the previous version already holds is shared rather than appended
+// again, so a bid, which only changes the price, adds nothing to the arena.
+std::optional<ArenaRef> LotCache::store_string(std::string_view value, std::optional<ArenaRef> previous,
+                                               std::size_t& string_bytes) {
+    // Text in a sealed chunk is copied instead, or compaction could not finish.
+    if (previous && !strings_.sealed(*previous) && strings_.view(*previous) == value) {
+        return previous;
+    }
+    auto ref = strings_.append(value);
+    if (ref) {
+        string_bytes += value.size();
+    }
+    return ref;
+}
+
+LotCache::Version LotCache::encode(const Lot& lot, const CompactLot* previous, std::size_t& string_bytes) {
+    Version compact(new CompactLot);
+    string_bytes = 0;
+
+    const auto start_price = to_cents(lot.start_price);
+    if (!start_price) {
+        return nullptr;
+    }
+    compact->id = lot.id;
+    compact->start_price_cents = *start_price;
+
+    if (lot.current_price) {
+        auto cents = to_cents(*lot.current_price);
+        if (!cents) {
+            return nullptr;
+        }
+        compact->current_price_cents = *cents;
+    }
+
+    auto created_at = parse_pg_timestamp(lot.created_at, compact->created_at_offset_min);
+    auto auction_end = parse_pg_timestamp(lot.auction_end_date, compact->auction_end_offset_min);
+    if (!created_at || !auction_end) {
+        return nullptr;
+    }
+    compact->created_at_us = *created_at;
+    compact->auction_end_us = *auction_end;
+
+    // Timestamps must round-trip byte for byte, otherwise serve from the database.
+    if (format_pg_timestamp(compact->created_at_us, compact->created_at_offset_min) != lot.created_at ||
+        format_pg_timestamp(compact->auction_end_us, compact->auction_end_offset_min) != lot.auction_end_date) {
+        return nullptr;
+    }
+
+    if (lot.owner_id) {
+        compact->owner = owners_.intern(*lot.owner_id);
+        if (compact->owner == 0) {
+            return nullptr;
+        }
+    }
+
+    const auto& name = lot.name;
+    if (name.size() <= InlineName::kMaxInline) {
+        std::memcpy(compact->name.data, name.data(), name.size());
+        compact->name.length = static_cast<std::uint8_t>(name.size());
+    } else {
+        std::optional<ArenaRef> previous_ref;
+        if (previous && previous->name.length == InlineName::kOutOfLine) {
+            previous_ref = name_ref(*previous);
+        }
+        auto ref = store_string(name, previous_ref, string_bytes);
+        if (!ref) {
+            return nullptr;
+        }
+        std::memcpy(compact->name.data, &ref->bits, sizeof(ref->bits));
+        compact->name.length = InlineName::kOutOfLine;
+    }
+
+    if (lot.description) {
+        std::optional<ArenaRef> previous_ref;
+        if (previous && !previous->description.is_null()) {
+            previous_ref = previous->description;
+        }
+        auto ref = store_string(*lot.description, previous_ref, string_bytes);
+        if (!ref) {
+            return nullptr;
+        }
+        compact->description = *ref;
+    }
+    compact->cached_at_s = now_seconds();
+    return compact;
+}
+
+Lot LotCache::decode(const CompactLot& lot) const {
+    Lot out;
+    out.id = lot.id;
+    out.name = name_of(lot);
+    if (!lot.description.is_null()) {
+        out.description = std::string(strings_.view(lot.description));
+    }
+    out.start_price = static_cast<double>(lot.start_price_cents) / 100.0;
+    if (lot.current_price_cents != CompactLot::kNullPrice) {
+        out.current_price = static_cast<double>(lot.current_price_cents) / 100.0;
+    }
+    if (lot.owner != 0) {
+        out.owner_id = std::string(owners_.lookup(lot.owner));
+    }
+    out.created_at = format_pg_timestamp(lot.created_at_us, lot.created_at_offset_min);
+    out.auction_end_date = format_pg_timestamp(lot.auction_end_us, lot.auction_end_offset_min);
+    return out;
+}
+
+bool LotCache::put(const Lot& lot) {
+    if (capacity_ == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto position = find_position(lot.id);
+    const auto* previous = position == kNotFound ? nullptr : index_[position].load(std::memory_order_relaxed);
+    std::size_t string_bytes = 0;
+    auto version = encode(lot, previous, string_bytes);
+    if (!version) {
+        // Strings appended before encoding failed are unreachable now.
+        garbage_bytes_ += string_bytes;
+        if (previous) {
+            remove_at(position);
+        }
+        maybe_compact();
+        return false;
+    }
+
+    if (previous) {
+        replace_at(position, std::move(version));
+    } else {
+        if (live_ >= capacity_) {
+            evict_one();
+        }
+        count_version(*version, 1);
+        insert(version.release());
+        ++live_;
+    }
+    maybe_compact();
+    return true;
+}
+
+bool LotCache::refresh(const Lot& lot, std::chrono::steady_clock::time_point read_started) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto position = find_position(lot.id);
+    if (position == kNotFound) {
+        return false;
+    }
+    // Entries are stamped in whole seconds from the coarse clock, so one
+    // stored within a second before the read began also counts as newer; it
+    // was only just written anyway.
+    const auto* current = index_[position].load(std::memory_order_relaxed);
+    if (current->cached_at_s + 1 >= seconds_at(read_started)) {
+        return false;
+    }
+    std::size_t string_bytes = 0;
+    auto version = encode(lot, current, string_bytes);
+    if (!version) {
+        garbage_bytes_ += string_bytes;
+        remove_at(position);
+        maybe_compact();
+        return false;
+    }
+    replace_at(position, std::move(version));
+    maybe_compact();
+    return true;
+}
+
+std::optional<CachedLot> LotCache::get(int lot_id) const {
+    EpochGuard guard;
+    const auto* lot = find(lot_id);
+    if (!lot) {
+        misses_.add();
+        return std::nullopt;
+    }
+    hits_.add();
+    if (lot->referenced.load(std::memory_order_relaxed) == 0) {
+        lot->referenced.store(1, std::memory_order_relaxed);
+    }
+    const auto now = now_seconds();
+    const auto age = now >= lot->cached_at_s ? now - lot->cached_at_s : 0;
+    return CachedLot{decode(*lot), std::chrono::seconds(age)};
+}
+
+std::optional<CachedBidState> LotCache::bid_state(int lot_id) const {
+    EpochGuard guard;
+    const auto* lot = find(lot_id);
+    if (!lot) {
+        return std::nullopt;
+    }
+    auto price = lot->current_price_cents == CompactLot::kNullPrice ? lot->start_price_cents : lot->current_price_cents;
+    const auto now = now_seconds();
+    const auto age = now >= lot->cached_at_s ? now - lot->cached_at_s : 0;
+    return CachedBidState{price, lot->auction_end_us, std::chrono::seconds(age)};
+}
+
+void LotCache::erase(int lot_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto position = find_position(lot_id);
+    if (position != kNotFound) {
+        remove_at(position);
+        maybe_compact();
+    }
+}
+
+std::size_t LotCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return live_;
+}
+
+std::size_t LotCache::memory_usage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (index_mask_ + 1) * sizeof(std::atomic<const CompactLot*>) + live_ * sizeof(CompactLot) +
+           strings_.bytes_reserved() + owners_.memory_usage();
+}
+
+nlohmann::json LotCache::stats() const {
+    const auto bytes = memory_usage();
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {
+        {"capacity", capacity_},
+        {"size", live_},
+        {"hits", hits_.load()},
+        {"misses", misses_.load()},
+        {"evictions", evictions_},
+        {"compactions", compactions_},
+        {"distinct_owners", owners_.size()},
+        {"string_bytes_live", strings_.bytes_used() - garbage_bytes_},
+        {"string_bytes_garbage", garbage_bytes_},
+        {"compaction_pending_lots", sealed_lots_},
+        {"memory_bytes", bytes},
+        {"bytes_per_lot", live_ == 0 ? 0.0 : static_cast<double>(bytes) / static_cast<double>(live_)},
+        {"epoch", epoch_stats()},
+    };
+}
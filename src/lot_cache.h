@@ -0,0 +1,304 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "epoch.h"
+#include "json.hpp"
+#include "lot.h"
+
+// Array grown and updated by one writer at a time (callers serialise writes)
+// while readers index it without locks from inside an EpochGuard. Growing
+// publishes a copy and retires the old storage. T must be trivially copyable.
+template <typename T>
+class EpochArray {
+public:
+    EpochArray() = default;
+    ~EpochArray() { delete[] items_.load(std::memory_order_relaxed); }
+
+    EpochArray(const EpochArray&) = delete;
+    EpochArray& operator=(const EpochArray&) = delete;
+
+    T get(std::size_t index) const { return items_.load(std::memory_order_acquire)[index]; }
+
+    // Writer side. An element may only be overwritten once no reader can be
+    // looking it up any more.
+    std::size_t size() const { return size_; }
+    void set(std::size_t index, T value) { items_.load(std::memory_order_relaxed)[index] = value; }
+    void push_back(T value);
+    std::size_t memory_usage() const { return capacity_ * sizeof(T); }
+
+private:
+    std::atomic<T*> items_{nullptr};
+    std::size_t size_{0};
+    std::size_t capacity_{0};
+};
+
+template <typename T>
+void EpochArray<T>::push_back(T value) {
+    auto* items = items_.load(std::memory_order_relaxed);
+    if (size_ == capacity_) {
+        const std::size_t capacity = capacity_ == 0 ? 16 : capacity_ * 2;
+        auto* grown = new T[capacity];
+        std::copy(items, items + size_, grown);
+        items_.store(grown, std::memory_order_release);
+        if (items) {
+            epoch_retire(items, [](void* retired) { delete[] static_cast<T*>(retired); });
+        }
+        items = grown;
+        capacity_ = capacity;
+    }
+    items[size_++] = value;
+}
+
+// Reference to a string stored in a StringArena: chunk index (22 bits),
+// offset within the chunk (20 bits) and length (22 bits).
+struct ArenaRef {
+    static constexpr std::uint64_t kNull = ~0ULL;
+
+    std::uint64_t bits{kNull};
+
+    bool is_null() const { return bits == kNull; }
+    bool operator==(const ArenaRef& other) const { return bits == other.bits; }
+};
+
+// Append-only string storage made of 1 MiB chunks. Appends are serialised by
+// the caller; view() needs no lock, only an EpochGuard. Strings are never
+// moved: compaction copies the live ones into fresh chunks (see seal()) and
+// retires the old chunks, whose memory and indices are reused once no reader
+// can still reach them.
+class StringArena {
+public:
+    static constexpr std::size_t kChunkSize = std::size_t{1} << 20;
+    static constexpr std::size_t kMaxLength = (std::size_t{1} << 22) - 1;
+
+    StringArena() = default;
+    ~StringArena();
+
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    std::optional<ArenaRef> append(std::string_view value);
+    std::string_view view(ArenaRef ref) const;
+
+    // Sends later appends to fresh chunks and returns the chunks written so
+    // far, to be passed to retire() once nothing references them.
+    std::vector<std::uint32_t> seal();
+    void retire(const std::vector<std::uint32_t>& chunks);
+    // Whether a non-empty string lies in a chunk sealed and not yet retired.
+    bool sealed(ArenaRef ref) const;
+
+    std::size_t bytes_reserved() const;
+    std::size_t bytes_used() const { return used_; }
+
+private:
+    struct RetiredChunk {
+        std::uint32_t index;
+        std::uint64_t epoch;
+    };
+
+    std::optional<std::uint32_t> new_chunk(std::size_t size);
+
+    EpochArray<char*> chunks_;
+    // Writer-side bookkeeping, indexed like chunks_; a size of 0 marks a
+    // retired chunk.
+    std::vector<std::size_t> chunk_sizes_;
+    std::vector<std::size_t> chunk_used_;
+    std::vector<bool> chunk_sealed_;
+    std::deque<RetiredChunk> retired_;
+    std::uint32_t tail_{0};
+    std::size_t tail_offset_{kChunkSize};
+    std::size_t used_{0};
+    std::size_t reserved_{0};
+};
+
+// Maps repeated owner ids to small integers; index 0 means "no owner".
+// lookup() needs no lock, only an EpochGuard, and the views it returns stay
+// valid for the interner's lifetime.
+class OwnerInterner {
+public:
+    OwnerInterner();
+
+    std::uint32_t intern(std::string_view owner);
+    std::string_view lookup(std::uint32_t index) const { return owners_.get(index); }
+
+    std::size_t size() const { return owners_.size() - 1; }
+    std::size_t memory_usage() const;
+
+private:
+    StringArena arena_;
+    EpochArray<std::string_view> owners_;
+    std::unordered_map<std::string_view, std::uint32_t> index_;
+};
+
+// Names up to 22 bytes are stored inline; longer names go to the arena.
+struct InlineName {
+    static constexpr std::uint8_t kMaxInline = 22;
+    static constexpr std::uint8_t kOutOfLine = 0xFF;
+
+    char data[kMaxInline]{};
+    std::uint8_t length{0};
+};
+
+// Immutable, fixed-width cached lot. Prices are in cents, timestamps in
+// microseconds since the Unix epoch plus the UTC offset Postgres rendered them
+// with, so the original text can be reproduced exactly.
+struct CompactLot {
+    static constexpr std::int64_t kNullPrice = INT64_MIN;
+
+    std::int64_t start_price_cents{0};
+    std::int64_t current_price_cents{kNullPrice};
+    std::int64_t created_at_us{0};
+    std::int64_t auction_end_us{0};
+    ArenaRef description;
+    std::int32_t id{0};
+    std::uint32_t owner{0};
+    std::int16_t created_at_offset_min{0};
+    std::int16_t auction_end_offset_min{0};
+    InlineName name;
+    // CLOCK bit, the one field readers write. Only set when clear, so hot
+    // lots do not bounce the cache line between readers.
+    mutable std::atomic<std::uint8_t> referenced{1};
+    // Seconds since the cache was created.
+    std::uint32_t cached_at_s{0};
+};
+
+// Timestamps in Postgres' default text output ("2024-05-01 12:34:56.5+00").
+std::optional<std::int64_t> parse_pg_timestamp(std::string_view text, std::int16_t& offset_minutes);
+std::string format_pg_timestamp(std::int64_t micros, std::int16_t offset_minutes);
+
+struct CachedLot {
+    Lot lot;
+    // Time since the entry was last stored from the database.
+    std::chrono::seconds age{0};
+};
+
+struct CachedBidState {
+    // Current price, or the start price before the first bid.
+    std::int64_t price_cents{0};
+    std::int64_t auction_end_us{0};
+    // Time since the entry was last stored from the database.
+    std::chrono::seconds age{0};
+};
+
+// Counter incremented from many threads, striped across cache lines so that
+// concurrent increments do not contend.
+class StripedCounter {
+public:
+    void add();
+    std::uint64_t load() const;
+
+private:
+    static constexpr std::size_t kStripes = 64;
+
+    struct alignas(64) Stripe {
+        std::atomic<std::uint64_t> value{0};
+    };
+
+    std::unique_ptr<Stripe[]> stripes_{std::make_unique<Stripe[]>(kStripes)};
+};
+
+// In-process lot cache. Readers never lock: they probe an index of atomic
+// pointers to immutable CompactLot versions under an EpochGuard. Writers are
+// serialised by a mutex, publish a replacement version with a single atomic
+// store and retire the old one, which is freed once no reader can hold it.
+// Long names and descriptions live in a shared arena and owners are interned,
+// so a version is a fixed 80 bytes; a replacement that keeps the same text
+// reuses its arena references, so bids leave no string garbage behind.
+// Once garbage outweighs live text the arena is sealed and compacted
+// incrementally: each write moves a bounded number of entries' text to fresh
+// chunks, and the sealed chunks are retired when none is left in them.
+// A lookup racing with the removal of another entry may miss (and fall back
+// to the database) but never sees a torn or freed lot. Capacity is fixed;
+// when full, entries are evicted with the CLOCK algorithm.
+class LotCache {
+public:
+    explicit LotCache(std::size_t capacity);
+    ~LotCache();
+
+    LotCache(const LotCache&) = delete;
+    LotCache& operator=(const LotCache&) = delete;
+
+    // Stores a lot as produced by Database. Returns false if the
+    // lot cannot be represented compactly (e.g. an unparseable timestamp).
+    bool put(const Lot& lot);
+    // Replaces a cached lot read from the database at or after `read_started`,
+    // unless the entry was stored since then (a newer write wins) or is gone.
+    bool refresh(const Lot& lot, std::chrono::steady_clock::time_point read_started);
+    std::optional<CachedLot> get(int lot_id) const;
+    // What a bid needs to know about a cached lot, without decoding the rest
+    // of it. Does not count as a hit or a miss.
+    std::optional<CachedBidState> bid_state(int lot_id) const;
+    void erase(int lot_id);
+
+    std::size_t size() const;
+    std::size_t capacity() const { return capacity_; }
+    std::size_t memory_usage() const;
+    nlohmann::json stats() const;
+
+private:
+    using Version = std::unique_ptr<CompactLot>;
+
+    static constexpr std::size_t kNotFound = ~std::size_t{0};
+
+    Version encode(const Lot& lot, const CompactLot* previous, std::size_t& string_bytes);
+    Lot decode(const CompactLot& lot) const;
+    std::string_view name_of(const CompactLot& lot) const;
+    std::optional<ArenaRef> store_string(std::string_view value, std::optional<ArenaRef> previous,
+                                         std::size_t& string_bytes);
+
+    const CompactLot* find(std::int32_t id) const;
+    std::size_t find_position(std::int32_t id) const;
+    void insert(const CompactLot* lot);
+    void replace_at(std::size_t position, Version version);
+    void remove_at(std::size_t position);
+    void release_strings(const CompactLot& lot, const CompactLot* replacement);
+    void count_version(const CompactLot& lot, int delta);
+    bool in_arena(const CompactLot& lot) const;
+    bool in_sealed(const CompactLot& lot) const;
+    void evict_one();
+    void maybe_compact();
+    void compact_step();
+    std::uint32_t now_seconds() const;
+    std::uint32_t seconds_at(std::chrono::steady_clock::time_point time) const;
+
+    std::size_t capacity_;
+    std::chrono::steady_clock::time_point created_;
+
+    // Open addressing with linear probing; entries are null or a live version.
+    std::unique_ptr<std::atomic<const CompactLot*>[]> index_;
+    std::size_t index_mask_;
+
+    // Writers hold mutex_ for everything below; readers only look strings up
+    // in strings_ and owners_.
+    mutable std::mutex mutex_;
+    std::size_t clock_hand_{0};
+    std::size_t live_{0};
+    StringArena strings_;
+    std::size_t garbage_bytes_{0};
+    // Live versions with text in the arena, and of those the ones whose text
+    // is still in chunks sealed by the compaction in progress.
+    std::size_t arena_lots_{0};
+    std::size_t sealed_lots_{0};
+    bool compacting_{false};
+    std::vector<std::uint32_t> sealed_chunks_;
+    std::size_t sealed_garbage_bytes_{0};
+    std::size_t compact_cursor_{0};
+    OwnerInterner owners_;
+    std::uint64_t evictions_{0};
+    std::uint64_t compactions_{0};
+
+    mutable StripedCounter hits_;
+    mutable StripedCounter misses_;
+};
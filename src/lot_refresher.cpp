@@ -0,0 +1,125 @@
+#include "lot_refresher.h"
+
+#include <algorithm>
+#include <iostream>
+
+LotRefresher::LotRefresher(Database& database, LotCache& cache, RefresherSettings settings)
+    : database_(database), cache_(cache), settings_(settings) {}
+
+LotRefresher::~LotRefresher() {
+    stop();
+}
+
+void LotRefresher::start() {
+    if (worker_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+    }
+    worker_ = std::thread([this] { run(); });
+}
+
+void LotRefresher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void LotRefresher::request(int lot_id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stale_reads_;
+        if (pending_.count(lot_id) > 0) {
+            return;
+        }
+        if (queue_.size() >= settings_.max_pending) {
+            ++dropped_;
+            return;
+        }
+        pending_.insert(lot_id);
+        queue_.push_back(lot_id);
+        ++requested_;
+    }
+    wake_.notify_all();
+}
+
+bool LotRefresher::failing() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failing_;
+}
+
+bool LotRefresher::wait_for(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return !wake_.wait_for(lock, duration, [this] { return stopping_; });
+}
+
+void LotRefresher::run() {
+    auto backoff = settings_.retry_initial;
+    for (;;) {
+        int lot_id = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            lot_id = queue_.front();
+            queue_.pop_front();
+        }
+
+        bool ok = true;
+        try {
+            const auto read_started = std::chrono::steady_clock::now();
+            if (auto lot = database_.get_lot_by_id(lot_id)) {
+                // A write that landed while the read was in flight is newer; keep it.
+                cache_.refresh(*lot, read_started);
+            } else {
+                cache_.erase(lot_id);
+            }
+        } catch (const std::exception& ex) {
+            ok = false;
+            std::cerr << "Refreshing cached lot " << lot_id << " failed: " << ex.what() << std::endl;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            failing_ = !ok;
+            if (ok) {
+                pending_.erase(lot_id);
+                ++refreshed_;
+            } else {
+                // Still pending: retry it after everything already queued.
+                queue_.push_back(lot_id);
+                ++failures_;
+            }
+        }
+        if (ok) {
+            backoff = settings_.retry_initial;
+        } else {
+            if (!wait_for(backoff)) {
+                return;
+            }
+            backoff = std::min(backoff * 2, settings_.retry_max);
+        }
+    }
+}
+
+nlohmann::json LotRefresher::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nlohmann::json{
+        {"pending", pending_.size()},
+        {"stale_reads", stale_reads_},
+        {"requested", requested_},
+        {"dropped", dropped_},
+        {"refreshed", refreshed_},
+        {"failures", failures_},
+        {"failing", failing_}
+    };
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include "database.h"
+#include "json.hpp"
+#include "lot_cache.h"
+
+struct RefresherSettings {
+    std::size_t max_pending{10000};
+    std::chrono::milliseconds retry_initial{250};
+    std::chrono::milliseconds retry_max{10000};
+};
+
+// Reloads stale lot cache entries in the background so reads can be served
+// from the cache while the database is slow or failing over. Requests are
+// deduplicated per lot; a failed reload goes back on the queue and the
+// refresher backs off exponentially, so an outage costs one probe query per
+// backoff interval rather than one per read.
+class LotRefresher {
+public:
+    LotRefresher(Database& database, LotCache& cache, RefresherSettings settings = {});
+    ~LotRefresher();
+
+    LotRefresher(const LotRefresher&) = delete;
+    LotRefresher& operator=(const LotRefresher&) = delete;
+
+    void start();
+    void stop();
+
+    // Records a stale read of `lot_id` and queues a reload unless one is
+    // already pending or the queue is full.
+    void request(int lot_id);
+    // True when the most recent reload attempt failed.
+    bool failing() const;
+
+    nlohmann::json stats() const;
+
+private:
+    void run();
+    bool wait_for(std::chrono::milliseconds duration);
+
+    Database& database_;
+    LotCache& cache_;
+    RefresherSettings settings_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<int> queue_;
+    std::unordered_set<int> pending_;
+    bool stopping_{false};
+    bool failing_{false};
+    std::uint64_t stale_reads_{0};
+    std::uint64_t requested_{0};
+    std::uint64_t dropped_{0};
+    std::uint64_t refreshed_{0};
+    std::uint64_t failures_{0};
+    std::thread worker_;
+};
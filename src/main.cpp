@@ -1,15 +1,44 @@
+#include <openssl/crypto.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <ctime>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "access_log.h"
+#include "allocator.h"
+#include "archiver.h"
+#include "async_database.h"
+#include "bulkhead.h"
+#include "config.h"
 #include "database.h"
+#include "expected.h"
+#include "fault_injection.h"
 #include "httplib.h"
 #include "json.hpp"
+#include "lot_cache.h"
+#include "lot_refresher.h"
+#include "metrics.h"
+#include "outbox_relay.h"
+#include "probes.h"
+#include "profiler.h"
+#include "request_context.h"
+#include "token_verifier.h"
+#include "wire_format.h"
 
 using json = nlohmann::json;
 
@@ -17,10 +46,14 @@ namespace {
 
 const std::string kServiceName = "AuctionService";
 
-std::string require_env(const char* name) {
-    const char* value = std::getenv(name);
-    if (!value || std::string(value).empty()) {
-        throw std::runtime_error(std::string("Missing environment variable: ") + name);
+// Parses the whole of `text` as a decimal integer without throwing.
+template <typename T>
+std::optional<T> parse_integer(std::string_view text) {
+    T value{};
+    const char* end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    if (ec != std::errc() || ptr != end) {
+        return std::nullopt;
     }
     return value;
 }
@@ -29,11 +62,22 @@ std::optional<int> parse_path_id(const httplib::Request& req) {
     if (req.matches.size() < 2) {
         return std::nullopt;
     }
-    try {
-        return std::stoi(req.matches[1]);
-    } catch (...) {
-        return std::nullopt;
+    return parse_integer<int>(req.matches.str(1));
+}
+
+// Plays out an injected fault for an HTTP dependency call and returns the
+// outcome to simulate in place of a real response.
+FaultOutcome simulate_http_fault(FaultTarget target, std::chrono::milliseconds timeout) {
+    auto fault = draw_fault(target);
+    if (fault.delay.count() == 0 && fault.outcome == FaultOutcome::None) {
+        return FaultOutcome::None;
     }
+    if (fault.outcome == FaultOutcome::Timeout || fault.delay >= timeout) {
+        std::this_thread::sleep_for(timeout);
+        return FaultOutcome::Timeout;
+    }
+    std::this_thread::sleep_for(fault.delay);
+    return fault.outcome;
 }
 
 struct TokenValidationResult {
@@ -44,16 +88,17 @@ struct TokenValidationResult {
 
 TokenValidationResult check_token(const std::string& payment_service_url,
                                   const std::string& method_name,
-                                  const std::string& token) {
+                                  const std::string& token,
+                                  std::chrono::milliseconds timeout) {
     if (payment_service_url.empty()) {
         return {false, 500, "Payment service URL is not configured"};
     }
 
     httplib::Client client(payment_service_url.c_str());
     client.set_keep_alive(true);
-    client.set_connection_timeout(5, 0);
-    client.set_read_timeout(5, 0);
-    client.set_write_timeout(5, 0);
+    client.set_connection_timeout(timeout);
+    client.set_read_timeout(timeout);
+    client.set_write_timeout(timeout);
 
     json payload{
         {"token", token},
@@ -61,6 +106,16 @@ TokenValidationResult check_token(const std::string& payment_service_url,
         {"methodName", method_name}
     };
 
+    switch (simulate_http_fault(FaultTarget::PaymentService, timeout)) {
+        case FaultOutcome::None:
+            break;
+        case FaultOutcome::Error:
+            return {false, 502, "Payment service error"};
+        case FaultOutcome::Drop:
+        case FaultOutcome::Timeout:
+            return {false, 502, "Payment service unavailable"};
+    }
+
     try {
         auto response = client.Post("/token/check", payload.dump(), "application/json");
         if (!response) {
@@ -75,9 +130,12 @@ TokenValidationResult check_token(const std::string& payment_service_url,
         if (response->status >= 400) {
             return {false, 403, "Token validation failed"};
         }
-        auto body = json::parse(response->body, nullptr, true, true);
-        bool allowed = body.value("allowed", false);
-        if (!allowed) {
+        auto body = json::parse(response->body, nullptr, false, true);
+        if (body.is_discarded()) {
+            return {false, 502, "Payment service returned invalid JSON"};
+        }
+        auto allowed = body.is_object() ? body.find("allowed") : body.end();
+        if (allowed == body.end() || !allowed->is_boolean() || !allowed->get<bool>()) {
             return {false, 403, "Access denied"};
         }
         return {true, 200, "Allowed"};
@@ -86,38 +144,73 @@ TokenValidationResult check_token(const std::string& payment_service_url,
     }
 }
 
-std::optional<std::string> extract_bearer_token(const httplib::Request& req, std::string& error_message) {
+// Maps the local verdict on a signed token to a validation result, or returns
+// std::nullopt when the payment service has to decide.
+std::optional<TokenValidationResult> signed_token_validation(const SignedTokenResult& result) {
+    switch (result.status) {
+        case SignedTokenStatus::NotSigned:
+        case SignedTokenStatus::Unverifiable:
+            return std::nullopt;
+        case SignedTokenStatus::Valid:
+            return TokenValidationResult{true, 200, result.message};
+        case SignedTokenStatus::WrongService:
+        case SignedTokenStatus::MethodNotAllowed:
+            return TokenValidationResult{false, 403, result.message};
+        default:
+            return TokenValidationResult{false, 401, result.message};
+    }
+}
+
+TokenKeys token_keys_from(const RuntimeSettings& runtime) {
+    return TokenKeys{runtime.token_hmac_secret, runtime.token_ed25519_public_key};
+}
+
+enum class TokenError {
+    MissingHeader,
+    WrongScheme,
+    Empty,
+};
+
+Expected<std::string, TokenError> extract_bearer_token(const httplib::Request& req) {
     auto header = req.get_header_value("Authorization");
     if (header.empty()) {
-        error_message = "Authorization header is required";
-        return std::nullopt;
+        return Unexpected(TokenError::MissingHeader);
     }
     const std::string prefix = "Bearer ";
     if (header.rfind(prefix, 0) != 0) {
-        error_message = "Authorization header must use Bearer scheme";
-        return std::nullopt;
+        return Unexpected(TokenError::WrongScheme);
     }
     std::string token = header.substr(prefix.size());
     if (token.empty()) {
-        error_message = "Bearer token must not be empty";
-        return std::nullopt;
+        return Unexpected(TokenError::Empty);
     }
     return token;
 }
 
 int register_service(const std::string& registry_service_url,
                      const std::string& service_address,
-                     const std::vector<std::string>& methods) {
+                     const std::vector<std::string>& methods,
+                     std::chrono::milliseconds timeout) {
     httplib::Client client(registry_service_url.c_str());
-    client.set_connection_timeout(5, 0);
-    client.set_read_timeout(5, 0);
-    client.set_write_timeout(5, 0);
+    client.set_connection_timeout(timeout);
+    client.set_read_timeout(timeout);
+    client.set_write_timeout(timeout);
 
     json service_payload{
         {"ServiceName", kServiceName},
         {"address", service_address}
     };
 
+    switch (simulate_http_fault(FaultTarget::RegistryService, timeout)) {
+        case FaultOutcome::None:
+            break;
+        case FaultOutcome::Error:
+            throw std::runtime_error("Registry service rejected registration: 500");
+        case FaultOutcome::Drop:
+        case FaultOutcome::Timeout:
+            throw std::runtime_error("Failed to reach registry service");
+    }
+
     auto service_response = client.Post("/server", service_payload.dump(), "application/json");
     if (!service_response) {
         throw std::runtime_error("Failed to reach registry service");
@@ -171,140 +264,431 @@ json make_error(const std::string& message, const std::string& code = "") {
 }
 
 void send_json(httplib::Response& res, int status, const json& payload) {
+    if (status >= 400) {
+        if (auto* context = current_request()) {
+            auto code = payload.find("code");
+            if (code != payload.end() && code->is_string()) {
+                context->error_code = code->get<std::string>();
+            }
+        }
+    }
+    PhaseTimer serialize_phase(RequestPhase::Serialize);
+    AUCTION_PROBE1(serialize__start, status);
     res.status = status;
     res.set_content(payload.dump(), "application/json");
+    AUCTION_PROBE2(serialize__end, status, res.body.size());
+}
+
+void send_server_error(httplib::Response& res, const std::exception& ex) {
+    auto* context = current_request();
+    // A query cancelled because the client went away surfaces as a database error.
+    if (dynamic_cast<const ClientDisconnectedError*>(&ex) ||
+        (context && context->client_gone && context->client_gone())) {
+        // Nobody is left to read the response; 499 only shows up in metrics and logs.
+        res.status = 499;
+        return;
+    }
+    bool deadline_passed = context && context->has_deadline() &&
+                           std::chrono::steady_clock::now() >= context->deadline;
+    if (deadline_passed || dynamic_cast<const DeadlineExceededError*>(&ex)) {
+        send_json(res, 504, make_error("Request deadline exceeded", "DEADLINE_EXCEEDED"));
+        return;
+    }
+    send_json(res, 500, make_error(ex.what(), "INTERNAL_ERROR"));
+}
+
+// Requested budget from the X-Request-Timeout-Ms header, if present and valid.
+std::optional<std::chrono::milliseconds> requested_timeout(const httplib::Request& req) {
+    if (!req.has_header("X-Request-Timeout-Ms")) {
+        return std::nullopt;
+    }
+    auto value = parse_integer<long long>(req.get_header_value("X-Request-Timeout-Ms"));
+    if (!value || *value <= 0) {
+        return std::nullopt;
+    }
+    return std::chrono::milliseconds(*value);
+}
+
+// Parses an optional positive integer query parameter, falling back to
+// `fallback` when absent. Returns std::nullopt for malformed or out-of-range values.
+std::optional<int> int_query_param(const httplib::Request& req, const std::string& name, int fallback, int min_value,
+                                   int max_value) {
+    if (!req.has_param(name)) {
+        return fallback;
+    }
+    auto value = parse_integer<int>(req.get_param_value(name));
+    if (!value || *value < min_value || *value > max_value) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+struct RequestError {
+    int status;
+    std::string message;
+    std::string code;
+};
+
+void send_error(httplib::Response& res, const RequestError& error) {
+    send_json(res, error.status, make_error(error.message, error.code));
+}
+
+// Parses a request body that must be an object, as JSON or in the binary
+// format named by Content-Type. Malformed input is common under abusive
+// traffic, so it is reported without throwing.
+Expected<json, RequestError> parse_json_object(const httplib::Request& req) {
+    auto format = body_format(req.get_header_value("Content-Type"));
+    auto payload = decode(req.body, format);
+    if (payload.is_discarded()) {
+        return Unexpected(RequestError{400, std::string("Invalid ") + content_type(format) + " payload", "INVALID_JSON"});
+    }
+    if (!payload.is_object()) {
+        return Unexpected(RequestError{400, "Request payload must be an object", "INVALID_JSON"});
+    }
+    return payload;
+}
+
+// Lot endpoints answer in the format the Accept header asks for; errors are
+// always JSON. Sends 406 when no supported format is acceptable.
+std::optional<WireFormat> response_format(const httplib::Request& req, httplib::Response& res) {
+    auto format = negotiate_format(req.get_header_value("Accept"));
+    if (!format) {
+        send_json(res, 406,
+                  make_error("Supported response types: application/json, application/msgpack, application/cbor",
+                             "NOT_ACCEPTABLE"));
+    }
+    return format;
+}
+
+template <typename Lots>
+void send_lots(httplib::Response& res, int status, WireFormat format, const Lots& lots) {
+    PhaseTimer serialize_phase(RequestPhase::Serialize);
+    AUCTION_PROBE1(serialize__start, status);
+    res.status = status;
+    res.set_header("Vary", "Accept");
+    res.set_content(encode(lots, format), content_type(format));
+    AUCTION_PROBE2(serialize__end, status, res.body.size());
+}
+
+void send_columnar(httplib::Response& res, const std::vector<Lot>& lots) {
+    PhaseTimer serialize_phase(RequestPhase::Serialize);
+    AUCTION_PROBE1(serialize__start, 200);
+    res.status = 200;
+    res.set_header("Vary", "Accept");
+    res.set_content(encode_columnar(lots), "application/json");
+    AUCTION_PROBE2(serialize__end, 200, res.body.size());
+}
+
+RequestError bid_rejection(BidError error) {
+    switch (error) {
+        case BidError::LotNotFound:
+            return {404, bid_error_message(error), "LOT_NOT_FOUND"};
+        case BidError::BidTooLow:
+            return {400, bid_error_message(error), "BID_TOO_LOW"};
+        case BidError::AuctionEnded:
+            return {409, bid_error_message(error), "AUCTION_ENDED"};
+        case BidError::UpdateFailed:
+            break;
+    }
+    return {400, bid_error_message(error), "BID_ERROR"};
+}
+
+// Constant time for equal lengths, so response timing does not reveal how
+// much of a guessed token was right.
+bool admin_token_matches(const std::string& presented, const std::string& expected) {
+    return presented.size() == expected.size() &&
+           CRYPTO_memcmp(presented.data(), expected.data(), expected.size()) == 0;
+}
+
+RequestError token_rejection(TokenError error) {
+    switch (error) {
+        case TokenError::MissingHeader:
+            return {401, "Authorization header is required", "AUTH_HEADER_REQUIRED"};
+        case TokenError::WrongScheme:
+            return {401, "Authorization header must use Bearer scheme", "AUTH_SCHEME_INVALID"};
+        case TokenError::Empty:
+            return {401, "Bearer token must not be empty", "AUTH_TOKEN_EMPTY"};
+    }
+    return {401, "Invalid Authorization header", "AUTH_ERROR"};
+}
+
+// A zero lot_cache_fresh_for means cached entries never go stale.
+bool cache_entry_fresh(std::chrono::seconds age, const RuntimeSettings& runtime) {
+    return runtime.lot_cache_fresh_for.count() == 0 || age <= runtime.lot_cache_fresh_for;
+}
+
+// Rejects a bid from the cached lot alone, checking in the same order as
+// Database::place_bid. Only definite rejections are returned; the database
+// decides everything else.
+std::optional<BidError> cached_bid_rejection(const CachedBidState& state, double bid_amount) {
+    if (bid_amount <= static_cast<double>(state.price_cents) / 100.0) {
+        return BidError::BidTooLow;
+    }
+    auto now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::system_clock::now().time_since_epoch()).count();
+    if (state.auction_end_us <= now_us) {
+        return BidError::AuctionEnded;
+    }
+    return std::nullopt;
+}
+
+struct TrafficClass {
+    Bulkhead& pool;
+    std::chrono::milliseconds RuntimeSettings::*default_deadline;
+    // Decides the priority of each request; all requests are normal without it.
+    std::function<RequestPriority(const RequestContext&)> priority{};
+};
+
+ArchiverSettings archiver_settings_from(const RuntimeSettings& runtime) {
+    ArchiverSettings settings;
+    settings.retention_days = runtime.archive_retention_days;
+    settings.batch_size = runtime.archive_batch_size;
+    settings.interval = runtime.archive_interval;
+    return settings;
 }
 
 } // namespace
 
 int main() {
     try {
-        const std::string database_url = require_env("DATABASE_URL");
-        const std::string registry_service_url = require_env("REGISTRY_SERVICE_URL");
-        const std::string payment_service_url = require_env("PAYMENT_SERVICE_URL");
-        const std::string service_port_str = require_env("SERVICE_PORT");
+        block_reload_signal();
 
-        int service_port = 0;
-        try {
-            service_port = std::stoi(service_port_str);
-        } catch (...) {
-            throw std::runtime_error("SERVICE_PORT must be a valid integer");
-        }
-        if (service_port <= 0 || service_port > 65535) {
-            throw std::runtime_error("SERVICE_PORT must be between 1 and 65535");
-        }
+        const char* config_file_env = std::getenv("CONFIG_FILE");
+        const std::string config_file = config_file_env ? config_file_env : "";
+        ConfigStore config(load_config(config_file), config_file);
+        const StartupSettings startup = config.current()->startup;
 
+        const std::string& payment_service_url = startup.payment_service_url;
+        const int service_port = startup.service_port;
         const std::string service_address = "http://auction-service:" + std::to_string(service_port);
 
-        Database database(database_url);
+        Database database(startup.database_url, startup.db_pool_size, startup.db_acquire_timeout,
+                          startup.query_cancel_poll_interval, startup.urgent_db_connections);
         database.ensure_schema();
 
-        std::vector<std::string> payable_methods = {"PlaceBid", "CreateLot", "UpdateLot", "DeleteLot"};
-        try {
-            register_service(registry_service_url, service_address, payable_methods);
-            std::cout << "Successfully registered service with registry" << std::endl;
-        } catch (const std::exception& ex) {
-            std::cerr << "Service registration failed: " << ex.what() << std::endl;
+        LotCache lot_cache(startup.lot_cache_capacity);
+        LotRefresher lot_refresher(database, lot_cache);
+        if (startup.lot_cache_capacity > 0) {
+            lot_refresher.start();
         }
 
-        httplib::Server server;
-
-        server.set_pre_routing_handler([](const httplib::Request& req, httplib::Response& res) {
-            res.set_header("Access-Control-Allow-Origin", "*");
-            res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-            res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
-
-            if (req.method == "OPTIONS") {
-                res.status = 200;
-                return httplib::Server::HandlerResponse::Handled;
-            }
-            return httplib::Server::HandlerResponse::Unhandled;
-        });
-
-        server.set_post_routing_handler([](const httplib::Request&, httplib::Response& res) {
-            res.set_header("Access-Control-Allow-Origin", "*");
-            res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-            res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
-        });
+        std::unique_ptr<AsyncDatabase> async_database;
+        if (startup.async_db_connections > 0) {
+            async_database = std::make_unique<AsyncDatabase>(startup.database_url, startup.async_db_connections,
+                                                             database.watchdog());
+        }
 
-        server.Get("/health", [](const httplib::Request&, httplib::Response& res) {
-            json response{
-                {"status", "healthy"},
-                {"service", kServiceName},
-                {"timestamp", std::time(nullptr)}
-            };
-            send_json(res, 200, response);
+        LotArchiver archiver(database, archiver_settings_from(config.current()->runtime));
+        archiver.start();
+        config.on_reload([&archiver](const ServiceConfig& updated) {
+            archiver.update_settings(archiver_settings_from(updated.runtime));
         });
+        watch_reload_signal(config);
+
+        std::unique_ptr<OutboxRelay> outbox_relay;
+        if (!startup.outbox_sink.empty()) {
+            OutboxRelaySettings relay_settings;
+            relay_settings.batch_size = startup.outbox_batch_size;
+            relay_settings.poll_interval = startup.outbox_poll_interval;
+            auto sink = make_outbox_sink(startup.outbox_sink, startup.outbox_webhook_timeout);
+            database.enable_outbox();
+            outbox_relay = std::make_unique<OutboxRelay>(database, std::move(sink), relay_settings);
+            outbox_relay->start();
+        }
 
-        server.Get("/ready", [&database](const httplib::Request&, httplib::Response& res) {
+        TokenVerifierSettings token_settings;
+        token_settings.payment_service_url = payment_service_url;
+        token_settings.refresh_interval = startup.token_deny_list_refresh;
+        token_settings.max_deny_list_age = startup.token_deny_list_max_age;
+        token_settings.fetch_timeout = config.current()->runtime.payment_timeout;
+        TokenVerifier token_verifier(token_settings);
+        token_verifier.update_keys(token_keys_from(config.current()->runtime));
+        token_verifier.start();
+        config.on_reload([&token_verifier](const ServiceConfig& updated) {
             try {
-                database.check_connection();
-                json response{
-                    {"status", "ready"},
-                    {"database", "connected"},
-                    {"timestamp", std::time(nullptr)}
-                };
-                send_json(res, 200, response);
+                token_verifier.update_keys(token_keys_from(updated.runtime));
             } catch (const std::exception& ex) {
-                json response{
-                    {"status", "not ready"},
-                    {"database", "disconnected"},
-                    {"error", ex.what()},
-                    {"timestamp", std::time(nullptr)}
-                };
-                send_json(res, 503, response);
+                std::cerr << "Keeping previous token keys: " << ex.what() << std::endl;
             }
         });
 
-        server.Get("/lots", [&database](const httplib::Request&, httplib::Response& res) {
-            try {
-                auto lots = database.get_all_lots();
-                send_json(res, 200, lots);
-            } catch (const std::exception& ex) {
-                send_json(res, 500, make_error(ex.what(), "INTERNAL_ERROR"));
+        if (!startup.fault_injection.empty()) {
+            auto faults = configure_faults(json::parse(startup.fault_injection, nullptr, false));
+            if (!faults) {
+                throw std::runtime_error("Invalid FAULT_INJECTION: " + faults.error());
             }
-        });
+            std::cout << "Fault injection active: " << faults->dump() << std::endl;
+        }
 
-        server.Get(R"(/lots/(\d+))", [&database](const httplib::Request& req, httplib::Response& res) {
-            auto lot_id = parse_path_id(req);
-            if (!lot_id) {
-                send_json(res, 400, make_error("Invalid lot id", "INVALID_LOT_ID"));
-                return;
-            }
+        std::vector<std::string> payable_methods = {"PlaceBid", "CreateLot", "UpdateLot", "DeleteLot"};
+        try {
+            register_service(startup.registry_service_url, service_address, payable_methods,
+                             config.current()->runtime.registry_timeout);
+            std::cout << "Successfully registered service with registry" << std::endl;
+        } catch (const std::exception& ex) {
+            std::cerr << "Service registration failed: " << ex.what() << std::endl;
+        }
 
-            try {
-                auto lot = database.get_lot_by_id(*lot_id);
-                if (!lot) {
-                    send_json(res, 404, make_error("Lot not found", "LOT_NOT_FOUND"));
-                    return;
+        MetricsRegistry metrics(startup.request_accounting);
+        if (metrics.resource_accounting()) {
+            std::cout << "Per-request resource accounting enabled"
+                      << (alloc_tracking_available() ? " (with allocation tracking)" : "") << std::endl;
+        }
+
+        AccessLogSettings access_log_settings;
+        access_log_settings.sink = startup.access_log;
+        access_log_settings.sample_every = startup.access_log_sample_every;
+        access_log_settings.max_records_per_second = startup.access_log_max_per_second;
+        AccessLog access_log(access_log_settings);
+
+        Bulkhead read_pool("read", startup.read_pool);
+        Bulkhead write_pool("write", startup.write_pool);
+        Bulkhead admin_pool("admin", startup.admin_pool);
+        // A profile holds its worker for up to a minute, far past the admin
+        // deadline, so it gets a single permit of its own and never queues:
+        // /health and config reloads keep both admin permits meanwhile.
+        Bulkhead profile_pool("profile", BulkheadSettings{1, 0, std::chrono::milliseconds(0)});
+        std::size_t bulkhead_threads = 0;
+        for (const auto* pool : {&read_pool, &write_pool, &admin_pool, &profile_pool}) {
+            bulkhead_threads += pool->settings().max_concurrent + pool->settings().max_queue;
+        }
+        if (startup.http_threads < bulkhead_threads) {
+            std::cerr << "Warning: HTTP_THREADS (" << startup.http_threads
+                      << ") is below the combined pool sizes and queue limits (" << bulkhead_threads
+                      << "); one saturated traffic class can delay the others" << std::endl;
+        }
+
+        TrafficClass read_class{read_pool, &RuntimeSettings::read_deadline};
+        TrafficClass write_class{write_pool, &RuntimeSettings::write_deadline};
+        TrafficClass admin_class{admin_pool, &RuntimeSettings::admin_deadline};
+        TrafficClass profile_class{profile_pool, &RuntimeSettings::admin_deadline};
+
+        // Bids on lots closing within bid_priority_window are urgent. Lots that
+        // are not cached or have already closed keep normal priority.
+        auto bid_priority = [&lot_cache, &config](const RequestContext& context) {
+            auto window = config.current()->runtime.bid_priority_window;
+            if (window.count() == 0 || context.lot_id < 0) {
+                return RequestPriority::Normal;
+            }
+            auto cached = lot_cache.bid_state(context.lot_id);
+            if (!cached) {
+                return RequestPriority::Normal;
+            }
+            auto now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::system_clock::now().time_since_epoch()).count();
+            auto left_us = cached->auction_end_us - now_us;
+            auto window_us = std::chrono::duration_cast<std::chrono::microseconds>(window).count();
+            return left_us > 0 && left_us <= window_us ? RequestPriority::Urgent : RequestPriority::Normal;
+        };
+        TrafficClass bid_class{write_pool, &RuntimeSettings::write_deadline, bid_priority};
+
+        auto instrument = [&metrics, &access_log, &config](const std::string& route, TrafficClass traffic_class,
+                                                           httplib::Server::Handler handler) {
+            auto& route_metrics = metrics.route(route);
+            return [&metrics, &access_log, &config, &route_metrics, traffic_class, route, handler = std::move(handler)](
+                       const httplib::Request& req, httplib::Response& res) {
+                RequestContext context;
+                context.route = route;
+                if (auto lot_id = parse_path_id(req)) {
+                    context.lot_id = *lot_id;
                 }
-                send_json(res, 200, *lot);
-            } catch (const std::exception& ex) {
-                send_json(res, 500, make_error(ex.what(), "INTERNAL_ERROR"));
+                auto budget = config.current()->runtime.*traffic_class.default_deadline;
+                if (auto requested = requested_timeout(req)) {
+                    budget = std::min(budget, *requested);
+                }
+                context.deadline = context.started_at + budget;
+                context.client_gone = [&req] { return req.is_connection_closed(); };
+                if (traffic_class.priority) {
+                    context.priority = traffic_class.priority(context);
+                }
+                RequestContextScope context_scope(context);
+                RequestScope scope(metrics, route_metrics);
+                scope.set_priority(metrics.priority(context.priority));
+                AUCTION_PROBE2(request__start, route.c_str(), context.lot_id);
+                int status = 500;
+                try {
+                    auto permit = traffic_class.pool.acquire(context.deadline, context.priority);
+                    if (!permit) {
+                        if (std::chrono::steady_clock::now() >= context.deadline) {
+                            send_json(res, 504, make_error("Request deadline exceeded", "DEADLINE_EXCEEDED"));
+                        } else {
+                            res.set_header("Retry-After", "1");
+                            send_json(res, 503, make_error("Server is busy, retry later", "OVERLOADED"));
+                        }
+                    } else if (req.is_connection_closed()) {
+                        res.status = 499;
+                    } else {
+                        handler(req, res);
+                    }
+                    status = res.status == -1 ? 200 : res.status;
+                } catch (...) {
+                    AUCTION_PROBE3(request__end, route.c_str(), context.lot_id, status);
+                    scope.finish(status);
+                    access_log.record(context, status, res.body.size());
+                    throw;
+                }
+                AUCTION_PROBE3(request__end, route.c_str(), context.lot_id, status);
+                scope.finish(status);
+                access_log.record(context, status, res.body.size());
+            };
+        };
+
+        auto require_admin = [&config](const httplib::Request& req, httplib::Response& res) {
+            auto admin_token = config.current()->runtime.admin_token;
+            auto token = extract_bearer_token(req);
+            // Without an admin token nothing matches, and callers get the same 401
+            // as for a wrong token rather than learning admin access is unset.
+            if (admin_token.empty() || !token || !admin_token_matches(*token, admin_token)) {
+                send_json(res, 401, make_error("Invalid admin token", "ADMIN_TOKEN_INVALID"));
+                return false;
             }
-        });
+            return true;
+        };
 
-        auto require_paid_access = [&payment_service_url](const httplib::Request& req,
-                                                          httplib::Response& res,
-                                                          const std::string& method_name) -> std::optional<std::string> {
-            std::string token_error;
-            auto token = extract_bearer_token(req, token_error);
+        // Paid endpoints validate in stages, cheapest first, so that a request
+        // that cannot succeed never costs a payment-service call. Errors take
+        // precedence in this order:
+        //   1. 401          missing or malformed Authorization header
+        //   2. 406/400      unsupported Accept, invalid lot id, then an invalid
+        //                   body or field
+        //   3. 400/409      bids only: bid not above the cached price, then the
+        //                   cached auction has closed
+        //   4. 401/403/502  token rejected by the verifier or payment service
+        //   5. 404/409/400  lot state found by the database
+        auto require_bearer_token = [](const httplib::Request& req, httplib::Response& res) -> std::optional<std::string> {
+            auto token = extract_bearer_token(req);
             if (!token) {
-                std::string code;
-                if (token_error == "Authorization header is required") {
-                    code = "AUTH_HEADER_REQUIRED";
-                } else if (token_error == "Authorization header must use Bearer scheme") {
-                    code = "AUTH_SCHEME_INVALID";
-                } else if (token_error == "Bearer token must not be empty") {
-                    code = "AUTH_TOKEN_EMPTY";
-                } else {
-                    code = "AUTH_ERROR";
-                }
-                send_json(res, 401, make_error(token_error, code));
+                send_error(res, token_rejection(token.error()));
                 return std::nullopt;
             }
+            return std::move(*token);
+        };
+
+        auto require_paid_access = [&payment_service_url, &config, &token_verifier](httplib::Response& res,
+                                                                                    const std::string& token,
+                                                                                    const std::string& method_name) {
+            auto timeout = config.current()->runtime.payment_timeout;
+            auto* context = current_request();
+            if (context && context->remaining()) {
+                timeout = std::min(timeout, *context->remaining());
+                if (timeout.count() <= 0) {
+                    send_json(res, 504, make_error("Request deadline exceeded", "DEADLINE_EXCEEDED"));
+                    return false;
+                }
+            }
 
-            auto validation = check_token(payment_service_url, method_name, *token);
+            TokenValidationResult validation;
+            {
+                PhaseTimer auth_phase(RequestPhase::Auth);
+                AUCTION_PROBE1(auth__start, method_name.c_str());
+                auto local = signed_token_validation(token_verifier.verify(token, kServiceName, method_name));
+                validation = local ? *local : check_token(payment_service_url, method_name, token, timeout);
+                AUCTION_PROBE2(auth__end, method_name.c_str(), validation.http_status);
+            }
+            if (context && context->has_deadline() && std::chrono::steady_clock::now() >= context->deadline) {
+                send_json(res, 504, make_error("Request deadline exceeded", "DEADLINE_EXCEEDED"));
+                return false;
+            }
             if (!validation.allowed) {
                 std::string code;
                 switch (validation.http_status) {
@@ -325,255 +709,619 @@ int main() {
                         break;
                 }
                 send_json(res, validation.http_status, make_error(validation.message, code));
-                return std::nullopt;
+                return false;
             }
-            return token;
+            return true;
         };
 
-        server.Post("/lots", [&database, &require_paid_access](const httplib::Request& req, httplib::Response& res) {
-            if (!require_paid_access(req, res, "CreateLot")) {
-                return;
-            }
+        // Every listener gets the same routes; they share the bulkheads, metrics,
+        // caches and database, while each runs its own accept loop and workers.
+        auto configure_server = [&](httplib::Server& server) {
+            const std::size_t http_threads = startup.http_threads;
+            server.new_task_queue = [http_threads] { return new httplib::ThreadPool(http_threads); };
+            server.set_keep_alive_max_count(startup.keep_alive_max_count);
+            server.set_keep_alive_timeout(startup.keep_alive_timeout.count());
+            server.set_payload_max_length(startup.payload_max_bytes);
+
+            server.set_pre_routing_handler([](const httplib::Request& req, httplib::Response& res) {
+                res.set_header("Access-Control-Allow-Origin", "*");
+                res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
+                res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization, X-Request-Timeout-Ms");
+
+                if (req.method == "OPTIONS") {
+                    res.status = 200;
+                    return httplib::Server::HandlerResponse::Handled;
+                }
+                return httplib::Server::HandlerResponse::Unhandled;
+            });
 
-            try {
-                auto payload = json::parse(req.body);
-                if (!payload.contains("name") || !payload.contains("start_price")) {
-                    send_json(res, 400, make_error("Missing required fields: name, start_price", "MISSING_REQUIRED_FIELDS"));
-                    return;
+            server.set_post_routing_handler([](const httplib::Request&, httplib::Response& res) {
+                res.set_header("Access-Control-Allow-Origin", "*");
+                res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
+                res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization, X-Request-Timeout-Ms");
+            });
+
+            server.Get("/health", instrument("GET /health", admin_class, [](const httplib::Request&, httplib::Response& res) {
+                json response{
+                    {"status", "healthy"},
+                    {"service", kServiceName},
+                    {"timestamp", std::time(nullptr)}
+                };
+                send_json(res, 200, response);
+            }));
+
+            server.Get("/ready", instrument("GET /ready", admin_class, [&database](const httplib::Request&, httplib::Response& res) {
+                try {
+                    database.check_connection();
+                    json response{
+                        {"status", "ready"},
+                        {"database", "connected"},
+                        {"timestamp", std::time(nullptr)}
+                    };
+                    send_json(res, 200, response);
+                } catch (const std::exception& ex) {
+                    json response{
+                        {"status", "not ready"},
+                        {"database", "disconnected"},
+                        {"error", ex.what()},
+                        {"timestamp", std::time(nullptr)}
+                    };
+                    send_json(res, 503, response);
+                }
+            }));
+
+            server.Get("/metrics", instrument("GET /metrics", admin_class, [&metrics, &access_log, &database, &async_database, &lot_cache, &lot_refresher, &token_verifier, &read_pool, &write_pool, &admin_pool, &profile_pool](const httplib::Request&, httplib::Response& res) {
+                auto response = metrics.to_json();
+                response["access_log"] = access_log.stats();
+                response["lot_cache"] = lot_cache.stats();
+                response["lot_refresher"] = lot_refresher.stats();
+                response["database_pool"] = database.pool_stats();
+                response["query_watchdog"] = database.watchdog_stats();
+                response["signed_tokens"] = token_verifier.stats();
+                if (async_database) {
+                    response["async_database"] = async_database->stats();
                 }
+                response["worker_pools"] = {
+                    {read_pool.name(), read_pool.stats()},
+                    {write_pool.name(), write_pool.stats()},
+                    {admin_pool.name(), admin_pool.stats()},
+                    {profile_pool.name(), profile_pool.stats()}
+                };
+                response["timestamp"] = std::time(nullptr);
+                send_json(res, 200, response);
+            }));
 
-                if (payload["name"].is_null() || !payload["name"].is_string()) {
-                    send_json(res, 400, make_error("Field 'name' must be a non-empty string", "INVALID_FIELD_TYPE"));
+            server.Get("/admin/config", instrument("GET /admin/config", admin_class, [&config, &require_admin](const httplib::Request& req, httplib::Response& res) {
+                if (!require_admin(req, res)) {
                     return;
                 }
+                send_json(res, 200, config_to_json(*config.current()));
+            }));
 
-                if (!payload["start_price"].is_number()) {
-                    send_json(res, 400, make_error("Field 'start_price' must be a number", "INVALID_FIELD_TYPE"));
+            server.Post("/admin/config/reload", instrument("POST /admin/config/reload", admin_class, [&config, &require_admin](const httplib::Request& req, httplib::Response& res) {
+                if (!require_admin(req, res)) {
                     return;
                 }
+                auto result = config.reload();
+                if (!result.ok) {
+                    send_json(res, 400, make_error(result.error, "CONFIG_INVALID"));
+                    return;
+                }
+                json response{
+                    {"status", "reloaded"},
+                    {"restart_required", result.restart_required},
+                    {"config", config_to_json(*config.current())}
+                };
+                send_json(res, 200, response);
+            }));
 
-                auto name_value = payload["name"].get<std::string>();
-                if (name_value.empty()) {
-                    send_json(res, 400, make_error("Field 'name' must not be empty", "INVALID_FIELD_VALUE"));
+            // Runs for the requested duration regardless of the admin deadline, in its
+            // own one-permit pool; it stops early if the caller leaves. A second
+            // profile is refused with 503 before it can take a worker.
+            server.Get("/debug/profile", instrument("GET /debug/profile", profile_class, [&require_admin](const httplib::Request& req, httplib::Response& res) {
+                if (!require_admin(req, res)) {
+                    return;
+                }
+                auto seconds = int_query_param(req, "seconds", 10, 1, 60);
+                auto frequency = int_query_param(req, "hz", 99, 1, 1000);
+                if (!seconds || !frequency) {
+                    send_json(res, 400, make_error("'seconds' must be 1-60 and 'hz' must be 1-1000", "INVALID_QUERY_PARAM"));
                     return;
                 }
 
-                std::optional<std::string> description;
-                if (payload.contains("description") && !payload["description"].is_null()) {
-                    if (!payload["description"].is_string()) {
-                        send_json(res, 400, make_error("Field 'description' must be a string", "INVALID_FIELD_TYPE"));
+                ProfileSettings settings;
+                settings.duration = std::chrono::seconds(*seconds);
+                settings.frequency_hz = *frequency;
+                settings.cancelled = [&req] { return req.is_connection_closed(); };
+                try {
+                    auto profile = run_cpu_profile(settings);
+                    if (!profile) {
+                        send_json(res, 409, make_error("A profile is already running", "PROFILE_IN_PROGRESS"));
                         return;
                     }
-                    description = payload["description"].get<std::string>();
+                    res.set_header("X-Profile-Samples", std::to_string(profile->samples));
+                    res.set_header("X-Profile-Dropped", std::to_string(profile->dropped));
+                    res.set_header("X-Profile-Elapsed-Ms", std::to_string(profile->elapsed.count()));
+                    res.set_content(profile->folded_stacks, "text/plain");
+                    res.status = 200;
+                } catch (const std::exception& ex) {
+                    send_server_error(res, ex);
+                }
+            }));
+
+            server.Get("/debug/allocator", instrument("GET /debug/allocator", admin_class, [&require_admin](const httplib::Request& req, httplib::Response& res) {
+                if (!require_admin(req, res)) {
+                    return;
+                }
+                try {
+                    send_json(res, 200, allocator_stats(req.get_param_value("arenas") == "1"));
+                } catch (const std::exception& ex) {
+                    send_server_error(res, ex);
+                }
+            }));
+
+            // Faults are process-wide, so they also hit requests on the other listener.
+            server.Get("/debug/faults", instrument("GET /debug/faults", admin_class, [&require_admin](const httplib::Request& req, httplib::Response& res) {
+                if (!require_admin(req, res)) {
+                    return;
+                }
+                send_json(res, 200, fault_stats());
+            }));
+
+            server.Put("/debug/faults", instrument("PUT /debug/faults", admin_class, [&require_admin](const httplib::Request& req, httplib::Response& res) {
+                if (!require_admin(req, res)) {
+                    return;
+                }
+                if (!fault_injection_available()) {
+                    send_json(res, 404, make_error("Built without AUCTION_FAULT_INJECTION", "FAULT_INJECTION_UNAVAILABLE"));
+                    return;
+                }
+                auto parsed = parse_json_object(req);
+                if (!parsed) {
+                    send_error(res, parsed.error());
+                    return;
+                }
+                auto active = configure_faults(*parsed);
+                if (!active) {
+                    send_json(res, 400, make_error(active.error(), "INVALID_FAULT_CONFIG"));
+                    return;
+                }
+                send_json(res, 200, *active);
+            }));
+
+            server.Delete("/debug/faults", instrument("DELETE /debug/faults", admin_class, [&require_admin](const httplib::Request& req, httplib::Response& res) {
+                if (!require_admin(req, res)) {
+                    return;
                 }
+                clear_faults();
+                res.status = 204;
+            }));
 
-                std::optional<std::string> owner_id;
-                if (payload.contains("owner_id") && !payload["owner_id"].is_null()) {
-                    if (!payload["owner_id"].is_string()) {
-                        send_json(res, 400, make_error("Field 'owner_id' must be a string", "INVALID_FIELD_TYPE"));
+            server.Get("/lots", instrument("GET /lots", read_class, [&database](const httplib::Request& req, httplib::Response& res) {
+                auto format = response_format(req, res);
+                if (!format) {
+                    return;
+                }
+                auto scope = LotListScope::Active;
+                if (req.has_param("status")) {
+                    auto status = req.get_param_value("status");
+                    if (status == "all") {
+                        scope = LotListScope::All;
+                    } else if (status != "active") {
+                        send_json(res, 400, make_error("Query parameter 'status' must be 'active' or 'all'", "INVALID_QUERY_PARAM"));
                         return;
                     }
-                    owner_id = payload["owner_id"].get<std::string>();
                 }
-
-                std::optional<std::string> auction_end_date;
-                if (payload.contains("auction_end_date")) {
-                    if (payload["auction_end_date"].is_null()) {
-                        auction_end_date = std::nullopt;
-                    } else if (!payload["auction_end_date"].is_string()) {
-                        send_json(res, 400, make_error("Field 'auction_end_date' must be a string or null", "INVALID_FIELD_TYPE"));
+                bool columnar = false;
+                if (req.has_param("format")) {
+                    auto layout = req.get_param_value("format");
+                    if (layout == "columnar") {
+                        columnar = true;
+                    } else if (layout != "rows") {
+                        send_json(res, 400, make_error("Query parameter 'format' must be 'rows' or 'columnar'", "INVALID_QUERY_PARAM"));
                         return;
+                    }
+                }
+                if (columnar && *format != WireFormat::Json) {
+                    send_json(res, 406, make_error("format=columnar is only available as application/json", "NOT_ACCEPTABLE"));
+                    return;
+                }
+
+                try {
+                    auto lots = database.get_all_lots(scope);
+                    // Skip serializing a potentially large listing nobody is waiting for.
+                    ensure_request_alive();
+                    if (columnar) {
+                        send_columnar(res, lots);
                     } else {
-                        auto value = payload["auction_end_date"].get<std::string>();
-                        if (!value.empty()) {
-                            auction_end_date = value;
-                        }
+                        send_lots(res, 200, *format, lots);
                     }
+                } catch (const std::exception& ex) {
+                    send_server_error(res, ex);
+                }
+            }));
+
+            server.Get(R"(/lots/(\d+))", instrument("GET /lots/{id}", read_class, [&database, &async_database, &lot_cache, &lot_refresher, &config](const httplib::Request& req, httplib::Response& res) {
+                auto format = response_format(req, res);
+                if (!format) {
+                    return;
+                }
+                auto lot_id = parse_path_id(req);
+                if (!lot_id) {
+                    send_json(res, 400, make_error("Invalid lot id", "INVALID_LOT_ID"));
+                    return;
                 }
 
-                LotCreateParams params{
-                    name_value,
-                    description,
-                    payload["start_price"].get<double>(),
-                    owner_id,
-                    auction_end_date
+                auto send_stale = [&res, &format](const CachedLot& cached, const char* warning) {
+                    send_lots(res, 200, *format, cached.lot);
+                    res.set_header("Age", std::to_string(cached.age.count()));
+                    res.set_header("Warning", warning);
                 };
+                try {
+                    if (auto cached = lot_cache.get(*lot_id)) {
+                        auto settings = config.current();
+                        const auto fresh_for = settings->runtime.lot_cache_fresh_for;
+                        if (cache_entry_fresh(cached->age, settings->runtime)) {
+                            send_lots(res, 200, *format, cached->lot);
+                            return;
+                        }
+                        // Serve the stale copy now rather than wait on a database
+                        // that may be down; past max_stale, go to the database
+                        // and answer like an uncached read if it fails.
+                        if (cached->age <= fresh_for + settings->runtime.lot_cache_max_stale) {
+                            lot_refresher.request(*lot_id);
+                            send_stale(*cached, lot_refresher.failing() ? "111 - \"Revalidation Failed\""
+                                                                        : "110 - \"Response is Stale\"");
+                            return;
+                        }
+                    }
+                    std::optional<Lot> lot;
+                    if (async_database) {
+                        PhaseTimer db_phase(RequestPhase::Database);
+                        lot = sync_wait(async_database->get_lot_by_id(*lot_id, current_request()->deadline));
+                    } else {
+                        lot = database.get_lot_by_id(*lot_id);
+                    }
+                    if (!lot) {
+                        send_json(res, 404, make_error("Lot not found", "LOT_NOT_FOUND"));
+                        return;
+                    }
+                    lot_cache.put(*lot);
+                    send_lots(res, 200, *format, *lot);
+                } catch (const std::exception& ex) {
+                    send_server_error(res, ex);
+                }
+            }));
 
-                auto created = database.create_lot(params);
-                send_json(res, 201, created);
-            } catch (const json::parse_error&) {
-                send_json(res, 400, make_error("Invalid JSON payload", "INVALID_JSON"));
-            } catch (const json::type_error& ex) {
-                send_json(res, 400, make_error(std::string("Invalid field type: ") + ex.what(), "INVALID_FIELD_TYPE"));
-            } catch (const std::exception& ex) {
-                send_json(res, 500, make_error(ex.what(), "INTERNAL_ERROR"));
-            }
-        });
+            server.Post("/lots", instrument("POST /lots", write_class, [&database, &config, &lot_cache, &require_bearer_token, &require_paid_access](const httplib::Request& req, httplib::Response& res) {
+                auto token = require_bearer_token(req, res);
+                if (!token) {
+                    return;
+                }
+                auto format = response_format(req, res);
+                if (!format) {
+                    return;
+                }
 
-        server.Put(R"(/lots/(\d+))", [&database, &require_paid_access](const httplib::Request& req, httplib::Response& res) {
-            if (!require_paid_access(req, res, "UpdateLot")) {
-                return;
-            }
+                auto parsed = parse_json_object(req);
+                if (!parsed) {
+                    send_error(res, parsed.error());
+                    return;
+                }
 
-            auto lot_id = parse_path_id(req);
-            if (!lot_id) {
-                send_json(res, 400, make_error("Invalid lot id", "INVALID_LOT_ID"));
-                return;
-            }
+                try {
+                    auto& payload = *parsed;
+                    if (!payload.contains("name") || !payload.contains("start_price")) {
+                        send_json(res, 400, make_error("Missing required fields: name, start_price", "MISSING_REQUIRED_FIELDS"));
+                        return;
+                    }
 
-            try {
-                auto payload = json::parse(req.body);
-
-                LotUpdateParams params{};
-                if (payload.contains("name")) {
-                    params.name_present = true;
-                    if (payload["name"].is_null()) {
-                        params.name = std::nullopt;
-                    } else if (!payload["name"].is_string()) {
-                        send_json(res, 400, make_error("Field 'name' must be a string or null", "INVALID_FIELD_TYPE"));
+                    if (payload["name"].is_null() || !payload["name"].is_string()) {
+                        send_json(res, 400, make_error("Field 'name' must be a non-empty string", "INVALID_FIELD_TYPE"));
                         return;
-                    } else {
-                        params.name = payload["name"].get<std::string>();
                     }
-                }
-                if (payload.contains("description")) {
-                    params.description_present = true;
-                    if (payload["description"].is_null()) {
-                        params.description = std::nullopt;
-                    } else if (!payload["description"].is_string()) {
-                        send_json(res, 400, make_error("Field 'description' must be a string or null", "INVALID_FIELD_TYPE"));
+
+                    if (!payload["start_price"].is_number()) {
+                        send_json(res, 400, make_error("Field 'start_price' must be a number", "INVALID_FIELD_TYPE"));
                         return;
-                    } else {
-                        params.description = payload["description"].get<std::string>();
                     }
-                }
-                if (payload.contains("owner_id")) {
-                    params.owner_id_present = true;
-                    if (payload["owner_id"].is_null()) {
-                        params.owner_id = std::nullopt;
-                    } else if (!payload["owner_id"].is_string()) {
-                        send_json(res, 400, make_error("Field 'owner_id' must be a string or null", "INVALID_FIELD_TYPE"));
+
+                    auto name_value = payload["name"].get<std::string>();
+                    if (name_value.empty()) {
+                        send_json(res, 400, make_error("Field 'name' must not be empty", "INVALID_FIELD_VALUE"));
                         return;
-                    } else {
-                        params.owner_id = payload["owner_id"].get<std::string>();
                     }
-                }
-                if (payload.contains("auction_end_date")) {
-                    params.auction_end_date_present = true;
-                    if (payload["auction_end_date"].is_null()) {
-                        params.auction_end_date = std::nullopt;
-                    } else if (!payload["auction_end_date"].is_string()) {
-                        send_json(res, 400, make_error("Field 'auction_end_date' must be a string or null", "INVALID_FIELD_TYPE"));
+
+                    std::optional<std::string> description;
+                    if (payload.contains("description") && !payload["description"].is_null()) {
+                        if (!payload["description"].is_string()) {
+                            send_json(res, 400, make_error("Field 'description' must be a string", "INVALID_FIELD_TYPE"));
+                            return;
+                        }
+                        description = payload["description"].get<std::string>();
+                    }
+
+                    std::optional<std::string> owner_id;
+                    if (payload.contains("owner_id") && !payload["owner_id"].is_null()) {
+                        if (!payload["owner_id"].is_string()) {
+                            send_json(res, 400, make_error("Field 'owner_id' must be a string", "INVALID_FIELD_TYPE"));
+                            return;
+                        }
+                        owner_id = payload["owner_id"].get<std::string>();
+                    }
+
+                    std::optional<std::string> auction_end_date;
+                    if (payload.contains("auction_end_date")) {
+                        if (payload["auction_end_date"].is_null()) {
+                            auction_end_date = std::nullopt;
+                        } else if (!payload["auction_end_date"].is_string()) {
+                            send_json(res, 400, make_error("Field 'auction_end_date' must be a string or null", "INVALID_FIELD_TYPE"));
+                            return;
+                        } else {
+                            auto value = payload["auction_end_date"].get<std::string>();
+                            if (!value.empty()) {
+                                auction_end_date = value;
+                            }
+                        }
+                    }
+
+                    LotCreateParams params{
+                        name_value,
+                        description,
+                        payload["start_price"].get<double>(),
+                        owner_id,
+                        auction_end_date,
+                        config.current()->runtime.default_auction_duration
+                    };
+
+                    if (!require_paid_access(res, *token, "CreateLot")) {
                         return;
-                    } else {
-                        auto value = payload["auction_end_date"].get<std::string>();
-                        if (value.empty()) {
+                    }
+                    auto created = database.create_lot(params);
+                    lot_cache.put(created);
+                    send_lots(res, 201, *format, created);
+                } catch (const std::exception& ex) {
+                    send_server_error(res, ex);
+                }
+            }));
+
+            server.Put(R"(/lots/(\d+))", instrument("PUT /lots/{id}", write_class, [&database, &lot_cache, &require_bearer_token, &require_paid_access](const httplib::Request& req, httplib::Response& res) {
+                auto token = require_bearer_token(req, res);
+                if (!token) {
+                    return;
+                }
+                auto format = response_format(req, res);
+                if (!format) {
+                    return;
+                }
+
+                auto lot_id = parse_path_id(req);
+                if (!lot_id) {
+                    send_json(res, 400, make_error("Invalid lot id", "INVALID_LOT_ID"));
+                    return;
+                }
+
+                auto parsed = parse_json_object(req);
+                if (!parsed) {
+                    send_error(res, parsed.error());
+                    return;
+                }
+
+                try {
+                    auto& payload = *parsed;
+
+                    LotUpdateParams params{};
+                    if (payload.contains("name")) {
+                        params.name_present = true;
+                        if (payload["name"].is_null()) {
+                            params.name = std::nullopt;
+                        } else if (!payload["name"].is_string()) {
+                            send_json(res, 400, make_error("Field 'name' must be a string or null", "INVALID_FIELD_TYPE"));
+                            return;
+                        } else {
+                            params.name = payload["name"].get<std::string>();
+                        }
+                    }
+                    if (payload.contains("description")) {
+                        params.description_present = true;
+                        if (payload["description"].is_null()) {
+                            params.description = std::nullopt;
+                        } else if (!payload["description"].is_string()) {
+                            send_json(res, 400, make_error("Field 'description' must be a string or null", "INVALID_FIELD_TYPE"));
+                            return;
+                        } else {
+                            params.description = payload["description"].get<std::string>();
+                        }
+                    }
+                    if (payload.contains("owner_id")) {
+                        params.owner_id_present = true;
+                        if (payload["owner_id"].is_null()) {
+                            params.owner_id = std::nullopt;
+                        } else if (!payload["owner_id"].is_string()) {
+                            send_json(res, 400, make_error("Field 'owner_id' must be a string or null", "INVALID_FIELD_TYPE"));
+                            return;
+                        } else {
+                            params.owner_id = payload["owner_id"].get<std::string>();
+                        }
+                    }
+                    if (payload.contains("auction_end_date")) {
+                        params.auction_end_date_present = true;
+                        if (payload["auction_end_date"].is_null()) {
                             params.auction_end_date = std::nullopt;
+                        } else if (!payload["auction_end_date"].is_string()) {
+                            send_json(res, 400, make_error("Field 'auction_end_date' must be a string or null", "INVALID_FIELD_TYPE"));
+                            return;
                         } else {
-                            params.auction_end_date = value;
+                            auto value = payload["auction_end_date"].get<std::string>();
+                            if (value.empty()) {
+                                params.auction_end_date = std::nullopt;
+                            } else {
+                                params.auction_end_date = value;
+                            }
                         }
                     }
-                }
-                if (payload.contains("current_price")) {
-                    params.current_price_present = true;
-                    if (payload["current_price"].is_null()) {
-                        params.current_price = std::nullopt;
-                    } else if (!payload["current_price"].is_number()) {
-                        send_json(res, 400, make_error("Field 'current_price' must be a number or null", "INVALID_FIELD_TYPE"));
+                    if (payload.contains("current_price")) {
+                        params.current_price_present = true;
+                        if (payload["current_price"].is_null()) {
+                            params.current_price = std::nullopt;
+                        } else if (!payload["current_price"].is_number()) {
+                            send_json(res, 400, make_error("Field 'current_price' must be a number or null", "INVALID_FIELD_TYPE"));
+                            return;
+                        } else {
+                            params.current_price = payload["current_price"].get<double>();
+                        }
+                    }
+
+                    if (!require_paid_access(res, *token, "UpdateLot")) {
+                        return;
+                    }
+                    auto updated = database.update_lot(*lot_id, params);
+                    if (!updated) {
+                        lot_cache.erase(*lot_id);
+                        if (updated.error() == UpdateError::LotArchived) {
+                            send_json(res, 409, make_error("Archived lots cannot be modified", "LOT_ARCHIVED"));
+                        } else {
+                            send_json(res, 404, make_error("Lot not found", "LOT_NOT_FOUND"));
+                        }
                         return;
-                    } else {
-                        params.current_price = payload["current_price"].get<double>();
                     }
+                    lot_cache.put(*updated);
+                    send_lots(res, 200, *format, *updated);
+                } catch (const std::exception& ex) {
+                    send_server_error(res, ex);
                 }
+            }));
 
-                auto updated = database.update_lot(*lot_id, params);
-                if (!updated) {
-                    send_json(res, 404, make_error("Lot not found", "LOT_NOT_FOUND"));
+            server.Delete(R"(/lots/(\d+))", instrument("DELETE /lots/{id}", write_class, [&database, &lot_cache, &require_bearer_token, &require_paid_access](const httplib::Request& req, httplib::Response& res) {
+                auto token = require_bearer_token(req, res);
+                if (!token) {
                     return;
                 }
-                send_json(res, 200, *updated);
-            } catch (const json::parse_error&) {
-                send_json(res, 400, make_error("Invalid JSON payload", "INVALID_JSON"));
-            } catch (const json::type_error& ex) {
-                send_json(res, 400, make_error(std::string("Invalid field type: ") + ex.what(), "INVALID_FIELD_TYPE"));
-            } catch (const std::exception& ex) {
-                send_json(res, 500, make_error(ex.what(), "INTERNAL_ERROR"));
-            }
-        });
 
-        server.Delete(R"(/lots/(\d+))", [&database, &require_paid_access](const httplib::Request& req, httplib::Response& res) {
-            if (!require_paid_access(req, res, "DeleteLot")) {
-                return;
-            }
-
-            auto lot_id = parse_path_id(req);
-            if (!lot_id) {
-                send_json(res, 400, make_error("Invalid lot id", "INVALID_LOT_ID"));
-                return;
-            }
+                auto lot_id = parse_path_id(req);
+                if (!lot_id) {
+                    send_json(res, 400, make_error("Invalid lot id", "INVALID_LOT_ID"));
+                    return;
+                }
 
-            try {
-                bool deleted = database.delete_lot(*lot_id);
-                if (!deleted) {
-                    send_json(res, 404, make_error("Lot not found", "LOT_NOT_FOUND"));
+                if (!require_paid_access(res, *token, "DeleteLot")) {
                     return;
                 }
-                res.status = 204;
-            } catch (const std::exception& ex) {
-                send_json(res, 500, make_error(ex.what(), "INTERNAL_ERROR"));
-            }
-        });
 
-        server.Post(R"(/lots/(\d+)/bid)", [&database, &require_paid_access](const httplib::Request& req, httplib::Response& res) {
-            if (!require_paid_access(req, res, "PlaceBid")) {
-                return;
-            }
+                try {
+                    bool deleted = database.delete_lot(*lot_id);
+                    lot_cache.erase(*lot_id);
+                    if (!deleted) {
+                        send_json(res, 404, make_error("Lot not found", "LOT_NOT_FOUND"));
+                        return;
+                    }
+                    res.status = 204;
+                } catch (const std::exception& ex) {
+                    send_server_error(res, ex);
+                }
+            }));
 
-            auto lot_id = parse_path_id(req);
-            if (!lot_id) {
-                send_json(res, 400, make_error("Invalid lot id", "INVALID_LOT_ID"));
-                return;
-            }
+            server.Post(R"(/lots/(\d+)/bid)", instrument("POST /lots/{id}/bid", bid_class, [&database, &lot_cache, &config, &require_bearer_token, &require_paid_access](const httplib::Request& req, httplib::Response& res) {
+                auto token = require_bearer_token(req, res);
+                if (!token) {
+                    return;
+                }
+                auto format = response_format(req, res);
+                if (!format) {
+                    return;
+                }
 
-            try {
-                auto payload = json::parse(req.body);
-                if (!payload.contains("bid_amount")) {
-                    send_json(res, 400, make_error("Missing field: bid_amount", "MISSING_BID_AMOUNT"));
+                auto lot_id = parse_path_id(req);
+                if (!lot_id) {
+                    send_json(res, 400, make_error("Invalid lot id", "INVALID_LOT_ID"));
                     return;
                 }
-                if (!payload["bid_amount"].is_number()) {
-                    send_json(res, 400, make_error("Field 'bid_amount' must be a number", "INVALID_FIELD_TYPE"));
+
+                auto parsed = parse_json_object(req);
+                if (!parsed) {
+                    send_error(res, parsed.error());
                     return;
                 }
-                double bid_amount = payload["bid_amount"].get<double>();
-
-                std::string error_reason;
-                auto updated = database.place_bid(*lot_id, bid_amount, error_reason);
-                if (!updated) {
-                    if (error_reason == "Lot not found") {
-                        send_json(res, 404, make_error(error_reason, "LOT_NOT_FOUND"));
-                    } else if (error_reason == "Bid must be greater than current price") {
-                        send_json(res, 400, make_error(error_reason, "BID_TOO_LOW"));
-                    } else if (error_reason == "Auction has ended") {
-                        send_json(res, 409, make_error(error_reason, "AUCTION_ENDED"));
-                    } else {
-                        send_json(res, 400, make_error(error_reason, "BID_ERROR"));
+
+                try {
+                    auto& payload = *parsed;
+                    if (!payload.contains("bid_amount")) {
+                        send_json(res, 400, make_error("Missing field: bid_amount", "MISSING_BID_AMOUNT"));
+                        return;
                     }
-                    return;
+                    if (!payload["bid_amount"].is_number()) {
+                        send_json(res, 400, make_error("Field 'bid_amount' must be a number", "INVALID_FIELD_TYPE"));
+                        return;
+                    }
+                    double bid_amount = payload["bid_amount"].get<double>();
+
+                    // Only a fresh entry may reject a bid; a stale price or end date
+                    // is left to the database.
+                    auto cached = lot_cache.bid_state(*lot_id);
+                    if (cached && cache_entry_fresh(cached->age, config.current()->runtime)) {
+                        if (auto rejection = cached_bid_rejection(*cached, bid_amount)) {
+                            send_error(res, bid_rejection(*rejection));
+                            return;
+                        }
+                    }
+                    if (!require_paid_access(res, *token, "PlaceBid")) {
+                        return;
+                    }
+
+                    auto updated = database.place_bid(*lot_id, bid_amount);
+                    if (!updated) {
+                        if (updated.error() == BidError::LotNotFound) {
+                            lot_cache.erase(*lot_id);
+                        }
+                        send_error(res, bid_rejection(updated.error()));
+                        return;
+                    }
+
+                    lot_cache.put(*updated);
+                    send_lots(res, 200, *format, *updated);
+                } catch (const std::exception& ex) {
+                    send_server_error(res, ex);
                 }
+            }));
+        };
 
-                send_json(res, 200, *updated);
-            } catch (const json::parse_error&) {
-                send_json(res, 400, make_error("Invalid JSON payload", "INVALID_JSON"));
-            } catch (const json::type_error& ex) {
-                send_json(res, 400, make_error(std::string("Invalid field type: ") + ex.what(), "INVALID_FIELD_TYPE"));
-            } catch (const std::exception& ex) {
-                send_json(res, 500, make_error(ex.what(), "INTERNAL_ERROR"));
+        std::unique_ptr<httplib::Server> unix_server;
+        if (!startup.unix_socket_path.empty()) {
+            const std::string& socket_path = startup.unix_socket_path;
+            unix_server = std::make_unique<httplib::Server>();
+            configure_server(*unix_server);
+            unix_server->set_address_family(AF_UNIX);
+            // A socket file left behind by a previous run would make bind fail.
+            ::unlink(socket_path.c_str());
+            if (!unix_server->bind_to_port(socket_path, 0)) {
+                throw std::runtime_error("Failed to bind Unix socket " + socket_path);
             }
-        });
+            std::cout << "AuctionService listening on unix:" << socket_path << std::endl;
+        }
 
-        std::cout << "AuctionService listening on port " << service_port << std::endl;
-        if (!server.listen("0.0.0.0", service_port)) {
+        bool served = true;
+        if (startup.tcp_listener) {
+            std::thread unix_listener;
+            if (unix_server) {
+                unix_listener = std::thread([&unix_server] { unix_server->listen_after_bind(); });
+                // stop() is a no-op until the accept loop runs.
+                unix_server->wait_until_ready();
+            }
+            httplib::Server server;
+            configure_server(server);
+            std::cout << "AuctionService listening on port " << service_port << std::endl;
+            served = server.listen("0.0.0.0", service_port);
+            if (unix_server) {
+                unix_server->stop();
+                unix_listener.join();
+            }
+        } else {
+            served = unix_server->listen_after_bind();
+        }
+        if (unix_server) {
+            ::unlink(startup.unix_socket_path.c_str());
+        }
+        if (!served) {
             throw std::runtime_error("Failed to start HTTP server");
         }
     } catch (const std::exception& ex) {
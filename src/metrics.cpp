@@ -0,0 +1,131 @@
+#include "metrics.h"
+
+#include <ctime>
+
+namespace {
+
+std::uint64_t thread_cpu_ns() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+void update_max(std::atomic<std::uint64_t>& target, std::uint64_t value) {
+    auto current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+double average(std::uint64_t total, std::uint64_t count) {
+    return count == 0 ? 0.0 : static_cast<double>(total) / static_cast<double>(count);
+}
+
+nlohmann::json route_to_json(const RouteMetrics& metrics, bool resource_accounting) {
+    auto requests = metrics.requests.load(std::memory_order_relaxed);
+    auto latency_ns = metrics.latency_ns.load(std::memory_order_relaxed);
+    nlohmann::json entry{
+        {"requests", requests},
+        {"client_errors", metrics.client_errors.load(std::memory_order_relaxed)},
+        {"server_errors", metrics.server_errors.load(std::memory_order_relaxed)},
+        {"latency_us_avg", average(latency_ns, requests) / 1000.0},
+        {"latency_us_max", metrics.max_latency_ns.load(std::memory_order_relaxed) / 1000.0}
+    };
+    if (resource_accounting) {
+        auto sampled = metrics.sampled_requests.load(std::memory_order_relaxed);
+        auto alloc_count = metrics.alloc_count.load(std::memory_order_relaxed);
+        auto alloc_bytes = metrics.alloc_bytes.load(std::memory_order_relaxed);
+        entry["cpu_us_avg"] = average(metrics.cpu_ns.load(std::memory_order_relaxed), sampled) / 1000.0;
+        if (alloc_tracking_available()) {
+            entry["allocations_total"] = alloc_count;
+            entry["allocated_bytes_total"] = alloc_bytes;
+            entry["allocations_avg"] = average(alloc_count, sampled);
+            entry["allocated_bytes_avg"] = average(alloc_bytes, sampled);
+        }
+    }
+    return entry;
+}
+
+void record(RouteMetrics& metrics, int status, std::uint64_t latency_ns) {
+    metrics.requests.fetch_add(1, std::memory_order_relaxed);
+    metrics.latency_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+    update_max(metrics.max_latency_ns, latency_ns);
+    if (status >= 500) {
+        metrics.server_errors.fetch_add(1, std::memory_order_relaxed);
+    } else if (status >= 400) {
+        metrics.client_errors.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void record_resources(RouteMetrics& metrics, std::uint64_t cpu_ns, const AllocSnapshot& allocated) {
+    metrics.sampled_requests.fetch_add(1, std::memory_order_relaxed);
+    metrics.cpu_ns.fetch_add(cpu_ns, std::memory_order_relaxed);
+    metrics.alloc_count.fetch_add(allocated.count, std::memory_order_relaxed);
+    metrics.alloc_bytes.fetch_add(allocated.bytes, std::memory_order_relaxed);
+}
+
+} // namespace
+
+MetricsRegistry::MetricsRegistry(bool resource_accounting)
+    : resource_accounting_(resource_accounting) {}
+
+RouteMetrics& MetricsRegistry::route(const std::string& name) {
+    auto& slot = routes_[name];
+    if (!slot) {
+        slot = std::make_unique<RouteMetrics>();
+    }
+    return *slot;
+}
+
+RouteMetrics& MetricsRegistry::priority(RequestPriority priority) {
+    return priorities_[static_cast<std::size_t>(priority)];
+}
+
+nlohmann::json MetricsRegistry::to_json() const {
+    nlohmann::json routes = nlohmann::json::object();
+    for (const auto& [name, metrics] : routes_) {
+        routes[name] = route_to_json(*metrics, resource_accounting_);
+    }
+    nlohmann::json priorities = nlohmann::json::object();
+    for (auto priority : {RequestPriority::Normal, RequestPriority::Urgent}) {
+        priorities[request_priority_name(priority)] =
+            route_to_json(priorities_[static_cast<std::size_t>(priority)], resource_accounting_);
+    }
+
+    return nlohmann::json{
+        {"resource_accounting", resource_accounting_},
+        {"alloc_tracking", resource_accounting_ && alloc_tracking_available()},
+        {"routes", routes},
+        {"priorities", priorities}
+    };
+}
+
+RequestScope::RequestScope(const MetricsRegistry& registry, RouteMetrics& route)
+    : route_(route),
+      sampled_(registry.resource_accounting()),
+      started_at_(std::chrono::steady_clock::now()) {
+    if (sampled_) {
+        cpu_started_ns_ = thread_cpu_ns();
+        alloc_started_ = thread_alloc_snapshot();
+    }
+}
+
+void RequestScope::finish(int status) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - started_at_).count();
+    auto latency_ns = static_cast<std::uint64_t>(elapsed);
+
+    record(route_, status, latency_ns);
+    if (priority_) {
+        record(*priority_, status, latency_ns);
+    }
+
+    if (sampled_) {
+        auto alloc_now = thread_alloc_snapshot();
+        auto cpu_ns = thread_cpu_ns() - cpu_started_ns_;
+        AllocSnapshot allocated{alloc_now.count - alloc_started_.count, alloc_now.bytes - alloc_started_.bytes};
+        record_resources(route_, cpu_ns, allocated);
+        if (priority_) {
+            record_resources(*priority_, cpu_ns, allocated);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "alloc_tracking.h"
+#include "json.hpp"
+#include "request_context.h"
+
+struct RouteMetrics {
+    std::atomic<std::uint64_t> requests{0};
+    std::atomic<std::uint64_t> client_errors{0};
+    std::atomic<std::uint64_t> server_errors{0};
+    std::atomic<std::uint64_t> latency_ns{0};
+    std::atomic<std::uint64_t> max_latency_ns{0};
+    std::atomic<std::uint64_t> sampled_requests{0};
+    std::atomic<std::uint64_t> cpu_ns{0};
+    std::atomic<std::uint64_t> alloc_count{0};
+    std::atomic<std::uint64_t> alloc_bytes{0};
+};
+
+class MetricsRegistry {
+public:
+    explicit MetricsRegistry(bool resource_accounting);
+
+    // Routes are registered while the server is being set up; the returned
+    // reference stays valid for the lifetime of the registry.
+    RouteMetrics& route(const std::string& name);
+    // Latency of every request admitted with the given priority, across routes.
+    RouteMetrics& priority(RequestPriority priority);
+
+    bool resource_accounting() const { return resource_accounting_; }
+
+    nlohmann::json to_json() const;
+
+private:
+    bool resource_accounting_;
+    std::map<std::string, std::unique_ptr<RouteMetrics>> routes_;
+    RouteMetrics priorities_[2];
+};
+
+// Measures one request on the calling thread: wall-clock latency always, and
+// thread CPU time plus allocations when resource accounting is enabled.
+class RequestScope {
+public:
+    RequestScope(const MetricsRegistry& registry, RouteMetrics& route);
+    RequestScope(const RequestScope&) = delete;
+    RequestScope& operator=(const RequestScope&) = delete;
+
+    // Also records the request under its priority class.
+    void set_priority(RouteMetrics& priority) { priority_ = &priority; }
+
+    void finish(int status);
+
+private:
+    RouteMetrics& route_;
+    RouteMetrics* priority_{nullptr};
+    bool sampled_;
+    std::chrono::steady_clock::time_point started_at_;
+    std::uint64_t cpu_started_ns_{0};
+    AllocSnapshot alloc_started_{};
+};
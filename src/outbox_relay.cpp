@@ -0,0 +1,154 @@
+#include "outbox_relay.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include "httplib.h"
+#include "json.hpp"
+
+std::string outbox_event_to_ndjson(const OutboxEvent& event) {
+    // The payload is already JSON text and is embedded without re-parsing.
+    std::string line = "{\"id\":" + std::to_string(event.id) +
+                       ",\"type\":" + nlohmann::json(event.event_type).dump() +
+                       ",\"lot_id\":" + std::to_string(event.lot_id) +
+                       ",\"created_at\":" + nlohmann::json(event.created_at).dump() +
+                       ",\"payload\":" + event.payload + "}\n";
+    return line;
+}
+
+FileOutboxSink::FileOutboxSink(const std::string& path) {
+    if (path == "stdout") {
+        file_ = stdout;
+        return;
+    }
+    file_ = std::fopen(path.c_str(), "a");
+    if (!file_) {
+        throw std::runtime_error("Unable to open outbox file: " + path);
+    }
+    owns_file_ = true;
+}
+
+FileOutboxSink::~FileOutboxSink() {
+    if (owns_file_) {
+        std::fclose(file_);
+    }
+}
+
+void FileOutboxSink::publish(const std::vector<OutboxEvent>& events) {
+    for (const auto& event : events) {
+        auto line = outbox_event_to_ndjson(event);
+        if (std::fwrite(line.data(), 1, line.size(), file_) != line.size()) {
+            throw std::runtime_error("Failed to write outbox events");
+        }
+    }
+    if (std::fflush(file_) != 0) {
+        throw std::runtime_error("Failed to flush outbox events");
+    }
+}
+
+WebhookOutboxSink::WebhookOutboxSink(const std::string& url, std::chrono::milliseconds timeout)
+    : timeout_(timeout) {
+    auto scheme_end = url.find("://");
+    if (scheme_end == std::string::npos) {
+        throw std::invalid_argument("Outbox webhook URL must include a scheme: " + url);
+    }
+    auto path_start = url.find('/', scheme_end + 3);
+    if (path_start == std::string::npos) {
+        origin_ = url;
+        path_ = "/";
+    } else {
+        origin_ = url.substr(0, path_start);
+        path_ = url.substr(path_start);
+    }
+}
+
+void WebhookOutboxSink::publish(const std::vector<OutboxEvent>& events) {
+    std::string body;
+    for (const auto& event : events) {
+        body += outbox_event_to_ndjson(event);
+    }
+
+    httplib::Client client(origin_);
+    client.set_connection_timeout(timeout_);
+    client.set_read_timeout(timeout_);
+    client.set_write_timeout(timeout_);
+    auto response = client.Post(path_, body, "application/x-ndjson");
+    if (!response) {
+        throw std::runtime_error("Outbox webhook unreachable");
+    }
+    if (response->status < 200 || response->status >= 300) {
+        throw std::runtime_error("Outbox webhook rejected batch: " + std::to_string(response->status));
+    }
+}
+
+std::unique_ptr<OutboxSink> make_outbox_sink(const std::string& spec, std::chrono::milliseconds timeout) {
+    if (spec == "stdout") {
+        return std::make_unique<FileOutboxSink>(spec);
+    }
+    if (spec.rfind("file:", 0) == 0) {
+        return std::make_unique<FileOutboxSink>(spec.substr(5));
+    }
+    if (spec.rfind("http://", 0) == 0) {
+        return std::make_unique<WebhookOutboxSink>(spec, timeout);
+    }
+    if (spec.rfind("https://", 0) == 0) {
+        // The service is built without CPPHTTPLIB_OPENSSL_SUPPORT; fail at startup
+        // rather than on the first publish.
+        throw std::invalid_argument("https:// outbox sinks are not supported; terminate TLS in a local proxy: " + spec);
+    }
+    throw std::invalid_argument("Unsupported outbox sink: " + spec);
+}
+
+OutboxRelay::OutboxRelay(Database& database, std::unique_ptr<OutboxSink> sink, OutboxRelaySettings settings)
+    : database_(database), sink_(std::move(sink)), settings_(settings) {}
+
+OutboxRelay::~OutboxRelay() {
+    stop();
+}
+
+void OutboxRelay::start() {
+    if (worker_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+    }
+    worker_ = std::thread([this] { run(); });
+}
+
+void OutboxRelay::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+bool OutboxRelay::wait_for(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return !wake_.wait_for(lock, duration, [this] { return stopping_; });
+}
+
+void OutboxRelay::run() {
+    auto publish = [this](const std::vector<OutboxEvent>& events) { sink_->publish(events); };
+    for (;;) {
+        std::chrono::milliseconds pause = settings_.poll_interval;
+        try {
+            int published = database_.relay_outbox(settings_.batch_size, publish);
+            if (published >= settings_.batch_size) {
+                pause = std::chrono::milliseconds(0);
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << "Outbox relay failed: " << ex.what() << std::endl;
+            pause = settings_.error_backoff;
+        }
+        if (!wait_for(pause)) {
+            return;
+        }
+    }
+}
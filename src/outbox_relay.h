@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "database.h"
+
+class OutboxSink {
+public:
+    virtual ~OutboxSink() = default;
+
+    // Delivers a batch in order; throws if the batch could not be delivered.
+    // Events of one lot arrive in the order their transactions committed;
+    // events of different lots carry no ordering guarantee, and ids are not
+    // contiguous. A batch that failed part-way is delivered again in full.
+    virtual void publish(const std::vector<OutboxEvent>& events) = 0;
+};
+
+// Appends events as NDJSON to stdout or a file.
+class FileOutboxSink : public OutboxSink {
+public:
+    explicit FileOutboxSink(const std::string& path);
+    ~FileOutboxSink() override;
+
+    void publish(const std::vector<OutboxEvent>& events) override;
+
+private:
+    std::FILE* file_{nullptr};
+    bool owns_file_{false};
+};
+
+// POSTs each batch as an NDJSON body to a webhook; any non-2xx response is a failure.
+class WebhookOutboxSink : public OutboxSink {
+public:
+    WebhookOutboxSink(const std::string& url, std::chrono::milliseconds timeout);
+
+    void publish(const std::vector<OutboxEvent>& events) override;
+
+private:
+    std::string origin_;
+    std::string path_;
+    std::chrono::milliseconds timeout_;
+};
+
+// Builds a sink from "stdout", "file:<path>" or an http(s) URL.
+std::unique_ptr<OutboxSink> make_outbox_sink(const std::string& spec, std::chrono::milliseconds timeout);
+
+std::string outbox_event_to_ndjson(const OutboxEvent& event);
+
+struct OutboxRelaySettings {
+    int batch_size{200};
+    std::chrono::milliseconds poll_interval{500};
+    std::chrono::milliseconds error_backoff{5000};
+};
+
+// Background thread that drains the outbox table into a sink in id order.
+// Every writer of a lot holds its lot_prices row lock from before it enqueues
+// until it commits, so one lot's ids follow commit order. Across lots a
+// transaction that commits late can still hold a lower id than events that
+// were already relayed; it goes out with a later batch.
+class OutboxRelay {
+public:
+    OutboxRelay(Database& database, std::unique_ptr<OutboxSink> sink, OutboxRelaySettings settings);
+    ~OutboxRelay();
+
+    OutboxRelay(const OutboxRelay&) = delete;
+    OutboxRelay& operator=(const OutboxRelay&) = delete;
+
+    void start();
+    void stop();
+
+private:
+    void run();
+    bool wait_for(std::chrono::milliseconds duration);
+
+    Database& database_;
+    std::unique_ptr<OutboxSink> sink_;
+    OutboxRelaySettings settings_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_{false};
+    std::thread worker_;
+};
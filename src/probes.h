@@ -0,0 +1,31 @@
+#pragma once
+
+// USDT tracepoints under the "auction" provider, for bpftrace/bcc, e.g.
+//   bpftrace -l 'usdt:/app/build/auction_service:auction:*'
+// A probe site is a single nop plus an ELF note until a tracer attaches.
+// Without <sys/sdt.h> (systemtap-sdt-dev) the probes compile to nothing.
+//
+//   request__start(route, lot_id)         request__end(route, lot_id, status)
+//   auth__start(method)                   auth__end(method, http_status)
+//   db__start(method, lot_id)             db__end(method, lot_id)
+//   bid__lock__start(lot_id)              bid__lock__acquired(lot_id)
+//   serialize__start(status)              serialize__end(status, bytes)
+//
+// lot_id is -1 when the operation is not about a single lot.
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define AUCTION_HAVE_USDT 1
+#endif
+#endif
+
+#ifdef AUCTION_HAVE_USDT
+#define AUCTION_PROBE1(name, a) DTRACE_PROBE1(auction, name, a)
+#define AUCTION_PROBE2(name, a, b) DTRACE_PROBE2(auction, name, a, b)
+#define AUCTION_PROBE3(name, a, b, c) DTRACE_PROBE3(auction, name, a, b, c)
+#else
+#define AUCTION_PROBE1(name, a) do { (void)(a); } while (0)
+#define AUCTION_PROBE2(name, a, b) do { (void)(a); (void)(b); } while (0)
+#define AUCTION_PROBE3(name, a, b, c) do { (void)(a); (void)(b); (void)(c); } while (0)
+#endif
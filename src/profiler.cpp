@@ -0,0 +1,280 @@
+#include "profiler.h"
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr int kMaxDepth = 64;
+constexpr std::size_t kMaxSamples = 32768;
+
+// frames[0] is the interrupted instruction, the rest are return addresses.
+struct Sample {
+    int depth;
+    void* frames[kMaxDepth];
+};
+
+struct SampleBuffer {
+    std::unique_ptr<Sample[]> samples{new Sample[kMaxSamples]};
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::uint64_t> dropped{0};
+};
+
+std::atomic<SampleBuffer*> g_active_buffer{nullptr};
+std::atomic<int> g_handlers_running{0};
+std::atomic<bool> g_profile_running{false};
+std::once_flag g_install_once;
+
+// The mapping holding this thread's stack, found on its first sample.
+struct StackBounds {
+    std::uintptr_t low;
+    std::uintptr_t high;
+};
+thread_local StackBounds t_stack{0, 0};
+
+// Looks up the mapping containing `address` in /proc/self/maps with nothing
+// but open/read/close, which are async-signal-safe.
+bool find_mapping(std::uintptr_t address, StackBounds& bounds) {
+    const int fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    // Each line starts "low-high "; the rest is skipped.
+    std::uintptr_t range[2] = {0, 0};
+    int field = 0;
+    bool found = false;
+    char chunk[1024];
+    ssize_t count;
+    while (!found && (count = read(fd, chunk, sizeof(chunk))) > 0) {
+        for (ssize_t i = 0; i < count && !found; ++i) {
+            const char c = chunk[i];
+            if (c == '\n') {
+                range[0] = range[1] = 0;
+                field = 0;
+            } else if (field < 2 && (c == '-' || c == ' ')) {
+                if (++field == 2 && range[0] <= address && address < range[1]) {
+                    bounds = {range[0], range[1]};
+                    found = true;
+                }
+            } else if (field < 2) {
+                const int digit = c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+                range[field] = range[field] * 16 + static_cast<std::uintptr_t>(digit);
+            }
+        }
+    }
+    close(fd);
+    return found;
+}
+
+// Records the interrupted instruction, then follows the frame-pointer chain
+// (the service is built with -fno-omit-frame-pointer). A frame pointer is
+// only dereferenced if it is aligned, above the previous one and inside the
+// interrupted thread's stack, so code built without frame pointers ends or
+// garbles the walk instead of faulting.
+int walk_stack(const ucontext_t& context, void** frames) {
+#if defined(__x86_64__)
+    const auto pc = static_cast<std::uintptr_t>(context.uc_mcontext.gregs[REG_RIP]);
+    const auto sp = static_cast<std::uintptr_t>(context.uc_mcontext.gregs[REG_RSP]);
+    auto fp = static_cast<std::uintptr_t>(context.uc_mcontext.gregs[REG_RBP]);
+#elif defined(__aarch64__)
+    const auto pc = static_cast<std::uintptr_t>(context.uc_mcontext.pc);
+    const auto sp = static_cast<std::uintptr_t>(context.uc_mcontext.sp);
+    auto fp = static_cast<std::uintptr_t>(context.uc_mcontext.regs[29]);
+#else
+    (void)context;
+    (void)frames;
+    return 0;
+#endif
+#if defined(__x86_64__) || defined(__aarch64__)
+    int depth = 0;
+    frames[depth++] = reinterpret_cast<void*>(pc);
+    if (!(t_stack.low <= sp && sp < t_stack.high) && !find_mapping(sp, t_stack)) {
+        return depth;
+    }
+    // Both ABIs keep {caller's frame pointer, return address} at fp.
+    constexpr std::uintptr_t kRecordSize = 2 * sizeof(std::uintptr_t);
+    while (depth < kMaxDepth && fp >= sp && fp % alignof(std::uintptr_t) == 0 && fp <= t_stack.high - kRecordSize) {
+        const auto* record = reinterpret_cast<const std::uintptr_t*>(fp);
+        if (record[1] == 0) {
+            break;
+        }
+        frames[depth++] = reinterpret_cast<void*>(record[1]);
+        if (record[0] <= fp) {
+            break;
+        }
+        fp = record[0];
+    }
+    return depth;
+#endif
+}
+
+// Runs on arbitrary threads at arbitrary points, so it only touches the
+// preallocated buffer, thread-local state and async-signal-safe calls.
+void on_sigprof(int, siginfo_t*, void* context) {
+    const int saved_errno = errno;
+    g_handlers_running.fetch_add(1);
+    if (auto* buffer = g_active_buffer.load()) {
+        const auto index = buffer->next.fetch_add(1, std::memory_order_relaxed);
+        if (index < kMaxSamples) {
+            auto& sample = buffer->samples[index];
+            sample.depth = walk_stack(*static_cast<const ucontext_t*>(context), sample.frames);
+        } else {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    g_handlers_running.fetch_sub(1);
+    errno = saved_errno;
+}
+
+void install_handler() {
+    // The handler stays installed for the life of the process: SIGPROF's
+    // default action terminates it, and a tick may still be pending after the
+    // timer is disarmed.
+    struct sigaction action {};
+    action.sa_sigaction = on_sigprof;
+    action.sa_flags = SA_RESTART | SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) {
+        throw std::runtime_error(std::string("sigaction(SIGPROF) failed: ") + std::strerror(errno));
+    }
+}
+
+void set_profile_timer(int frequency_hz) {
+    itimerval timer{};
+    if (frequency_hz > 0) {
+        timer.it_interval.tv_usec = 1000000 / frequency_hz;
+        timer.it_value = timer.it_interval;
+    }
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        throw std::runtime_error(std::string("setitimer(ITIMER_PROF) failed: ") + std::strerror(errno));
+    }
+}
+
+std::string symbolize(void* frame, bool return_address) {
+    // Return addresses point past the call; look up the call instruction.
+    auto* lookup = static_cast<char*>(frame) - (return_address ? 1 : 0);
+    Dl_info info{};
+    char buffer[64];
+    if (dladdr(lookup, &info) == 0) {
+        std::snprintf(buffer, sizeof(buffer), "%p", frame);
+        return buffer;
+    }
+    std::string name;
+    if (info.dli_sname) {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        name = status == 0 && demangled ? demangled : info.dli_sname;
+        std::free(demangled);
+    } else {
+        const char* module = info.dli_fname ? std::strrchr(info.dli_fname, '/') : nullptr;
+        module = module ? module + 1 : (info.dli_fname ? info.dli_fname : "?");
+        std::snprintf(buffer, sizeof(buffer), "+0x%zx",
+                      static_cast<std::size_t>(static_cast<char*>(frame) - static_cast<char*>(info.dli_fbase)));
+        name = std::string(module) + buffer;
+    }
+    // ';' separates frames in the folded format.
+    std::replace(name.begin(), name.end(), ';', ':');
+    return name;
+}
+
+std::string fold(const SampleBuffer& buffer, std::size_t count) {
+    std::unordered_map<void*, std::string> symbols;
+    std::unordered_map<std::string, std::uint64_t> stacks;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto& sample = buffer.samples[i];
+        std::string stack;
+        for (int frame = sample.depth - 1; frame >= 0; --frame) {
+            auto* address = sample.frames[frame];
+            auto it = symbols.find(address);
+            if (it == symbols.end()) {
+                it = symbols.emplace(address, symbolize(address, frame != 0)).first;
+            }
+            if (!stack.empty()) {
+                stack += ';';
+            }
+            stack += it->second;
+        }
+        if (!stack.empty()) {
+            ++stacks[stack];
+        }
+    }
+
+    std::vector<std::pair<std::string, std::uint64_t>> sorted(stacks.begin(), stacks.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    std::string out;
+    for (const auto& [stack, samples] : sorted) {
+        out += stack;
+        out += ' ';
+        out += std::to_string(samples);
+        out += '\n';
+    }
+    return out;
+}
+
+} // namespace
+
+std::optional<ProfileResult> run_cpu_profile(const ProfileSettings& settings) {
+    if (g_profile_running.exchange(true)) {
+        return std::nullopt;
+    }
+    struct RunningGuard {
+        ~RunningGuard() { g_profile_running.store(false); }
+    } running_guard;
+
+    std::call_once(g_install_once, install_handler);
+
+    auto buffer = std::make_unique<SampleBuffer>();
+    const auto started = std::chrono::steady_clock::now();
+    const auto until = started + settings.duration;
+
+    g_active_buffer.store(buffer.get());
+    try {
+        set_profile_timer(settings.frequency_hz);
+        while (std::chrono::steady_clock::now() < until) {
+            if (settings.cancelled && settings.cancelled()) {
+                break;
+            }
+            auto slice = std::min<std::chrono::steady_clock::duration>(std::chrono::milliseconds(100),
+                                                                       until - std::chrono::steady_clock::now());
+            std::this_thread::sleep_for(slice);
+        }
+        set_profile_timer(0);
+    } catch (...) {
+        g_active_buffer.store(nullptr);
+        throw;
+    }
+
+    // Detach the buffer, then wait out handlers that already picked it up.
+    g_active_buffer.store(nullptr);
+    while (g_handlers_running.load() != 0) {
+        std::this_thread::yield();
+    }
+
+    ProfileResult result;
+    const auto recorded = buffer->next.load(std::memory_order_relaxed);
+    result.samples = std::min(recorded, kMaxSamples);
+    result.dropped = buffer->dropped.load(std::memory_order_relaxed);
+    result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    result.folded_stacks = fold(*buffer, result.samples);
+    return result;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+struct ProfileSettings {
+    std::chrono::milliseconds duration{10000};
+    int frequency_hz{99};
+    // Polled while sampling; returning true ends the profile early.
+    std::function<bool()> cancelled;
+};
+
+struct ProfileResult {
+    // One line per distinct stack, "outer;...;inner count", as consumed by
+    // flamegraph.pl and speedscope.
+    std::string folded_stacks;
+    std::uint64_t samples{0};
+    std::uint64_t dropped{0};
+    std::chrono::milliseconds elapsed{0};
+};
+
+// Samples the call stacks of every thread in the process using ITIMER_PROF,
+// which delivers SIGPROF to whichever thread is burning CPU. Stacks are
+// unwound through frame pointers, so callers inside libraries built without
+// them may be cut short. Only one profile runs at a time; returns
+// std::nullopt if another one is already in progress.
+std::optional<ProfileResult> run_cpu_profile(const ProfileSettings& settings);
@@ -0,0 +1,135 @@
+#include "query_watchdog.h"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <libpq-fe.h>
+#include <pqxx/pqxx>
+
+#include "request_context.h"
+
+QueryWatchdog::Registration::~Registration() {
+    if (watchdog_) {
+        watchdog_->unregister(entry_);
+    }
+}
+
+QueryWatchdog::Registration::Registration(Registration&& other) noexcept
+    : watchdog_(other.watchdog_), entry_(other.entry_) {
+    other.watchdog_ = nullptr;
+}
+
+QueryWatchdog::QueryWatchdog(std::chrono::milliseconds poll_interval)
+    : poll_interval_(poll_interval) {
+    worker_ = std::thread([this] { run(); });
+}
+
+QueryWatchdog::~QueryWatchdog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+}
+
+QueryWatchdog::Registration QueryWatchdog::watch(pqxx::connection& connection) {
+    auto* context = current_request();
+    if (!context) {
+        return {};
+    }
+    return add([&connection] { connection.cancel_query(); }, *context);
+}
+
+QueryWatchdog::Registration QueryWatchdog::watch(PGconn* connection, const RequestContext& context) {
+    // PQgetCancel reads connection state, so take it here rather than on the
+    // watchdog thread; PQcancel on the copy is safe from any thread.
+    std::shared_ptr<PGcancel> cancel(PQgetCancel(connection), PQfreeCancel);
+    if (!cancel) {
+        return {};
+    }
+    return add([cancel] {
+        char error[256];
+        if (!PQcancel(cancel.get(), error, sizeof(error))) {
+            throw std::runtime_error(error);
+        }
+    }, context);
+}
+
+QueryWatchdog::Registration QueryWatchdog::add(std::function<void()> cancel, const RequestContext& context) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_front(Entry{std::move(cancel), context.client_gone, context.deadline});
+    return Registration(this, entries_.begin());
+}
+
+void QueryWatchdog::unregister(std::list<Entry>::iterator entry) {
+    // Wait out a scan that may be cancelling this entry, so the connection is
+    // never touched after it goes back to the pool.
+    std::unique_lock<std::mutex> lock(mutex_);
+    scan_done_.wait(lock, [&entry] { return !entry->in_flight; });
+    entries_.erase(entry);
+}
+
+nlohmann::json QueryWatchdog::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nlohmann::json{
+        {"watched", entries_.size()},
+        {"cancelled_client_gone", cancelled_client_gone_.load(std::memory_order_relaxed)},
+        {"cancelled_deadline", cancelled_deadline_.load(std::memory_order_relaxed)}
+    };
+}
+
+void QueryWatchdog::run() {
+    struct Candidate {
+        std::list<Entry>::iterator entry;
+        bool past_deadline;
+    };
+    std::vector<Candidate> candidates;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!wake_.wait_for(lock, poll_interval_, [this] { return stopping_; })) {
+        auto now = std::chrono::steady_clock::now();
+        candidates.clear();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->cancelled) {
+                continue;
+            }
+            bool past_deadline = now >= it->deadline;
+            if (!past_deadline && !it->client_gone) {
+                continue;
+            }
+            it->in_flight = true;
+            candidates.push_back(Candidate{it, past_deadline});
+        }
+        if (candidates.empty()) {
+            continue;
+        }
+
+        // client_gone() and PQcancel can block on the network; neither may
+        // hold up watch()/unregister() on every other database call.
+        lock.unlock();
+        for (auto& candidate : candidates) {
+            auto& entry = *candidate.entry;
+            bool client_gone = !candidate.past_deadline && entry.client_gone();
+            if (!candidate.past_deadline && !client_gone) {
+                continue;
+            }
+            entry.cancelled = true;
+            try {
+                entry.cancel();
+            } catch (const std::exception& ex) {
+                std::cerr << "Failed to cancel query: " << ex.what() << std::endl;
+                continue;
+            }
+            (candidate.past_deadline ? cancelled_deadline_ : cancelled_client_gone_)
+                .fetch_add(1, std::memory_order_relaxed);
+        }
+        lock.lock();
+        for (auto& candidate : candidates) {
+            candidate.entry->in_flight = false;
+        }
+        scan_done_.notify_all();
+    }
+}
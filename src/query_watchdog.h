@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include "json.hpp"
+
+namespace pqxx {
+class connection;
+}
+
+struct pg_conn;
+typedef struct pg_conn PGconn;
+struct RequestContext;
+
+// Background thread that cancels the running Postgres query of a request whose
+// client has disconnected or whose deadline has passed, so the transaction
+// rolls back and the pooled connection is returned without waiting for the
+// query (or a row lock) to finish on its own.
+class QueryWatchdog {
+private:
+    struct Entry {
+        std::function<void()> cancel;
+        std::function<bool()> client_gone;
+        std::chrono::steady_clock::time_point deadline;
+        bool cancelled{false};
+        // Set while the scan checks or cancels this entry outside the lock;
+        // unregister waits for it to clear before the connection is released.
+        bool in_flight{false};
+    };
+
+public:
+    class Registration {
+    public:
+        Registration() = default;
+        Registration(QueryWatchdog* watchdog, std::list<Entry>::iterator entry)
+            : watchdog_(watchdog), entry_(entry) {}
+        ~Registration();
+
+        Registration(Registration&& other) noexcept;
+        Registration(const Registration&) = delete;
+        Registration& operator=(const Registration&) = delete;
+        Registration& operator=(Registration&&) = delete;
+
+    private:
+        QueryWatchdog* watchdog_{nullptr};
+        std::list<Entry>::iterator entry_{};
+    };
+
+    explicit QueryWatchdog(std::chrono::milliseconds poll_interval);
+    ~QueryWatchdog();
+
+    QueryWatchdog(const QueryWatchdog&) = delete;
+    QueryWatchdog& operator=(const QueryWatchdog&) = delete;
+
+    // Watches `connection` on behalf of the request served by the calling
+    // thread until the registration is destroyed. A no-op outside of a request.
+    Registration watch(pqxx::connection& connection);
+    // Watches a connection driven by AsyncDatabase on behalf of `context`,
+    // which must outlive the registration. Call from the thread that owns
+    // `connection`.
+    Registration watch(PGconn* connection, const RequestContext& context);
+
+    nlohmann::json stats() const;
+
+private:
+    Registration add(std::function<void()> cancel, const RequestContext& context);
+    void run();
+    void unregister(std::list<Entry>::iterator entry);
+
+    std::chrono::milliseconds poll_interval_;
+
+    mutable std::mutex mutex_;
+    std::list<Entry> entries_;
+    std::condition_variable wake_;
+    std::condition_variable scan_done_;
+    bool stopping_{false};
+
+    std::atomic<std::uint64_t> cancelled_client_gone_{0};
+    std::atomic<std::uint64_t> cancelled_deadline_{0};
+
+    std::thread worker_;
+};
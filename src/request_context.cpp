@@ -0,0 +1,77 @@
+#include "request_context.h"
+
+namespace {
+
+thread_local RequestContext* t_current_request = nullptr;
+
+} // namespace
+
+const char* request_phase_name(RequestPhase phase) {
+    switch (phase) {
+        case RequestPhase::Auth:
+            return "auth";
+        case RequestPhase::Database:
+            return "db";
+        case RequestPhase::Serialize:
+            return "serialize";
+        default:
+            return "unknown";
+    }
+}
+
+const char* request_priority_name(RequestPriority priority) {
+    return priority == RequestPriority::Urgent ? "urgent" : "normal";
+}
+
+std::optional<std::chrono::milliseconds> RequestContext::remaining() const {
+    if (!has_deadline()) {
+        return std::nullopt;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+        return std::chrono::milliseconds(0);
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+}
+
+RequestContext* current_request() {
+    return t_current_request;
+}
+
+void ensure_request_alive() {
+    auto* context = t_current_request;
+    if (!context) {
+        return;
+    }
+    if (context->has_deadline() && std::chrono::steady_clock::now() >= context->deadline) {
+        throw DeadlineExceededError("Request deadline exceeded");
+    }
+    if (context->client_gone && context->client_gone()) {
+        throw ClientDisconnectedError("Client closed the connection");
+    }
+}
+
+RequestContextScope::RequestContextScope(RequestContext& context)
+    : previous_(t_current_request) {
+    t_current_request = &context;
+}
+
+RequestContextScope::~RequestContextScope() {
+    t_current_request = previous_;
+}
+
+PhaseTimer::PhaseTimer(RequestPhase phase)
+    : context_(t_current_request), phase_(phase) {
+    if (context_) {
+        started_at_ = std::chrono::steady_clock::now();
+    }
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (!context_) {
+        return;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - started_at_).count();
+    context_->phase_ns[static_cast<std::size_t>(phase_)] += static_cast<std::uint64_t>(elapsed);
+}
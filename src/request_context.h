@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+enum class RequestPhase : std::size_t {
+    Auth,
+    Database,
+    Serialize,
+    Count
+};
+
+constexpr std::size_t kRequestPhaseCount = static_cast<std::size_t>(RequestPhase::Count);
+
+const char* request_phase_name(RequestPhase phase);
+
+// Urgent requests (bids on lots about to close) are admitted ahead of normal
+// ones by the bulkheads and may use the connections reserved for them.
+enum class RequestPriority {
+    Normal,
+    Urgent
+};
+
+const char* request_priority_name(RequestPriority priority);
+
+class DeadlineExceededError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+class ClientDisconnectedError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Per-request annotations collected on the worker thread that serves the request.
+struct RequestContext {
+    std::string_view route;
+    std::chrono::steady_clock::time_point started_at{std::chrono::steady_clock::now()};
+    std::chrono::steady_clock::time_point deadline{std::chrono::steady_clock::time_point::max()};
+    std::function<bool()> client_gone;
+    int lot_id{-1};
+    RequestPriority priority{RequestPriority::Normal};
+    std::string error_code;
+    std::array<std::uint64_t, kRequestPhaseCount> phase_ns{};
+
+    bool has_deadline() const { return deadline != std::chrono::steady_clock::time_point::max(); }
+
+    // Time left until the deadline, clamped at zero; std::nullopt without a deadline.
+    std::optional<std::chrono::milliseconds> remaining() const;
+};
+
+// Returns the context of the request being served on this thread, or nullptr
+// outside of a request (startup, background threads).
+RequestContext* current_request();
+
+// Throws DeadlineExceededError or ClientDisconnectedError when the current
+// request should be abandoned. A no-op outside of a request.
+void ensure_request_alive();
+
+class RequestContextScope {
+public:
+    explicit RequestContextScope(RequestContext& context);
+    ~RequestContextScope();
+
+    RequestContextScope(const RequestContextScope&) = delete;
+    RequestContextScope& operator=(const RequestContextScope&) = delete;
+
+private:
+    RequestContext* previous_;
+};
+
+// Adds the lifetime of the timer to the given phase of the current request.
+class PhaseTimer {
+public:
+    explicit PhaseTimer(RequestPhase phase);
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    RequestContext* context_;
+    RequestPhase phase_;
+    std::chrono::steady_clock::time_point started_at_;
+};
@@ -0,0 +1,395 @@
+#include "token_verifier.h"
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include "httplib.h"
+
+namespace {
+
+constexpr char kBase64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr char kBase64UrlAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+constexpr std::size_t kEd25519KeySize = 32;
+
+int base64_value(char c, bool url) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == (url ? '-' : '+')) {
+        return 62;
+    }
+    if (c == (url ? '_' : '/')) {
+        return 63;
+    }
+    return -1;
+}
+
+std::string encode_base64(const std::string& data, const char* alphabet, bool pad) {
+    std::string out;
+    out.reserve((data.size() + 2) / 3 * 4);
+    std::uint32_t buffer = 0;
+    int bits = 0;
+    for (unsigned char c : data) {
+        buffer = (buffer << 8) | c;
+        bits += 8;
+        while (bits >= 6) {
+            bits -= 6;
+            out.push_back(alphabet[(buffer >> bits) & 0x3F]);
+        }
+    }
+    if (bits > 0) {
+        out.push_back(alphabet[(buffer << (6 - bits)) & 0x3F]);
+    }
+    while (pad && out.size() % 4 != 0) {
+        out.push_back('=');
+    }
+    return out;
+}
+
+bool decode_base64(std::string text, std::string& out, bool url) {
+    while (!text.empty() && text.back() == '=') {
+        text.pop_back();
+    }
+    if (text.size() % 4 == 1) {
+        return false;
+    }
+    out.clear();
+    out.reserve(text.size() * 3 / 4);
+    std::uint32_t buffer = 0;
+    int bits = 0;
+    for (char c : text) {
+        int value = base64_value(c, url);
+        if (value < 0) {
+            return false;
+        }
+        buffer = (buffer << 6) | static_cast<std::uint32_t>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+struct PkeyDeleter {
+    void operator()(EVP_PKEY* key) const { EVP_PKEY_free(key); }
+};
+using PkeyPtr = std::unique_ptr<EVP_PKEY, PkeyDeleter>;
+
+struct MdCtxDeleter {
+    void operator()(EVP_MD_CTX* context) const { EVP_MD_CTX_free(context); }
+};
+using MdCtxPtr = std::unique_ptr<EVP_MD_CTX, MdCtxDeleter>;
+
+std::string hmac_sha256(const std::string& key, const std::string& data) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    if (!HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+              reinterpret_cast<const unsigned char*>(data.data()), data.size(), digest, &length)) {
+        throw std::runtime_error("HMAC-SHA256 failed");
+    }
+    return std::string(reinterpret_cast<const char*>(digest), length);
+}
+
+PkeyPtr load_ed25519_key(const std::string& raw, bool is_private) {
+    if (raw.size() != kEd25519KeySize) {
+        throw std::runtime_error("Ed25519 keys must be 32 bytes");
+    }
+    const auto* bytes = reinterpret_cast<const unsigned char*>(raw.data());
+    PkeyPtr key(is_private ? EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, nullptr, bytes, raw.size())
+                           : EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, nullptr, bytes, raw.size()));
+    if (!key) {
+        throw std::runtime_error("Failed to load Ed25519 key");
+    }
+    return key;
+}
+
+std::string encode_unsigned(const std::string& algorithm, const nlohmann::json& claims) {
+    nlohmann::json header{{"alg", algorithm}, {"typ", "JWT"}};
+    return base64url_encode(header.dump()) + "." + base64url_encode(claims.dump());
+}
+
+bool claim_allows(const nlohmann::json& claims, const char* name, const std::string& value) {
+    auto it = claims.find(name);
+    if (it == claims.end()) {
+        return false;
+    }
+    if (it->is_string()) {
+        return *it == "*" || *it == value;
+    }
+    if (it->is_array()) {
+        for (const auto& entry : *it) {
+            if (entry.is_string() && (entry == "*" || entry == value)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+struct TokenVerifier::KeySet {
+    std::string hmac_secret;
+    PkeyPtr ed25519;
+};
+
+std::string base64url_encode(const std::string& data) {
+    return encode_base64(data, kBase64UrlAlphabet, false);
+}
+
+std::string base64_encode(const std::string& data) {
+    return encode_base64(data, kBase64Alphabet, true);
+}
+
+bool base64url_decode(const std::string& text, std::string& out) {
+    return decode_base64(text, out, true);
+}
+
+bool base64_decode(const std::string& text, std::string& out) {
+    return decode_base64(text, out, false);
+}
+
+std::string sign_token_hs256(const nlohmann::json& claims, const std::string& secret) {
+    auto signing_input = encode_unsigned("HS256", claims);
+    return signing_input + "." + base64url_encode(hmac_sha256(secret, signing_input));
+}
+
+std::string sign_token_ed25519(const nlohmann::json& claims, const std::string& private_key) {
+    auto key = load_ed25519_key(private_key, true);
+    auto signing_input = encode_unsigned("EdDSA", claims);
+
+    MdCtxPtr context(EVP_MD_CTX_new());
+    unsigned char signature[64];
+    std::size_t signature_size = sizeof(signature);
+    if (!context || EVP_DigestSignInit(context.get(), nullptr, nullptr, nullptr, key.get()) != 1 ||
+        EVP_DigestSign(context.get(), signature, &signature_size,
+                       reinterpret_cast<const unsigned char*>(signing_input.data()), signing_input.size()) != 1) {
+        throw std::runtime_error("Ed25519 signing failed");
+    }
+    return signing_input + "." +
+           base64url_encode(std::string(reinterpret_cast<const char*>(signature), signature_size));
+}
+
+std::string ed25519_public_key_from_seed(const std::string& private_key) {
+    auto key = load_ed25519_key(private_key, true);
+    unsigned char public_key[kEd25519KeySize];
+    std::size_t size = sizeof(public_key);
+    if (EVP_PKEY_get_raw_public_key(key.get(), public_key, &size) != 1) {
+        throw std::runtime_error("Failed to derive Ed25519 public key");
+    }
+    return std::string(reinterpret_cast<const char*>(public_key), size);
+}
+
+TokenVerifier::TokenVerifier(TokenVerifierSettings settings)
+    : settings_(std::move(settings)), keys_(std::make_shared<const KeySet>()) {}
+
+TokenVerifier::~TokenVerifier() {
+    stop();
+}
+
+void TokenVerifier::start() {
+    if (worker_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+    }
+    worker_ = std::thread([this] { run(); });
+}
+
+void TokenVerifier::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void TokenVerifier::update_keys(const TokenKeys& keys) {
+    auto next = std::make_shared<KeySet>();
+    next->hmac_secret = keys.hmac_secret;
+    if (!keys.ed25519_public_key.empty()) {
+        next->ed25519 = load_ed25519_key(keys.ed25519_public_key, false);
+    }
+    std::shared_ptr<const KeySet> published = std::move(next);
+    std::atomic_store(&keys_, published);
+    // Fetch the deny-list right away if local verification was just enabled.
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        keys_changed_ = true;
+    }
+    wake_.notify_all();
+}
+
+bool TokenVerifier::wait_for(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.wait_for(lock, duration, [this] { return stopping_ || keys_changed_; });
+    keys_changed_ = false;
+    return !stopping_;
+}
+
+void TokenVerifier::run() {
+    do {
+        auto keys = std::atomic_load(&keys_);
+        if (keys->hmac_secret.empty() && !keys->ed25519) {
+            continue;
+        }
+        try {
+            refresh_deny_list();
+        } catch (const std::exception& ex) {
+            deny_list_failures_.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "Token deny-list refresh failed: " << ex.what() << std::endl;
+        }
+    } while (wait_for(settings_.refresh_interval));
+}
+
+void TokenVerifier::refresh_deny_list() {
+    httplib::Client client(settings_.payment_service_url);
+    client.set_connection_timeout(settings_.fetch_timeout);
+    client.set_read_timeout(settings_.fetch_timeout);
+    auto response = client.Get("/token/revoked");
+    if (!response) {
+        throw std::runtime_error("payment service unreachable");
+    }
+    if (response->status != 200) {
+        throw std::runtime_error("payment service returned HTTP " + std::to_string(response->status));
+    }
+    auto body = nlohmann::json::parse(response->body);
+    auto next = std::make_shared<DenyList>();
+    for (const auto& id : body.at("revoked")) {
+        next->revoked.insert(id.get<std::string>());
+    }
+    next->fetched_at = std::chrono::steady_clock::now();
+    std::shared_ptr<const DenyList> published = std::move(next);
+    std::atomic_store(&deny_list_, published);
+}
+
+SignedTokenResult TokenVerifier::verify(const std::string& token, const std::string& service,
+                                        const std::string& method) const {
+    auto first_dot = token.find('.');
+    auto second_dot = first_dot == std::string::npos ? std::string::npos : token.find('.', first_dot + 1);
+    if (second_dot == std::string::npos || token.find('.', second_dot + 1) != std::string::npos) {
+        return {SignedTokenStatus::NotSigned, "Token is not signed"};
+    }
+    const auto keys = std::atomic_load(&keys_);
+    if (keys->hmac_secret.empty() && !keys->ed25519) {
+        return {SignedTokenStatus::NotSigned, "No token keys configured"};
+    }
+
+    auto reject = [this](SignedTokenStatus status, std::string message) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return SignedTokenResult{status, std::move(message)};
+    };
+    auto defer = [this](std::string message) {
+        deferred_.fetch_add(1, std::memory_order_relaxed);
+        return SignedTokenResult{SignedTokenStatus::Unverifiable, std::move(message)};
+    };
+
+    std::string header_json;
+    std::string claims_json;
+    std::string signature;
+    if (!base64url_decode(token.substr(0, first_dot), header_json) ||
+        !base64url_decode(token.substr(first_dot + 1, second_dot - first_dot - 1), claims_json) ||
+        !base64url_decode(token.substr(second_dot + 1), signature)) {
+        return defer("Token is not base64url");
+    }
+    // Opaque tokens may contain dots too; only a verified signature makes a
+    // token ours to reject.
+    auto header = nlohmann::json::parse(header_json, nullptr, false);
+    auto claims = nlohmann::json::parse(claims_json, nullptr, false);
+    if (!header.is_object() || !claims.is_object() || !header.contains("alg") || !header["alg"].is_string()) {
+        return defer("Token is not a JWT");
+    }
+
+    const auto signing_input = token.substr(0, second_dot);
+    const auto& algorithm = header["alg"].get_ref<const std::string&>();
+    if (algorithm == "HS256") {
+        if (keys->hmac_secret.empty()) {
+            return defer("No HMAC key configured");
+        }
+        auto expected = hmac_sha256(keys->hmac_secret, signing_input);
+        if (expected.size() != signature.size() ||
+            CRYPTO_memcmp(expected.data(), signature.data(), expected.size()) != 0) {
+            return reject(SignedTokenStatus::BadSignature, "Invalid token signature");
+        }
+    } else if (algorithm == "EdDSA") {
+        if (!keys->ed25519) {
+            return defer("No Ed25519 key configured");
+        }
+        MdCtxPtr context(EVP_MD_CTX_new());
+        if (!context || EVP_DigestVerifyInit(context.get(), nullptr, nullptr, nullptr, keys->ed25519.get()) != 1) {
+            return defer("Ed25519 verification unavailable");
+        }
+        if (EVP_DigestVerify(context.get(), reinterpret_cast<const unsigned char*>(signature.data()), signature.size(),
+                             reinterpret_cast<const unsigned char*>(signing_input.data()), signing_input.size()) != 1) {
+            return reject(SignedTokenStatus::BadSignature, "Invalid token signature");
+        }
+    } else {
+        return defer("Unsupported token algorithm");
+    }
+
+    auto expiry = claims.find("exp");
+    auto id = claims.find("jti");
+    if (expiry == claims.end() || !expiry->is_number() || id == claims.end() || !id->is_string()) {
+        return reject(SignedTokenStatus::Malformed, "Token must carry exp and jti claims");
+    }
+    if (expiry->get<double>() <= static_cast<double>(std::time(nullptr))) {
+        return reject(SignedTokenStatus::Expired, "Token has expired");
+    }
+    if (!claim_allows(claims, "svc", service)) {
+        return reject(SignedTokenStatus::WrongService, "Token is not valid for this service");
+    }
+    if (!claim_allows(claims, "methods", method)) {
+        return reject(SignedTokenStatus::MethodNotAllowed, "Token does not allow " + method);
+    }
+
+    // Only trust a local "yes" while revocations are reasonably current.
+    const auto deny_list = std::atomic_load(&deny_list_);
+    if (!deny_list || std::chrono::steady_clock::now() - deny_list->fetched_at > settings_.max_deny_list_age) {
+        return defer("Token deny-list is stale");
+    }
+    if (deny_list->revoked.count(id->get_ref<const std::string&>()) != 0) {
+        return reject(SignedTokenStatus::Revoked, "Token has been revoked");
+    }
+    verified_.fetch_add(1, std::memory_order_relaxed);
+    return {SignedTokenStatus::Valid, "Allowed"};
+}
+
+nlohmann::json TokenVerifier::stats() const {
+    const auto keys = std::atomic_load(&keys_);
+    const auto deny_list = std::atomic_load(&deny_list_);
+    nlohmann::json deny_list_age = nullptr;
+    if (deny_list) {
+        deny_list_age = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() - deny_list->fetched_at)
+                            .count();
+    }
+    return {
+        {"hmac_key", !keys->hmac_secret.empty()},
+        {"ed25519_key", static_cast<bool>(keys->ed25519)},
+        {"verified", verified_.load(std::memory_order_relaxed)},
+        {"rejected", rejected_.load(std::memory_order_relaxed)},
+        {"deferred_to_network", deferred_.load(std::memory_order_relaxed)},
+        {"deny_list_entries", deny_list ? deny_list->revoked.size() : 0},
+        {"deny_list_age_ms", deny_list_age},
+        {"deny_list_failures", deny_list_failures_.load(std::memory_order_relaxed)}
+    };
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+#include "json.hpp"
+
+// Signed payment tokens are compact JWTs ("header.claims.signature", base64url)
+// signed with HS256 or EdDSA (Ed25519). Claims:
+//   exp      expiry, seconds since the Unix epoch (required)
+//   jti      token id, checked against the deny-list (required)
+//   svc      service the token is valid for, or "*"
+//   methods  array of method names, or ["*"]
+
+struct TokenKeys {
+    std::string hmac_secret;
+    // Raw 32-byte Ed25519 public key.
+    std::string ed25519_public_key;
+
+    bool empty() const { return hmac_secret.empty() && ed25519_public_key.empty(); }
+};
+
+struct TokenVerifierSettings {
+    // The deny-list is pulled from GET <payment_service_url>/token/revoked,
+    // which returns {"revoked": ["<jti>", ...]}.
+    std::string payment_service_url;
+    std::chrono::milliseconds refresh_interval{30000};
+    // Past this age the deny-list is not trusted and tokens go to the network check.
+    std::chrono::milliseconds max_deny_list_age{120000};
+    std::chrono::milliseconds fetch_timeout{5000};
+};
+
+enum class SignedTokenStatus {
+    NotSigned,
+    Unverifiable,
+    Valid,
+    Malformed,
+    BadSignature,
+    Expired,
+    WrongService,
+    MethodNotAllowed,
+    Revoked
+};
+
+struct SignedTokenResult {
+    SignedTokenStatus status;
+    std::string message;
+};
+
+std::string base64url_encode(const std::string& data);
+std::string base64_encode(const std::string& data);
+bool base64url_decode(const std::string& text, std::string& out);
+bool base64_decode(const std::string& text, std::string& out);
+
+std::string sign_token_hs256(const nlohmann::json& claims, const std::string& secret);
+// `private_key` is the raw 32-byte Ed25519 seed.
+std::string sign_token_ed25519(const nlohmann::json& claims, const std::string& private_key);
+// Derives the raw public key from a raw 32-byte Ed25519 seed.
+std::string ed25519_public_key_from_seed(const std::string& private_key);
+
+// Verifies signed tokens locally and keeps the revocation deny-list fresh by
+// polling the payment service. Tokens it cannot vouch for (unsigned, not a
+// decodable JWT, no key for their algorithm, or a stale deny-list) are left to
+// the network check.
+class TokenVerifier {
+public:
+    explicit TokenVerifier(TokenVerifierSettings settings);
+    ~TokenVerifier();
+
+    TokenVerifier(const TokenVerifier&) = delete;
+    TokenVerifier& operator=(const TokenVerifier&) = delete;
+
+    void start();
+    void stop();
+    // Throws std::runtime_error if a key cannot be loaded.
+    void update_keys(const TokenKeys& keys);
+
+    SignedTokenResult verify(const std::string& token, const std::string& service, const std::string& method) const;
+
+    nlohmann::json stats() const;
+
+private:
+    struct KeySet;
+    struct DenyList {
+        std::unordered_set<std::string> revoked;
+        std::chrono::steady_clock::time_point fetched_at;
+    };
+
+    void run();
+    bool wait_for(std::chrono::milliseconds duration);
+    void refresh_deny_list();
+
+    TokenVerifierSettings settings_;
+    std::shared_ptr<const KeySet> keys_;
+    std::shared_ptr<const DenyList> deny_list_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_{false};
+    // Set by update_keys() so the worker refreshes the deny-list at once.
+    bool keys_changed_{false};
+    std::thread worker_;
+
+    mutable std::atomic<std::uint64_t> verified_{0};
+    mutable std::atomic<std::uint64_t> rejected_{0};
+    mutable std::atomic<std::uint64_t> deferred_{0};
+    std::atomic<std::uint64_t> deny_list_failures_{0};
+};
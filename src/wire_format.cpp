@@ -0,0 +1,562 @@
+#include "wire_format.h"
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace {
+
+std::string_view trim(std::string_view value) {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        auto lower = [](char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; };
+        if (lower(a[i]) != lower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Media type without parameters, e.g. "application/msgpack" from
+// "application/msgpack; charset=binary".
+std::string_view media_type(std::string_view value) {
+    return trim(value.substr(0, value.find(';')));
+}
+
+std::optional<WireFormat> format_of(std::string_view type) {
+    if (iequals(type, "application/json")) {
+        return WireFormat::Json;
+    }
+    if (iequals(type, "application/msgpack") || iequals(type, "application/x-msgpack") ||
+        iequals(type, "application/vnd.msgpack")) {
+        return WireFormat::MessagePack;
+    }
+    if (iequals(type, "application/cbor")) {
+        return WireFormat::Cbor;
+    }
+    return std::nullopt;
+}
+
+double quality(std::string_view range) {
+    auto pos = range.find(';');
+    while (pos != std::string_view::npos) {
+        range.remove_prefix(pos + 1);
+        pos = range.find(';');
+        auto param = trim(range.substr(0, pos));
+        if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+            auto value = std::string(param.substr(2));
+            char* end = nullptr;
+            double q = std::strtod(value.c_str(), &end);
+            if (end == value.c_str() || q < 0.0 || q > 1.0) {
+                return 0.0;
+            }
+            return q;
+        }
+    }
+    return 1.0;
+}
+
+constexpr std::size_t kFormatCount = 3;
+
+// Floats go out as float32 whenever that loses nothing, as nlohmann does.
+bool fits_float(double value) {
+    return value >= static_cast<double>(std::numeric_limits<float>::lowest()) &&
+           value <= static_cast<double>(std::numeric_limits<float>::max()) &&
+           static_cast<double>(static_cast<float>(value)) == value;
+}
+
+template <typename T>
+auto bit_pattern(T value) {
+    std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t> out;
+    std::memcpy(&out, &value, sizeof(out));
+    return out;
+}
+
+class ByteWriter {
+public:
+    explicit ByteWriter(std::string& out) : out_(out) {}
+
+protected:
+    void byte(std::uint8_t value) { out_.push_back(static_cast<char>(value)); }
+
+    template <typename T>
+    void big_endian(T value) {
+        std::array<char, sizeof(T)> bytes;
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            bytes[sizeof(T) - 1 - i] = static_cast<char>(value & 0xff);
+            value = static_cast<T>(value >> 8);
+        }
+        out_.append(bytes.data(), bytes.size());
+    }
+
+    void raw(std::string_view value) { out_.append(value); }
+
+private:
+    std::string& out_;
+};
+
+class MessagePackWriter : public ByteWriter {
+public:
+    using ByteWriter::ByteWriter;
+
+    void array(std::size_t size) { container(size, 0x90, 0xdc); }
+    void map(std::size_t size) { container(size, 0x80, 0xde); }
+    void null() { byte(0xc0); }
+
+    void integer(std::int64_t value) {
+        if (value >= 0) {
+            if (value < 128) {
+                byte(static_cast<std::uint8_t>(value));
+            } else if (value <= 0xff) {
+                byte(0xcc);
+                byte(static_cast<std::uint8_t>(value));
+            } else if (value <= 0xffff) {
+                byte(0xcd);
+                big_endian(static_cast<std::uint16_t>(value));
+            } else if (value <= 0xffffffffLL) {
+                byte(0xce);
+                big_endian(static_cast<std::uint32_t>(value));
+            } else {
+                byte(0xcf);
+                big_endian(static_cast<std::uint64_t>(value));
+            }
+        } else if (value >= -32) {
+            byte(static_cast<std::uint8_t>(value));
+        } else if (value >= std::numeric_limits<std::int8_t>::min()) {
+            byte(0xd0);
+            byte(static_cast<std::uint8_t>(value));
+        } else if (value >= std::numeric_limits<std::int16_t>::min()) {
+            byte(0xd1);
+            big_endian(static_cast<std::uint16_t>(value));
+        } else if (value >= std::numeric_limits<std::int32_t>::min()) {
+            byte(0xd2);
+            big_endian(static_cast<std::uint32_t>(value));
+        } else {
+            byte(0xd3);
+            big_endian(static_cast<std::uint64_t>(value));
+        }
+    }
+
+    void number(double value) {
+        if (fits_float(value)) {
+            byte(0xca);
+            big_endian(bit_pattern(static_cast<float>(value)));
+        } else {
+            byte(0xcb);
+            big_endian(bit_pattern(value));
+        }
+    }
+
+    void string(std::string_view value) {
+        if (value.size() <= 31) {
+            byte(0xa0 | static_cast<std::uint8_t>(value.size()));
+        } else if (value.size() <= 0xff) {
+            byte(0xd9);
+            byte(static_cast<std::uint8_t>(value.size()));
+        } else if (value.size() <= 0xffff) {
+            byte(0xda);
+            big_endian(static_cast<std::uint16_t>(value.size()));
+        } else {
+            byte(0xdb);
+            big_endian(static_cast<std::uint32_t>(value.size()));
+        }
+        raw(value);
+    }
+
+private:
+    // fixarray/fixmap up to 15 entries, then the 16- and 32-bit forms.
+    void container(std::size_t size, std::uint8_t fix, std::uint8_t sized16) {
+        if (size <= 15) {
+            byte(fix | static_cast<std::uint8_t>(size));
+        } else if (size <= 0xffff) {
+            byte(sized16);
+            big_endian(static_cast<std::uint16_t>(size));
+        } else {
+            byte(sized16 + 1);
+            big_endian(static_cast<std::uint32_t>(size));
+        }
+    }
+};
+
+class CborWriter : public ByteWriter {
+public:
+    using ByteWriter::ByteWriter;
+
+    void array(std::size_t size) { head(4, size); }
+    void map(std::size_t size) { head(5, size); }
+    void null() { byte(0xf6); }
+
+    void integer(std::int64_t value) {
+        if (value >= 0) {
+            head(0, static_cast<std::uint64_t>(value));
+        } else {
+            head(1, static_cast<std::uint64_t>(-(value + 1)));
+        }
+    }
+
+    void number(double value) {
+        if (fits_float(value)) {
+            byte(0xfa);
+            big_endian(bit_pattern(static_cast<float>(value)));
+        } else {
+            byte(0xfb);
+            big_endian(bit_pattern(value));
+        }
+    }
+
+    void string(std::string_view value) {
+        head(3, value.size());
+        raw(value);
+    }
+
+private:
+    void head(std::uint8_t major, std::uint64_t value) {
+        const auto type = static_cast<std::uint8_t>(major << 5);
+        if (value <= 23) {
+            byte(type | static_cast<std::uint8_t>(value));
+        } else if (value <= 0xff) {
+            byte(type | 24);
+            byte(static_cast<std::uint8_t>(value));
+        } else if (value <= 0xffff) {
+            byte(type | 25);
+            big_endian(static_cast<std::uint16_t>(value));
+        } else if (value <= 0xffffffffULL) {
+            byte(type | 26);
+            big_endian(static_cast<std::uint32_t>(value));
+        } else {
+            byte(type | 27);
+            big_endian(value);
+        }
+    }
+};
+
+// Keys are written in sorted order, matching nlohmann's std::map objects.
+template <typename Writer>
+void write_lot(Writer& writer, const Lot& lot) {
+    auto nullable_string = [&writer](const std::optional<std::string>& value) {
+        if (value) {
+            writer.string(*value);
+        } else {
+            writer.null();
+        }
+    };
+    writer.map(8);
+    writer.string("auction_end_date");
+    writer.string(lot.auction_end_date);
+    writer.string("created_at");
+    writer.string(lot.created_at);
+    writer.string("current_price");
+    if (lot.current_price) {
+        writer.number(*lot.current_price);
+    } else {
+        writer.null();
+    }
+    writer.string("description");
+    nullable_string(lot.description);
+    writer.string("id");
+    writer.integer(lot.id);
+    writer.string("name");
+    writer.string(lot.name);
+    writer.string("owner_id");
+    nullable_string(lot.owner_id);
+    writer.string("start_price");
+    writer.number(lot.start_price);
+}
+
+// Appends JSON text for the columnar listing. Strings are escaped the way
+// nlohmann's serializer escapes them; Postgres only hands back valid UTF-8.
+class JsonColumnWriter {
+public:
+    explicit JsonColumnWriter(std::string& out) : out_(out) {}
+
+    void string(std::string_view value) {
+        out_.push_back('"');
+        std::size_t plain = 0;
+        for (std::size_t i = 0; i < value.size(); ++i) {
+            const auto c = static_cast<unsigned char>(value[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            out_.append(value.substr(plain, i - plain));
+            plain = i + 1;
+            switch (c) {
+                case '"':
+                    out_.append("\\\"");
+                    break;
+                case '\\':
+                    out_.append("\\\\");
+                    break;
+                case '\b':
+                    out_.append("\\b");
+                    break;
+                case '\f':
+                    out_.append("\\f");
+                    break;
+                case '\n':
+                    out_.append("\\n");
+                    break;
+                case '\r':
+                    out_.append("\\r");
+                    break;
+                case '\t':
+                    out_.append("\\t");
+                    break;
+                default: {
+                    static const char kHex[] = "0123456789abcdef";
+                    const char escaped[] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xf]};
+                    out_.append(escaped, sizeof(escaped));
+                }
+            }
+        }
+        out_.append(value.substr(plain));
+        out_.push_back('"');
+    }
+
+    void integer(int value) {
+        char buffer[16];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out_.append(buffer, result.ptr);
+    }
+
+    // Shortest round-trip form, keeping a fraction so clients still see a float.
+    void number(double value) {
+        if (!std::isfinite(value)) {
+            null();
+            return;
+        }
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        std::string_view text(buffer, static_cast<std::size_t>(result.ptr - buffer));
+        out_.append(text);
+        if (text.find_first_of(".e") == std::string_view::npos) {
+            out_.append(".0");
+        }
+    }
+
+    void null() { out_.append("null"); }
+
+    void raw(std::string_view text) { out_.append(text); }
+
+    // Writes `"key":[v0,v1,...]` with `write` called once per lot.
+    template <typename Write>
+    void column(std::string_view key, const std::vector<Lot>& lots, Write&& write) {
+        string(key);
+        out_.append(":[");
+        for (std::size_t i = 0; i < lots.size(); ++i) {
+            if (i > 0) {
+                out_.push_back(',');
+            }
+            write(lots[i]);
+        }
+        out_.push_back(']');
+    }
+
+private:
+    std::string& out_;
+};
+
+// Upper bound for one lot's fixed overhead: keys, headers and numbers.
+constexpr std::size_t kLotOverhead = 160;
+
+std::size_t estimated_size(const Lot& lot) {
+    return kLotOverhead + lot.name.size() + lot.created_at.size() + lot.auction_end_date.size() +
+           (lot.description ? lot.description->size() : 0) + (lot.owner_id ? lot.owner_id->size() : 0);
+}
+
+template <typename Writer>
+std::string write_lots(const std::vector<Lot>& lots) {
+    std::size_t size = 8;
+    for (const auto& lot : lots) {
+        size += estimated_size(lot);
+    }
+    std::string out;
+    out.reserve(size);
+    Writer writer(out);
+    writer.array(lots.size());
+    for (const auto& lot : lots) {
+        write_lot(writer, lot);
+    }
+    return out;
+}
+
+template <typename Writer>
+std::string write_one(const Lot& lot) {
+    std::string out;
+    out.reserve(estimated_size(lot));
+    Writer writer(out);
+    write_lot(writer, lot);
+    return out;
+}
+
+} // namespace
+
+const char* content_type(WireFormat format) {
+    switch (format) {
+        case WireFormat::Json:
+            return "application/json";
+        case WireFormat::MessagePack:
+            return "application/msgpack";
+        case WireFormat::Cbor:
+            return "application/cbor";
+    }
+    return "application/json";
+}
+
+std::optional<WireFormat> negotiate_format(std::string_view accept) {
+    if (trim(accept).empty()) {
+        return WireFormat::Json;
+    }
+
+    // For each format, the q-value and position of the most specific range
+    // that matches it (exact type, then application/*, then */*).
+    struct Preference {
+        int specificity{-1};
+        double q{0.0};
+        std::size_t position{0};
+    };
+    std::array<Preference, kFormatCount> preferences;
+
+    std::size_t position = 0;
+    while (!accept.empty()) {
+        auto comma = accept.find(',');
+        auto range = accept.substr(0, comma);
+        accept = comma == std::string_view::npos ? std::string_view() : accept.substr(comma + 1);
+        auto type = media_type(range);
+        if (type.empty()) {
+            continue;
+        }
+        const double q = quality(range);
+
+        auto consider = [&](std::size_t index, int specificity) {
+            auto& preference = preferences[index];
+            if (specificity > preference.specificity) {
+                preference = Preference{specificity, q, position};
+            }
+        };
+        if (auto format = format_of(type)) {
+            consider(static_cast<std::size_t>(*format), 2);
+        } else if (iequals(type, "application/*") || iequals(type, "*/*")) {
+            const int specificity = iequals(type, "*/*") ? 0 : 1;
+            for (std::size_t index = 0; index < kFormatCount; ++index) {
+                consider(index, specificity);
+            }
+        }
+        ++position;
+    }
+
+    std::optional<WireFormat> best;
+    const Preference* best_preference = nullptr;
+    for (std::size_t index = 0; index < kFormatCount; ++index) {
+        const auto& preference = preferences[index];
+        if (preference.specificity < 0 || preference.q <= 0.0) {
+            continue;
+        }
+        if (!best_preference || preference.q > best_preference->q ||
+            (preference.q == best_preference->q && preference.position < best_preference->position)) {
+            best = static_cast<WireFormat>(index);
+            best_preference = &preference;
+        }
+    }
+    return best;
+}
+
+WireFormat body_format(std::string_view content_type) {
+    return format_of(media_type(content_type)).value_or(WireFormat::Json);
+}
+
+std::string encode(const Lot& lot, WireFormat format) {
+    switch (format) {
+        case WireFormat::Json:
+            break;
+        case WireFormat::MessagePack:
+            return write_one<MessagePackWriter>(lot);
+        case WireFormat::Cbor:
+            return write_one<CborWriter>(lot);
+    }
+    return lot_to_json(lot).dump();
+}
+
+std::string encode(const std::vector<Lot>& lots, WireFormat format) {
+    switch (format) {
+        case WireFormat::Json:
+            break;
+        case WireFormat::MessagePack:
+            return write_lots<MessagePackWriter>(lots);
+        case WireFormat::Cbor:
+            return write_lots<CborWriter>(lots);
+    }
+    return lots_to_json(lots).dump();
+}
+
+std::string encode_columnar(const std::vector<Lot>& lots) {
+    std::size_t size = 128;
+    for (const auto& lot : lots) {
+        size += estimated_size(lot);
+    }
+    std::string out;
+    out.reserve(size);
+    JsonColumnWriter writer(out);
+    auto nullable_string = [&writer](const std::optional<std::string>& value) {
+        if (value) {
+            writer.string(*value);
+        } else {
+            writer.null();
+        }
+    };
+
+    writer.raw("{\"format\":\"columnar\",\"count\":");
+    writer.integer(static_cast<int>(lots.size()));
+    writer.raw(",\"columns\":{");
+    writer.column("id", lots, [&](const Lot& lot) { writer.integer(lot.id); });
+    writer.raw(",");
+    writer.column("name", lots, [&](const Lot& lot) { writer.string(lot.name); });
+    writer.raw(",");
+    writer.column("description", lots, [&](const Lot& lot) { nullable_string(lot.description); });
+    writer.raw(",");
+    writer.column("start_price", lots, [&](const Lot& lot) { writer.number(lot.start_price); });
+    writer.raw(",");
+    writer.column("current_price", lots, [&](const Lot& lot) {
+        if (lot.current_price) {
+            writer.number(*lot.current_price);
+        } else {
+            writer.null();
+        }
+    });
+    writer.raw(",");
+    writer.column("owner_id", lots, [&](const Lot& lot) { nullable_string(lot.owner_id); });
+    writer.raw(",");
+    writer.column("created_at", lots, [&](const Lot& lot) { writer.string(lot.created_at); });
+    writer.raw(",");
+    writer.column("auction_end_date", lots, [&](const Lot& lot) { writer.string(lot.auction_end_date); });
+    writer.raw("}}");
+    return out;
+}
+
+nlohmann::json decode(const std::string& body, WireFormat format) {
+    switch (format) {
+        case WireFormat::Json:
+            break;
+        case WireFormat::MessagePack:
+            return nlohmann::json::from_msgpack(body, true, false);
+        case WireFormat::Cbor:
+            return nlohmann::json::from_cbor(body, true, false);
+    }
+    return nlohmann::json::parse(body, nullptr, false);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.hpp"
+#include "lot.h"
+
+enum class WireFormat {
+    Json,
+    MessagePack,
+    Cbor
+};
+
+const char* content_type(WireFormat format);
+
+// Picks the response format from an Accept header: the highest q-value wins,
+// then the earliest listed, and wildcards resolve to JSON. A missing or empty
+// header means JSON; std::nullopt means nothing acceptable is supported.
+std::optional<WireFormat> negotiate_format(std::string_view accept);
+
+// Format of a request body by Content-Type. Anything unrecognised is read as
+// JSON, as it was before other formats were accepted.
+WireFormat body_format(std::string_view content_type);
+
+// Lots are written straight from the struct for MessagePack and CBOR, with
+// the same keys, key order and number widths nlohmann's to_msgpack/to_cbor
+// would produce for lot_to_json(), so a client decoding into nlohmann::json
+// sees identical documents in every format.
+std::string encode(const Lot& lot, WireFormat format);
+std::string encode(const std::vector<Lot>& lots, WireFormat format);
+
+// GET /lots?format=columnar: one JSON array per field instead of one object
+// per lot, written directly without building a document. Values render as
+// lot_to_json() would, though doubles may differ in the last textual digit
+// choice (never in value).
+std::string encode_columnar(const std::vector<Lot>& lots);
+
+// Decodes a request body; returns a discarded value on malformed input.
+nlohmann::json decode(const std::string& body, WireFormat format);
@@ -0,0 +1,131 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "bulkhead.h"
+#include "check.h"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr auto kNoDeadline = std::chrono::steady_clock::time_point::max();
+
+void wait_for_queued(const Bulkhead& bulkhead, std::size_t queued) {
+    while (bulkhead.stats()["queued"].get<std::size_t>() != queued) {
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+void test_limits() {
+    CHECK_THROWS(Bulkhead("empty", BulkheadSettings{0, 0, 10ms}), std::invalid_argument);
+
+    Bulkhead bulkhead("limits", BulkheadSettings{2, 0, 10ms});
+    auto first = bulkhead.acquire();
+    auto second = bulkhead.acquire();
+    CHECK(first && second);
+    // No queue: a third request is turned away at once.
+    CHECK(!bulkhead.acquire());
+    CHECK(bulkhead.stats()["rejected_queue_full"] == 1);
+
+    first.reset();
+    CHECK(bulkhead.acquire());
+    CHECK(bulkhead.stats()["active"] == 1);
+}
+
+void test_queue_timeout_and_deadline() {
+    Bulkhead bulkhead("timeout", BulkheadSettings{1, 4, 20ms});
+    auto held = bulkhead.acquire();
+
+    auto started = std::chrono::steady_clock::now();
+    CHECK(!bulkhead.acquire());
+    CHECK(std::chrono::steady_clock::now() - started >= 20ms);
+
+    // The caller's deadline wins when it is earlier than the queue timeout.
+    CHECK(!bulkhead.acquire(std::chrono::steady_clock::now() - 1ms));
+    auto stats = bulkhead.stats();
+    CHECK(stats["rejected_timeout"] == 2);
+    CHECK(stats["queued"] == 0);
+}
+
+void test_release_hands_slot_to_oldest_waiter() {
+    Bulkhead bulkhead("handoff", BulkheadSettings{1, 4, 5s});
+    auto held = bulkhead.acquire();
+    CHECK(held);
+
+    std::mutex order_mutex;
+    std::vector<int> order;
+    std::atomic<bool> proceed{false};
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 3; ++i) {
+        waiters.emplace_back([&bulkhead, &order_mutex, &order, &proceed, i] {
+            auto permit = bulkhead.acquire(kNoDeadline);
+            CHECK(permit);
+            {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(i);
+            }
+            while (!proceed.load()) {
+                std::this_thread::sleep_for(1ms);
+            }
+        });
+        wait_for_queued(bulkhead, static_cast<std::size_t>(i) + 1);
+    }
+
+    // The freed slot goes straight to the oldest waiter; a caller arriving
+    // now queues behind the other two instead of taking it.
+    held.reset();
+    wait_for_queued(bulkhead, 2);
+    CHECK(!bulkhead.acquire(std::chrono::steady_clock::now()));
+    proceed.store(true);
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+    CHECK((order == std::vector<int>{0, 1, 2}));
+    auto stats = bulkhead.stats();
+    CHECK(stats["active"] == 0);
+    CHECK(stats["admitted"] == 4);
+    CHECK(stats["waited"] == 4);
+    CHECK(stats["rejected_timeout"] == 1);
+}
+
+void test_urgent_waiters_go_first() {
+    Bulkhead bulkhead("urgent", BulkheadSettings{1, 4, 5s});
+    auto held = bulkhead.acquire();
+
+    std::mutex order_mutex;
+    std::vector<RequestPriority> order;
+    auto wait = [&](RequestPriority priority) {
+        return std::thread([&bulkhead, &order_mutex, &order, priority] {
+            auto permit = bulkhead.acquire(kNoDeadline, priority);
+            CHECK(permit);
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(priority);
+        });
+    };
+    auto normal = wait(RequestPriority::Normal);
+    wait_for_queued(bulkhead, 1);
+    auto urgent = wait(RequestPriority::Urgent);
+    wait_for_queued(bulkhead, 2);
+
+    held.reset();
+    normal.join();
+    urgent.join();
+    CHECK((order == std::vector<RequestPriority>{RequestPriority::Urgent, RequestPriority::Normal}));
+    CHECK(bulkhead.stats()["urgent_admitted"] == 1);
+}
+
+} // namespace
+
+int main() {
+    test_limits();
+    test_queue_timeout_and_deadline();
+    test_release_hands_slot_to_oldest_waiter();
+    test_urgent_waiters_go_first();
+    std::puts("bulkhead_test: ok");
+    return 0;
+}
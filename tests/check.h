@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Test executables under tests/ report a failed check and exit non-zero, so
+// ctest marks them failed. Unlike assert() this stays active in release builds.
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (0)
+
+#define CHECK_THROWS(expression, exception) \
+    do { \
+        bool thrown = false; \
+        try { \
+            (void)(expression); \
+        } catch (const exception&) { \
+            thrown = true; \
+        } \
+        if (!thrown) { \
+            std::fprintf(stderr, "%s:%d: %s did not throw %s\n", __FILE__, __LINE__, #expression, #exception); \
+            std::exit(1); \
+        } \
+    } while (0)
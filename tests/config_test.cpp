@@ -0,0 +1,157 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "check.h"
+#include "config.h"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// Every variable the tests set, cleared up front so the caller's environment
+// cannot leak in.
+const char* const kVariables[] = {"DATABASE_URL", "REGISTRY_SERVICE_URL", "PAYMENT_SERVICE_URL", "SERVICE_PORT",
+                                  "PAYMENT_TIMEOUT_MS", "READ_POOL_SIZE", "HTTP_THREADS", "REQUEST_ACCOUNTING",
+                                  "TOKEN_ED25519_PUBLIC_KEY", "CONFIG_TEST_UNUSED"};
+
+class ConfigFile {
+public:
+    ConfigFile()
+        : path_((std::filesystem::temp_directory_path() / ("config_test_" + std::to_string(getpid()) + ".json"))
+                    .string()) {}
+    ~ConfigFile() { std::filesystem::remove(path_); }
+
+    void write(const std::string& contents) const { std::ofstream(path_) << contents; }
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+const char* const kRequired = R"(
+    "database_url": "postgres://localhost/auction",
+    "registry_service_url": "http://registry",
+    "payment_service_url": "http://payment",
+    "service_port": 8080
+)";
+
+std::string with_required(const std::string& extra = "") {
+    return "{" + std::string(kRequired) + (extra.empty() ? "" : ", " + extra) + "}";
+}
+
+void test_file_values_and_defaults(const ConfigFile& file) {
+    file.write(with_required(R"("payment_timeout_ms": 1500, "request_accounting": true, "read_pool_size": "4")"));
+    auto config = load_config(file.path());
+    CHECK(config.startup.database_url == "postgres://localhost/auction");
+    CHECK(config.startup.service_port == 8080);
+    CHECK(config.startup.request_accounting);
+    CHECK(config.startup.read_pool.max_concurrent == 4);
+    CHECK(config.runtime.payment_timeout == 1500ms);
+    // Untouched settings keep their defaults; http_threads follows the pools.
+    CHECK(config.runtime.registry_timeout == 5000ms);
+    CHECK(config.startup.http_threads == 4 + 32 + 8 + 16 + 2 + 4);
+    CHECK(config.startup_values.at("read_pool_size") == "4");
+    CHECK(config.startup_values.count("payment_timeout_ms") == 0);
+}
+
+void test_environment_overrides_file(const ConfigFile& file) {
+    file.write(with_required(R"("payment_timeout_ms": 1500, "read_pool_size": 4)"));
+    setenv("PAYMENT_TIMEOUT_MS", "2500", 1);
+    setenv("SERVICE_PORT", "9090", 1);
+    auto config = load_config(file.path());
+    CHECK(config.runtime.payment_timeout == 2500ms);
+    CHECK(config.startup.service_port == 9090);
+    CHECK(config.startup_values.at("service_port") == "9090");
+
+    // An empty variable counts as unset.
+    setenv("PAYMENT_TIMEOUT_MS", "", 1);
+    CHECK(load_config(file.path()).runtime.payment_timeout == 1500ms);
+    unsetenv("PAYMENT_TIMEOUT_MS");
+    unsetenv("SERVICE_PORT");
+
+    // Without a file everything comes from the environment.
+    setenv("DATABASE_URL", "postgres://env/auction", 1);
+    setenv("REGISTRY_SERVICE_URL", "http://registry", 1);
+    setenv("PAYMENT_SERVICE_URL", "http://payment", 1);
+    setenv("SERVICE_PORT", "8081", 1);
+    CHECK(load_config("").startup.database_url == "postgres://env/auction");
+    for (const auto* name : kVariables) {
+        unsetenv(name);
+    }
+}
+
+void test_unknown_and_invalid_keys(const ConfigFile& file) {
+    file.write(with_required(R"("payment_timeout": 1500)"));
+    try {
+        load_config(file.path());
+        CHECK(false);
+    } catch (const std::runtime_error& ex) {
+        CHECK(std::string(ex.what()) == "Unknown configuration key in file: payment_timeout");
+    }
+
+    // Only file keys are checked; unrelated environment variables are fine.
+    setenv("CONFIG_TEST_UNUSED", "1", 1);
+    file.write(with_required());
+    load_config(file.path());
+    unsetenv("CONFIG_TEST_UNUSED");
+
+    for (const char* extra : {R"("payment_timeout_ms": "soon")", R"("payment_timeout_ms": "15x")",
+                              R"("payment_timeout_ms": 0)", R"("request_accounting": "maybe")",
+                              R"("read_pool_size": [4])", R"("token_ed25519_public_key": "c2hvcnQ=")"}) {
+        file.write(with_required(extra));
+        CHECK_THROWS(load_config(file.path()), std::runtime_error);
+    }
+
+    file.write(R"({"database_url": "postgres://localhost/auction"})");
+    CHECK_THROWS(load_config(file.path()), std::runtime_error);
+    file.write("not json");
+    CHECK_THROWS(load_config(file.path()), std::runtime_error);
+    CHECK_THROWS(load_config(file.path() + ".missing"), std::runtime_error);
+}
+
+void test_reload(const ConfigFile& file) {
+    file.write(with_required(R"("payment_timeout_ms": 1500, "read_pool_size": 4)"));
+    ConfigStore store(load_config(file.path()), file.path());
+    int notified = 0;
+    store.on_reload([&notified](const ServiceConfig&) { ++notified; });
+
+    // Runtime settings apply at once; startup settings are only reported.
+    file.write(with_required(R"("payment_timeout_ms": 700, "read_pool_size": 6)"));
+    auto result = store.reload();
+    CHECK(result.ok);
+    CHECK((result.restart_required == std::vector<std::string>{"read_pool_size"}));
+    CHECK(store.current()->runtime.payment_timeout == 700ms);
+    CHECK(store.current()->startup.read_pool.max_concurrent == 4);
+    CHECK(notified == 1);
+
+    // A broken file leaves the published configuration alone.
+    file.write(with_required(R"("bogus": 1)"));
+    result = store.reload();
+    CHECK(!result.ok);
+    CHECK(result.error == "Unknown configuration key in file: bogus");
+    CHECK(store.current()->runtime.payment_timeout == 700ms);
+    CHECK(notified == 1);
+}
+
+} // namespace
+
+int main() {
+    for (const auto* name : kVariables) {
+        unsetenv(name);
+    }
+    ConfigFile file;
+    test_file_values_and_defaults(file);
+    test_environment_overrides_file(file);
+    test_unknown_and_invalid_keys(file);
+    test_reload(file);
+    std::puts("config_test: ok");
+    return 0;
+}
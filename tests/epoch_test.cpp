@@ -0,0 +1,98 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#include "check.h"
+#include "epoch.h"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+void mark_freed(void* flag) {
+    static_cast<std::atomic<bool>*>(flag)->store(true);
+}
+
+// Retires enough garbage to run several collections, each of which may
+// advance the epoch by one.
+void churn() {
+    for (int i = 0; i < 1000; ++i) {
+        epoch_retire(new int(i));
+    }
+}
+
+void test_guard_on_another_thread_delays_reclamation() {
+    std::atomic<bool> freed{false};
+    std::atomic<bool> entered{false};
+    std::atomic<bool> leave{false};
+    std::thread reader([&entered, &leave] {
+        EpochGuard guard;
+        entered.store(true);
+        while (!leave.load()) {
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+    while (!entered.load()) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    epoch_retire(&freed, mark_freed);
+    churn();
+    CHECK(!freed.load());
+
+    leave.store(true);
+    reader.join();
+    churn();
+    CHECK(freed.load());
+}
+
+void test_nested_guards() {
+    std::atomic<bool> freed{false};
+    {
+        EpochGuard outer;
+        {
+            EpochGuard inner;
+        }
+        // Leaving the inner guard must not end the outer one.
+        epoch_retire(&freed, mark_freed);
+        churn();
+        CHECK(!freed.load());
+    }
+    churn();
+    CHECK(freed.load());
+}
+
+void test_epoch_passed() {
+    const auto quiet = epoch_current();
+    CHECK(!epoch_passed(quiet));
+    churn();
+    CHECK(epoch_passed(quiet));
+
+    EpochGuard guard;
+    const auto guarded = epoch_current();
+    churn();
+    CHECK(!epoch_passed(guarded));
+}
+
+void test_stats() {
+    const auto before = epoch_stats();
+    churn();
+    const auto after = epoch_stats();
+    CHECK(after["freed"].get<std::uint64_t>() > before["freed"].get<std::uint64_t>());
+    CHECK(after["epoch"].get<std::uint64_t>() > before["epoch"].get<std::uint64_t>());
+    CHECK(after["threads"].get<std::size_t>() >= 1);
+}
+
+} // namespace
+
+int main() {
+    test_guard_on_another_thread_delays_reclamation();
+    test_nested_guards();
+    test_epoch_passed();
+    test_stats();
+    std::puts("epoch_test: ok");
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "check.h"
+#include "expected.h"
+
+namespace {
+
+enum class ParseError { Empty, NotANumber };
+
+Expected<int, ParseError> parse(const std::string& text) {
+    if (text.empty()) {
+        return Unexpected(ParseError::Empty);
+    }
+    try {
+        return std::stoi(text);
+    } catch (const std::exception&) {
+        return Unexpected(ParseError::NotANumber);
+    }
+}
+
+struct Bid {
+    std::string bidder;
+    int amount{0};
+};
+
+void test_value_and_error() {
+    auto parsed = parse("42");
+    CHECK(parsed.has_value());
+    CHECK(static_cast<bool>(parsed));
+    CHECK(parsed.value() == 42);
+    CHECK(*parsed == 42);
+
+    auto empty = parse("");
+    CHECK(!empty.has_value());
+    CHECK(!empty);
+    CHECK(empty.error() == ParseError::Empty);
+    CHECK(parse("forty-two").error() == ParseError::NotANumber);
+}
+
+void test_access_and_mutation() {
+    Expected<Bid, std::string> bid(Bid{"alice", 10});
+    CHECK(bid->bidder == "alice");
+    bid->amount += 5;
+    (*bid).bidder = "bob";
+    const auto& view = bid;
+    CHECK(view->amount == 15);
+    CHECK(view.value().bidder == "bob");
+
+    Expected<Bid, std::string> rejected(Unexpected(std::string("Bid is too low")));
+    CHECK(rejected.error() == "Bid is too low");
+}
+
+void test_move_only_values() {
+    Expected<std::unique_ptr<int>, ParseError> owned(std::make_unique<int>(7));
+    auto taken = std::move(owned).value();
+    CHECK(taken && *taken == 7);
+
+    Expected<std::unique_ptr<int>, ParseError> failed(Unexpected(ParseError::Empty));
+    auto moved = std::move(failed);
+    CHECK(moved.error() == ParseError::Empty);
+}
+
+} // namespace
+
+int main() {
+    test_value_and_error();
+    test_access_and_mutation();
+    test_move_only_values();
+    std::puts("expected_test: ok");
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "lot_cache.h"
+
+namespace {
+
+constexpr int kLots = 1000;
+
+// Every field is derived from the price, so a reader can tell a torn or
+// reclaimed version from a consistent one by the price alone.
+Lot make_lot(int id, int price_cents) {
+    Lot lot;
+    lot.id = id;
+    lot.name = "lot-" + std::to_string(id) + "-" + std::to_string(price_cents) + std::string(price_cents % 50, 'n');
+    if (price_cents % 2 != 0) {
+        lot.description = std::string(price_cents % 4000, static_cast<char>('a' + price_cents % 26));
+    }
+    lot.start_price = 1.0;
+    lot.current_price = price_cents / 100.0;
+    if (price_cents % 3 != 0) {
+        lot.owner_id = "user-" + std::to_string(price_cents % 17);
+    }
+    lot.created_at = "2024-01-01 00:00:00+00";
+    lot.auction_end_date = "2025-01-01 00:00:00." + std::to_string(1 + price_cents % 9) + "+00";
+    return lot;
+}
+
+bool consistent(const Lot& lot) {
+    if (!lot.current_price) {
+        return false;
+    }
+    const auto expected = make_lot(lot.id, static_cast<int>(std::lround(*lot.current_price * 100)));
+    return lot.name == expected.name && lot.description == expected.description && lot.owner_id == expected.owner_id &&
+           lot.created_at == expected.created_at && lot.auction_end_date == expected.auction_end_date;
+}
+
+} // namespace
+
+int main() {
+    // Smaller than the id space, so writers also evict.
+    LotCache cache(kLots / 2);
+    std::atomic<bool> writing{true};
+    std::atomic<long> reads{0};
+    std::atomic<long> inconsistent{0};
+
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 2; ++w) {
+        writers.emplace_back([&cache, w] {
+            std::mt19937 rng(static_cast<unsigned>(w));
+            for (int i = 0; i < 100000; ++i) {
+                const int id = static_cast<int>(rng() % kLots);
+                if (rng() % 10 == 0) {
+                    cache.erase(id);
+                } else {
+                    cache.put(make_lot(id, static_cast<int>(rng() % 100000)));
+                }
+            }
+        });
+    }
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&, r] {
+            std::mt19937 rng(static_cast<unsigned>(100 + r));
+            while (writing.load()) {
+                const int id = static_cast<int>(rng() % kLots);
+                if (auto cached = cache.get(id); cached && !consistent(cached->lot)) {
+                    inconsistent.fetch_add(1);
+                }
+                if (auto state = cache.bid_state(id); state && state->auction_end_us <= 0) {
+                    inconsistent.fetch_add(1);
+                }
+                reads.fetch_add(1);
+            }
+        });
+    }
+
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    writing.store(false);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    const auto stats = cache.stats();
+    CHECK(inconsistent.load() == 0);
+    CHECK(reads.load() > 0);
+    CHECK(cache.size() <= kLots / 2);
+    // The descriptions written above add up to far more than the compaction
+    // threshold, so live text has been copied while readers were active.
+    CHECK(stats["compactions"].get<int>() > 0);
+    for (int id = 0; id < kLots; ++id) {
+        if (auto cached = cache.get(id)) {
+            CHECK(consistent(cached->lot));
+        }
+    }
+    std::printf("lot_cache_concurrency_test: ok (%ld reads, %d compactions)\n", reads.load(),
+                stats["compactions"].get<int>());
+    return 0;
+}
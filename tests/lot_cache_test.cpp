@@ -0,0 +1,217 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "check.h"
+#include "lot_cache.h"
+
+namespace {
+
+Lot make_lot(int id) {
+    Lot lot;
+    lot.id = id;
+    lot.name = "lot " + std::to_string(id);
+    lot.start_price = 12.5;
+    lot.created_at = "2024-03-01 12:34:56.789012+00";
+    lot.auction_end_date = "2024-04-01 18:00:00+00";
+    return lot;
+}
+
+bool same_lot(const Lot& a, const Lot& b) {
+    return a.id == b.id && a.name == b.name && a.description == b.description && a.start_price == b.start_price &&
+           a.current_price == b.current_price && a.owner_id == b.owner_id && a.created_at == b.created_at &&
+           a.auction_end_date == b.auction_end_date;
+}
+
+void test_round_trip() {
+    LotCache cache(16);
+
+    auto plain = make_lot(1);
+    CHECK(cache.put(plain));
+    auto cached = cache.get(1);
+    CHECK(cached);
+    CHECK(same_lot(cached->lot, plain));
+
+    // Long names leave the inline buffer, and timestamps keep their offset
+    // and fraction exactly as Postgres rendered them.
+    auto full = make_lot(-7);
+    full.name = std::string(200, 'n');
+    full.description = std::string(5000, 'd');
+    full.current_price = 1234567.89;
+    full.owner_id = "user-42";
+    full.created_at = "1999-12-31 23:59:59.5-03:30";
+    full.auction_end_date = "2030-01-01 00:00:00.000001+05:45";
+    CHECK(cache.put(full));
+    CHECK(same_lot(cache.get(-7)->lot, full));
+
+    // Present but empty differs from absent.
+    auto empty = make_lot(2);
+    empty.description = "";
+    empty.owner_id = "";
+    CHECK(cache.put(empty));
+    CHECK(same_lot(cache.get(2)->lot, empty));
+
+    CHECK(!cache.get(3));
+    auto stats = cache.stats();
+    CHECK(stats["hits"] == 3);
+    CHECK(stats["misses"] == 1);
+}
+
+void test_overwrite_and_erase() {
+    LotCache cache(16);
+    auto lot = make_lot(5);
+    lot.description = "first";
+    CHECK(cache.put(lot));
+    lot.description = "second, and longer than the first";
+    lot.current_price = 99.99;
+    CHECK(cache.put(lot));
+    CHECK(cache.size() == 1);
+    CHECK(same_lot(cache.get(5)->lot, lot));
+
+    cache.erase(5);
+    CHECK(!cache.get(5));
+    CHECK(cache.size() == 0);
+    cache.erase(5);
+}
+
+void test_unrepresentable_lot_drops_entry() {
+    LotCache cache(16);
+    auto lot = make_lot(9);
+    CHECK(cache.put(lot));
+    // A copy that cannot be stored must not leave the older one behind.
+    lot.created_at = "yesterday";
+    CHECK(!cache.put(lot));
+    CHECK(!cache.get(9));
+
+    LotCache disabled(0);
+    CHECK(!disabled.put(make_lot(1)));
+    CHECK(!disabled.get(1));
+}
+
+void test_bid_state() {
+    LotCache cache(16);
+    auto lot = make_lot(4);
+    CHECK(cache.put(lot));
+    auto state = cache.bid_state(4);
+    CHECK(state);
+    CHECK(state->price_cents == 1250);
+    // 2024-04-01 18:00:00 UTC.
+    CHECK(state->auction_end_us == 1711994400LL * 1000000);
+
+    lot.current_price = 20.01;
+    CHECK(cache.put(lot));
+    CHECK(cache.bid_state(4)->price_cents == 2001);
+    CHECK(!cache.bid_state(5));
+}
+
+void test_capacity() {
+    LotCache cache(100);
+    for (int id = 0; id < 1000; ++id) {
+        CHECK(cache.put(make_lot(id)));
+        CHECK(cache.size() <= 100);
+    }
+    CHECK(cache.size() == 100);
+    CHECK(cache.stats()["evictions"] == 900);
+    CHECK(cache.get(999));
+}
+
+void test_refresh() {
+    LotCache cache(16);
+    auto lot = make_lot(1);
+    const auto read_started = std::chrono::steady_clock::now();
+    CHECK(!cache.refresh(lot, read_started));
+    CHECK(!cache.get(1));
+
+    CHECK(cache.put(lot));
+    // Stored after the read began: the database copy is older.
+    lot.name = "reloaded";
+    CHECK(!cache.refresh(lot, read_started));
+    CHECK(cache.get(1)->lot.name == "lot 1");
+
+    CHECK(cache.refresh(lot, read_started + std::chrono::seconds(5)));
+    CHECK(cache.get(1)->lot.name == "reloaded");
+}
+
+void test_compaction() {
+    LotCache cache(64);
+    // Rewriting the same lots with fresh descriptions leaves the old text in
+    // the arena until compaction copies the live strings out.
+    for (int round = 0; round < 200; ++round) {
+        for (int id = 0; id < 64; ++id) {
+            auto lot = make_lot(id);
+            lot.description = std::string(2000, static_cast<char>('a' + (round + id) % 26));
+            CHECK(cache.put(lot));
+        }
+    }
+    auto stats = cache.stats();
+    CHECK(stats["compactions"].get<int>() > 0);
+    CHECK(stats["string_bytes_garbage"].get<std::size_t>() < 16u << 20);
+    for (int id = 0; id < 64; ++id) {
+        auto cached = cache.get(id);
+        CHECK(cached);
+        CHECK(*cached->lot.description == std::string(2000, static_cast<char>('a' + (199 + id) % 26)));
+    }
+}
+
+void test_compaction_is_incremental() {
+    constexpr int kLots = 4096;
+    constexpr std::size_t kDescription = 4000;
+    LotCache cache(kLots);
+    auto describe = [](int id, int round) {
+        auto lot = make_lot(id);
+        lot.description = std::string(kDescription, static_cast<char>('a' + (id + round) % 26));
+        return lot;
+    };
+    auto pending = [&cache] { return cache.stats()["compaction_pending_lots"].get<std::size_t>(); };
+    for (int id = 0; id < kLots; ++id) {
+        CHECK(cache.put(describe(id, 0)));
+    }
+
+    // Rewrite until the garbage outweighs the live text and a compaction starts.
+    int round = 1;
+    int id = 0;
+    while (pending() == 0) {
+        CHECK(cache.put(describe(id, round)));
+        if (++id == kLots) {
+            id = 0;
+            ++round;
+        }
+    }
+    // The put that started it moved only a step's worth of entries.
+    CHECK(pending() >= kLots - 16);
+    CHECK(cache.stats()["compactions"] == 0);
+
+    // Later writes finish the job a step at a time, some of them storing text
+    // the entry already had; live text is accounted exactly throughout.
+    int writes = 0;
+    while (pending() > 0) {
+        CHECK(cache.put(describe(id, writes % 2 == 0 ? round : round - 1)));
+        ++writes;
+        CHECK(cache.stats()["string_bytes_live"].get<std::size_t>() == kLots * kDescription);
+    }
+    CHECK(writes >= kLots / 16 - 1);
+    auto stats = cache.stats();
+    CHECK(stats["compactions"] == 1);
+    CHECK(stats["string_bytes_live"].get<std::size_t>() == kLots * kDescription);
+    CHECK(stats["string_bytes_garbage"].get<std::size_t>() < kLots * kDescription);
+    for (int check = 0; check < kLots; ++check) {
+        auto cached = cache.get(check);
+        CHECK(cached);
+        CHECK(cached->lot.description->size() == kDescription);
+    }
+}
+
+} // namespace
+
+int main() {
+    test_round_trip();
+    test_overwrite_and_erase();
+    test_unrepresentable_lot_drops_entry();
+    test_bid_state();
+    test_capacity();
+    test_refresh();
+    test_compaction();
+    test_compaction_is_incremental();
+    std::puts("lot_cache_test: ok");
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "check.h"
+#include "httplib.h"
+#include "token_verifier.h"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+const std::string kService = "AuctionService";
+const std::string kSecret = "test-hmac-secret";
+const std::string kSeed(32, '\x07');
+
+nlohmann::json claims_for(const std::string& id) {
+    return nlohmann::json{
+        {"jti", id},
+        {"exp", std::time(nullptr) + 300},
+        {"svc", kService},
+        {"methods", {"PlaceBid"}}
+    };
+}
+
+SignedTokenStatus status_of(const TokenVerifier& verifier, const std::string& token,
+                            const std::string& method = "PlaceBid") {
+    return verifier.verify(token, kService, method).status;
+}
+
+// Serves the deny-list the verifier polls, or 503 once `failing` is set.
+class FakePaymentService {
+public:
+    FakePaymentService() {
+        server_.Get("/token/revoked", [this](const httplib::Request&, httplib::Response& res) {
+            if (failing.load()) {
+                res.status = 503;
+                return;
+            }
+            res.set_content(R"({"revoked": ["revoked-id"]})", "application/json");
+        });
+        port_ = server_.bind_to_any_port("127.0.0.1");
+        CHECK(port_ > 0);
+        thread_ = std::thread([this] { server_.listen_after_bind(); });
+        server_.wait_until_ready();
+    }
+    ~FakePaymentService() {
+        server_.stop();
+        thread_.join();
+    }
+
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(port_); }
+
+    std::atomic<bool> failing{false};
+
+private:
+    httplib::Server server_;
+    int port_{0};
+    std::thread thread_;
+};
+
+template <typename Predicate>
+bool eventually(Predicate predicate) {
+    const auto give_up = std::chrono::steady_clock::now() + 5s;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > give_up) {
+            return false;
+        }
+        std::this_thread::sleep_for(10ms);
+    }
+    return true;
+}
+
+void test_base64() {
+    for (const auto& text : {std::string(), std::string("h"), std::string("he"), std::string("hel"),
+                             std::string("hell"), std::string("\xff\xfe\0?>", 5)}) {
+        std::string decoded;
+        CHECK(base64_decode(base64_encode(text), decoded) && decoded == text);
+        CHECK(base64url_decode(base64url_encode(text), decoded) && decoded == text);
+    }
+    CHECK(base64url_encode("\xfb\xff") == "-_8");
+    std::string decoded;
+    CHECK(!base64url_decode("a$b", decoded));
+    CHECK(!base64_decode("a", decoded));
+}
+
+void test_without_keys_or_deny_list() {
+    TokenVerifier verifier(TokenVerifierSettings{});
+    const auto hs256 = sign_token_hs256(claims_for("a"), kSecret);
+    const auto eddsa = sign_token_ed25519(claims_for("a"), kSeed);
+
+    CHECK(status_of(verifier, "opaque-token") == SignedTokenStatus::NotSigned);
+    CHECK(status_of(verifier, "a.b.c.d") == SignedTokenStatus::NotSigned);
+    // Without keys nothing is parsed, so an opaque token with two dots is not
+    // mistaken for a broken JWT.
+    CHECK(status_of(verifier, "abc.d$f.ghi") == SignedTokenStatus::NotSigned);
+    CHECK(status_of(verifier, hs256) == SignedTokenStatus::NotSigned);
+    CHECK(status_of(verifier, eddsa) == SignedTokenStatus::NotSigned);
+
+    // A bad signature is caught before the deny-list is consulted, but a good
+    // one still needs a current deny-list.
+    verifier.update_keys(TokenKeys{kSecret, ed25519_public_key_from_seed(kSeed)});
+    CHECK(status_of(verifier, hs256) == SignedTokenStatus::Unverifiable);
+    CHECK(status_of(verifier, sign_token_hs256(claims_for("a"), "other-secret")) == SignedTokenStatus::BadSignature);
+
+    CHECK_THROWS(verifier.update_keys(TokenKeys{"", "too short"}), std::runtime_error);
+}
+
+void test_verification() {
+    FakePaymentService payment;
+    TokenVerifierSettings settings;
+    settings.payment_service_url = payment.url();
+    settings.refresh_interval = 50ms;
+    settings.max_deny_list_age = 500ms;
+    TokenVerifier verifier(settings);
+    verifier.update_keys(TokenKeys{kSecret, ed25519_public_key_from_seed(kSeed)});
+    verifier.start();
+
+    const auto hs256 = sign_token_hs256(claims_for("a"), kSecret);
+    const auto eddsa = sign_token_ed25519(claims_for("a"), kSeed);
+    CHECK(eventually([&] { return status_of(verifier, hs256) == SignedTokenStatus::Valid; }));
+    CHECK(status_of(verifier, eddsa) == SignedTokenStatus::Valid);
+    CHECK(verifier.stats()["deny_list_entries"] == 1);
+
+    auto tampered = eddsa;
+    tampered[tampered.size() - 2] = tampered[tampered.size() - 2] == 'A' ? 'B' : 'A';
+    CHECK(status_of(verifier, tampered) == SignedTokenStatus::BadSignature);
+    CHECK(status_of(verifier, sign_token_ed25519(claims_for("a"), std::string(32, '\x08'))) ==
+          SignedTokenStatus::BadSignature);
+
+    auto claims = claims_for("a");
+    claims["exp"] = std::time(nullptr) - 1;
+    CHECK(status_of(verifier, sign_token_hs256(claims, kSecret)) == SignedTokenStatus::Expired);
+    CHECK(status_of(verifier, sign_token_ed25519(claims, kSeed)) == SignedTokenStatus::Expired);
+
+    CHECK(verifier.verify(hs256, "OtherService", "PlaceBid").status == SignedTokenStatus::WrongService);
+    CHECK(status_of(verifier, hs256, "CreateLot") == SignedTokenStatus::MethodNotAllowed);
+    claims = claims_for("a");
+    claims["svc"] = "*";
+    claims["methods"] = {"*"};
+    CHECK(status_of(verifier, sign_token_hs256(claims, kSecret), "CreateLot") == SignedTokenStatus::Valid);
+
+    CHECK(status_of(verifier, sign_token_hs256(claims_for("revoked-id"), kSecret)) == SignedTokenStatus::Revoked);
+    claims = claims_for("a");
+    claims.erase("jti");
+    CHECK(status_of(verifier, sign_token_hs256(claims, kSecret)) == SignedTokenStatus::Malformed);
+    // Tokens that merely look like JWTs still get the network check.
+    CHECK(status_of(verifier, "not base64!.e30.e30") == SignedTokenStatus::Unverifiable);
+    CHECK(status_of(verifier, "abc.d$f.ghi") == SignedTokenStatus::Unverifiable);
+    CHECK(status_of(verifier, base64url_encode("[]") + ".e30.e30") == SignedTokenStatus::Unverifiable);
+
+    // Dropping a key sends its algorithm back to the network check.
+    verifier.update_keys(TokenKeys{kSecret, ""});
+    CHECK(status_of(verifier, eddsa) == SignedTokenStatus::Unverifiable);
+    CHECK(status_of(verifier, hs256) == SignedTokenStatus::Valid);
+
+    // Once the deny-list cannot be refreshed for max_deny_list_age, nothing
+    // is accepted locally any more.
+    payment.failing.store(true);
+    CHECK(eventually([&] { return status_of(verifier, hs256) == SignedTokenStatus::Unverifiable; }));
+    CHECK(verifier.stats()["deny_list_failures"].get<int>() > 0);
+    verifier.stop();
+}
+
+} // namespace
+
+int main() {
+    test_base64();
+    test_without_keys_or_deny_list();
+    test_verification();
+    std::puts("token_verifier_test: ok");
+    return 0;
+}
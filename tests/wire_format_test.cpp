@@ -0,0 +1,161 @@
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "json.hpp"
+#include "wire_format.h"
+
+namespace {
+
+std::string as_string(const std::vector<std::uint8_t>& bytes) {
+    return std::string(bytes.begin(), bytes.end());
+}
+
+// Lots with every optional field toggled and values that cross each
+// MessagePack/CBOR width boundary.
+std::vector<Lot> make_lots(int count) {
+    std::mt19937_64 rng(3);
+    std::vector<Lot> lots;
+    for (int i = 0; i < count; ++i) {
+        Lot lot;
+        lot.id = rng() % 3 != 0 ? static_cast<int>(rng() % 100000) : static_cast<int>(rng());
+        lot.name = std::string(rng() % 300, static_cast<char>('a' + rng() % 26));
+        if (rng() % 2 != 0) {
+            lot.description = std::string(rng() % 70000, 'x');
+        }
+        lot.start_price = rng() % 3 == 0 ? static_cast<double>(rng() % 100000) / 100.0
+                                         : static_cast<double>(rng() % 64) * 0.5;
+        if (rng() % 2 != 0) {
+            lot.current_price = static_cast<double>(rng() % 10000000) / 100.0 * (rng() % 5 == 0 ? 1e30 : 1.0);
+        }
+        if (rng() % 2 != 0) {
+            lot.owner_id = "user-" + std::to_string(rng());
+        }
+        lot.created_at = "2024-01-01 00:00:00.123+00";
+        lot.auction_end_date = "2025-01-15 18:00:00+00";
+        lots.push_back(lot);
+    }
+    return lots;
+}
+
+int negotiated(const char* accept) {
+    auto format = negotiate_format(accept);
+    return format ? static_cast<int>(*format) : -1;
+}
+
+void test_negotiation() {
+    constexpr int kJson = static_cast<int>(WireFormat::Json);
+    constexpr int kMessagePack = static_cast<int>(WireFormat::MessagePack);
+    constexpr int kCbor = static_cast<int>(WireFormat::Cbor);
+
+    CHECK(negotiated("") == kJson);
+    CHECK(negotiated("  ") == kJson);
+    CHECK(negotiated("*/*") == kJson);
+    CHECK(negotiated("application/json") == kJson);
+    CHECK(negotiated("application/msgpack") == kMessagePack);
+    CHECK(negotiated("application/x-msgpack") == kMessagePack);
+    // Equal q-values: the earliest listed wins.
+    CHECK(negotiated("application/cbor, application/json") == kCbor);
+    CHECK(negotiated("application/json;q=0.5, application/cbor") == kCbor);
+    CHECK(negotiated("*/*;q=0.1, application/x-msgpack") == kMessagePack);
+    // q=0 rules a format out even when a wildcard would match it.
+    CHECK(negotiated("application/*, application/json;q=0") == kMessagePack);
+    CHECK(negotiated("Application/CBOR ; q=0.9 , text/plain") == kCbor);
+    CHECK(negotiated("text/html") == -1);
+    CHECK(negotiated("application/json;q=0") == -1);
+
+    CHECK(body_format("application/cbor; charset=binary") == WireFormat::Cbor);
+    CHECK(body_format("application/msgpack") == WireFormat::MessagePack);
+    CHECK(body_format("text/plain") == WireFormat::Json);
+    CHECK(body_format("") == WireFormat::Json);
+
+    CHECK(std::string(content_type(WireFormat::Cbor)) == "application/cbor");
+}
+
+void test_binary_encodings_match_nlohmann() {
+    const auto lots = make_lots(2000);
+    for (const auto& lot : lots) {
+        const auto json = lot_to_json(lot);
+        CHECK(encode(lot, WireFormat::MessagePack) == as_string(nlohmann::json::to_msgpack(json)));
+        CHECK(encode(lot, WireFormat::Cbor) == as_string(nlohmann::json::to_cbor(json)));
+        CHECK(encode(lot, WireFormat::Json) == json.dump());
+    }
+    // Array headers change width at 16 (MessagePack) and 24 (CBOR) elements.
+    for (std::size_t count : {0, 1, 15, 16, 23, 24, 300}) {
+        const std::vector<Lot> some(lots.begin(), lots.begin() + static_cast<std::ptrdiff_t>(count));
+        const auto json = lots_to_json(some);
+        CHECK(encode(some, WireFormat::MessagePack) == as_string(nlohmann::json::to_msgpack(json)));
+        CHECK(encode(some, WireFormat::Cbor) == as_string(nlohmann::json::to_cbor(json)));
+        CHECK(decode(encode(some, WireFormat::Cbor), WireFormat::Cbor) == json);
+        CHECK(decode(encode(some, WireFormat::MessagePack), WireFormat::MessagePack) == json);
+    }
+}
+
+void test_decode() {
+    CHECK(decode(R"({"name": "lamp"})", WireFormat::Json)["name"] == "lamp");
+    CHECK(decode("\x81\xa1\x61\x01", WireFormat::MessagePack) == nlohmann::json({{"a", 1}}));
+    CHECK(decode("\xc1", WireFormat::MessagePack).is_discarded());
+    CHECK(decode("\xff", WireFormat::Cbor).is_discarded());
+    CHECK(decode("{", WireFormat::Json).is_discarded());
+}
+
+void test_columnar() {
+    std::mt19937_64 rng(5);
+    std::vector<Lot> lots;
+    for (int i = 0; i < 1000; ++i) {
+        Lot lot;
+        lot.id = static_cast<int>(rng() % 2000000) - 1000;
+        // Control characters, quotes and multi-byte UTF-8 all need escaping
+        // exactly as nlohmann does it.
+        for (int k = 0, n = static_cast<int>(rng() % 40); k < n; ++k) {
+            lot.name.push_back(static_cast<char>(rng() % 128));
+        }
+        lot.name += "\xc3\xa9\xe2\x82\xac";
+        if (rng() % 2 != 0) {
+            lot.description = "desc \"q\" \\ \x01\x1f";
+        }
+        lot.start_price = static_cast<double>(rng() % 100000) / 100.0;
+        if (rng() % 9 == 0) {
+            lot.start_price = 1e21 * static_cast<double>(rng() % 7);
+        }
+        if (rng() % 2 != 0) {
+            lot.current_price = static_cast<double>(rng()) / 3.0;
+        }
+        if (rng() % 2 != 0) {
+            lot.owner_id = "u";
+        }
+        lot.created_at = "2024-01-01 00:00:00+00";
+        lot.auction_end_date = "2025-01-01 00:00:00+00";
+        lots.push_back(lot);
+    }
+
+    for (std::size_t count : {std::size_t{0}, std::size_t{1}, lots.size()}) {
+        const std::vector<Lot> some(lots.begin(), lots.begin() + static_cast<std::ptrdiff_t>(count));
+        const auto parsed = nlohmann::json::parse(encode_columnar(some));
+        const auto rows = lots_to_json(some);
+        CHECK(parsed["count"] == count);
+        CHECK(parsed["columns"].size() == 8);
+        for (const auto& [key, column] : parsed["columns"].items()) {
+            CHECK(column.size() == count);
+            for (std::size_t i = 0; i < count; ++i) {
+                CHECK(column[i] == rows[i][key]);
+                CHECK(column[i].is_number_float() == rows[i][key].is_number_float());
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    test_negotiation();
+    test_binary_encodings_match_nlohmann();
+    test_decode();
+    test_columnar();
+    std::puts("wire_format_test: ok");
+    return 0;
+}
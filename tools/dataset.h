@@ -0,0 +1,199 @@
+#pragma once
+
+// Reproducible description of a synthetic dataset, shared by seed_lots and
+// load generators so that both agree on which lots are hot. Everything is
+// derived from DATASET_SEED with a self-contained generator, because the
+// standard library distributions are not guaranteed to produce the same
+// sequence across implementations.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct DatasetSpec {
+    std::uint64_t seed{42};
+    int lots{100000};
+    // Exponent of the Zipf popularity distribution over lots.
+    double zipf_exponent{1.1};
+    int owners{5000};
+    // Auction end dates are spread over [-ended_days, window_days] around the
+    // base time, so a share of the lots has already closed.
+    int ended_days{1};
+    int window_days{14};
+    long long bids{0};
+};
+
+inline DatasetSpec dataset_spec_from_env() {
+    auto read = [](const char* name, auto fallback) {
+        using T = decltype(fallback);
+        const char* value = std::getenv(name);
+        if (!value || !*value) {
+            return fallback;
+        }
+        char* end = nullptr;
+        T parsed;
+        if constexpr (std::is_floating_point_v<T>) {
+            parsed = std::strtod(value, &end);
+        } else if constexpr (std::is_unsigned_v<T>) {
+            parsed = static_cast<T>(std::strtoull(value, &end, 10));
+        } else {
+            parsed = static_cast<T>(std::strtoll(value, &end, 10));
+        }
+        if (*end != '\0') {
+            throw std::invalid_argument(std::string("Invalid value for ") + name + ": " + value);
+        }
+        return parsed;
+    };
+    DatasetSpec spec;
+    spec.seed = read("DATASET_SEED", spec.seed);
+    spec.lots = read("DATASET_LOTS", spec.lots);
+    spec.zipf_exponent = read("DATASET_ZIPF_EXPONENT", spec.zipf_exponent);
+    spec.owners = read("DATASET_OWNERS", spec.owners);
+    spec.ended_days = read("DATASET_ENDED_DAYS", spec.ended_days);
+    spec.window_days = read("DATASET_WINDOW_DAYS", spec.window_days);
+    spec.bids = read("DATASET_BIDS", spec.bids);
+    if (spec.lots < 0 || spec.owners < 1 || spec.zipf_exponent <= 0.0 || spec.bids < 0 ||
+        spec.ended_days < 0 || spec.window_days < 1) {
+        throw std::invalid_argument("Dataset settings are out of range");
+    }
+    return spec;
+}
+
+// SplitMix64. Independent streams (per lot, per purpose) are derived from the
+// seed, so a lot's content does not depend on how many lots are generated.
+class DatasetRng {
+public:
+    DatasetRng(std::uint64_t seed, std::uint64_t stream) : state_(mix(seed ^ mix(stream + 0x9e3779b97f4a7c15ULL))) {}
+
+    std::uint64_t next() {
+        state_ += 0x9e3779b97f4a7c15ULL;
+        return mix(state_);
+    }
+
+    // Uniform in [0, 1).
+    double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+    // Uniform in [0, bound).
+    std::uint64_t below(std::uint64_t bound) {
+        return static_cast<std::uint64_t>((static_cast<unsigned __int128>(next()) * bound) >> 64);
+    }
+
+    double normal() {
+        double u1 = 1.0 - uniform();
+        double u2 = uniform();
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+    }
+
+    double lognormal(double median, double sigma) { return median * std::exp(sigma * normal()); }
+
+private:
+    static std::uint64_t mix(std::uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    std::uint64_t state_;
+};
+
+// Stream identifiers; load generators should draw from their own stream.
+enum class DatasetStream : std::uint64_t {
+    Popularity = 1,
+    Bids = 2,
+    Lot = 1ULL << 32,
+    BidIncrements = 2ULL << 32,
+    LoadGenerator = 3ULL << 32
+};
+
+inline DatasetRng dataset_rng(const DatasetSpec& spec, DatasetStream stream, std::uint64_t index = 0) {
+    return DatasetRng(spec.seed, static_cast<std::uint64_t>(stream) + index);
+}
+
+// Zipf-distributed ranks in [1, n] by rejection-inversion (Hörmann and
+// Derflinger), which needs constant memory regardless of n.
+class ZipfSampler {
+public:
+    ZipfSampler(std::uint64_t n, double exponent)
+        : n_(n),
+          exponent_(exponent),
+          h_integral_x1_(h_integral(1.5) - 1.0),
+          h_integral_n_(h_integral(static_cast<double>(n) + 0.5)),
+          s_(2.0 - h_integral_inverse(h_integral(2.5) - h(2.0))) {}
+
+    std::uint64_t sample(DatasetRng& rng) const {
+        for (;;) {
+            double u = h_integral_n_ + rng.uniform() * (h_integral_x1_ - h_integral_n_);
+            double x = h_integral_inverse(u);
+            auto k = static_cast<std::uint64_t>(x + 0.5);
+            if (k < 1) {
+                k = 1;
+            } else if (k > n_) {
+                k = n_;
+            }
+            if (static_cast<double>(k) - x <= s_ || u >= h_integral(static_cast<double>(k) + 0.5) - h(static_cast<double>(k))) {
+                return k;
+            }
+        }
+    }
+
+private:
+    double h(double x) const { return std::exp(-exponent_ * std::log(x)); }
+
+    double h_integral(double x) const {
+        double log_x = std::log(x);
+        return helper2((1.0 - exponent_) * log_x) * log_x;
+    }
+
+    double h_integral_inverse(double x) const {
+        double t = x * (1.0 - exponent_);
+        if (t < -1.0) {
+            t = -1.0;
+        }
+        return std::exp(helper1(t) * x);
+    }
+
+    // log1p(x) / x and expm1(x) / x, stable near zero.
+    static double helper1(double x) {
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+    static double helper2(double x) {
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x / 3.0 * (1.0 + 0.25 * x));
+    }
+
+    std::uint64_t n_;
+    double exponent_;
+    double h_integral_x1_;
+    double h_integral_n_;
+    double s_;
+};
+
+// Maps popularity ranks to lot ids. Ranks are shuffled over the ids so that
+// the hot lots are scattered through the table rather than being its first
+// rows. Lot ids are 1..lots, as loaded by seed_lots into an empty table.
+class LotPopularity {
+public:
+    explicit LotPopularity(const DatasetSpec& spec)
+        : zipf_(static_cast<std::uint64_t>(spec.lots > 0 ? spec.lots : 1), spec.zipf_exponent), ids_(spec.lots) {
+        for (int i = 0; i < spec.lots; ++i) {
+            ids_[i] = i + 1;
+        }
+        auto rng = dataset_rng(spec, DatasetStream::Popularity);
+        for (std::size_t i = ids_.size(); i > 1; --i) {
+            std::swap(ids_[i - 1], ids_[rng.below(i)]);
+        }
+    }
+
+    // Rank 1 is the most popular lot.
+    int lot_id_for_rank(std::uint64_t rank) const { return ids_[rank - 1]; }
+
+    int sample(DatasetRng& rng) const { return lot_id_for_rank(zipf_.sample(rng)); }
+
+private:
+    ZipfSampler zipf_;
+    std::vector<int> ids_;
+};
@@ -0,0 +1,160 @@
+// Local stand-in for the payment service, for development and tests.
+//
+//   POST /token/check    {"token", "serviceName", "methodName"} -> {"allowed": bool}
+//                        Opaque tokens starting with "deny" are refused, "invalid"
+//                        gets 401; signed tokens are verified like the service does.
+//   POST /token/issue    {"methods": [...], "service": "...", "ttl_seconds": n, "alg": "HS256"|"EdDSA"}
+//                        -> {"token", "jti", "exp"}
+//   POST /token/revoke   {"jti": "..."}
+//   GET  /token/revoked  -> {"revoked": [...]}
+//
+// Environment: PORT (default 8081), TOKEN_HMAC_SECRET, TOKEN_ED25519_SEED
+// (base64 of a 32-byte seed). The matching TOKEN_ED25519_PUBLIC_KEY for the
+// auction service is printed at startup.
+#include <openssl/rand.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "httplib.h"
+#include "json.hpp"
+#include "token_verifier.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+std::string env_or(const char* name, const std::string& fallback) {
+    const char* value = std::getenv(name);
+    return value ? value : fallback;
+}
+
+std::string random_bytes(std::size_t size) {
+    std::string bytes(size, '\0');
+    if (RAND_bytes(reinterpret_cast<unsigned char*>(bytes.data()), static_cast<int>(size)) != 1) {
+        throw std::runtime_error("RAND_bytes failed");
+    }
+    return bytes;
+}
+
+void reply(httplib::Response& res, int status, const json& body) {
+    res.status = status;
+    res.set_content(body.dump(), "application/json");
+}
+
+} // namespace
+
+int main() {
+    const int port = std::atoi(env_or("PORT", "8081").c_str());
+    const std::string hmac_secret = env_or("TOKEN_HMAC_SECRET", "dev-secret");
+    std::string ed25519_seed;
+    if (!base64_decode(env_or("TOKEN_ED25519_SEED", ""), ed25519_seed) || ed25519_seed.size() != 32) {
+        ed25519_seed = random_bytes(32);
+    }
+
+    std::cout << "TOKEN_HMAC_SECRET=" << hmac_secret << std::endl;
+    std::cout << "TOKEN_ED25519_PUBLIC_KEY=" << base64_encode(ed25519_public_key_from_seed(ed25519_seed)) << std::endl;
+
+    // Verifies signed tokens exactly like the auction service, pulling the
+    // deny-list from this very process.
+    TokenVerifierSettings verifier_settings;
+    verifier_settings.payment_service_url = "http://127.0.0.1:" + std::to_string(port);
+    verifier_settings.refresh_interval = std::chrono::milliseconds(1000);
+    TokenVerifier verifier(verifier_settings);
+    verifier.update_keys(TokenKeys{hmac_secret, ed25519_public_key_from_seed(ed25519_seed)});
+    verifier.start();
+
+    std::mutex mutex;
+    std::set<std::string> revoked;
+
+    httplib::Server server;
+
+    server.Post("/token/check", [&](const httplib::Request& req, httplib::Response& res) {
+        auto body = json::parse(req.body, nullptr, false);
+        if (!body.is_object() || !body.contains("token") || !body["token"].is_string()) {
+            reply(res, 400, {{"error", "token is required"}});
+            return;
+        }
+        const auto token = body["token"].get<std::string>();
+        const auto service = body.value("serviceName", "");
+        const auto method = body.value("methodName", "");
+
+        auto result = verifier.verify(token, service, method);
+        if (result.status == SignedTokenStatus::NotSigned) {
+            if (token.rfind("invalid", 0) == 0) {
+                reply(res, 401, {{"error", "invalid token"}});
+                return;
+            }
+            reply(res, 200, {{"allowed", token.rfind("deny", 0) != 0}});
+            return;
+        }
+        if (result.status == SignedTokenStatus::Unverifiable) {
+            reply(res, 503, {{"error", result.message}});
+            return;
+        }
+        if (result.status != SignedTokenStatus::Valid) {
+            reply(res, result.status == SignedTokenStatus::WrongService ||
+                               result.status == SignedTokenStatus::MethodNotAllowed
+                           ? 200
+                           : 401,
+                  {{"allowed", false}, {"reason", result.message}});
+            return;
+        }
+        reply(res, 200, {{"allowed", true}});
+    });
+
+    server.Post("/token/issue", [&](const httplib::Request& req, httplib::Response& res) {
+        auto body = json::parse(req.body.empty() ? "{}" : req.body, nullptr, false);
+        if (!body.is_object()) {
+            reply(res, 400, {{"error", "body must be a JSON object"}});
+            return;
+        }
+        const auto jti = base64url_encode(random_bytes(12));
+        const auto exp = static_cast<long long>(std::time(nullptr)) + body.value("ttl_seconds", 300);
+        json claims{
+            {"jti", jti},
+            {"exp", exp},
+            {"svc", body.value("service", "AuctionService")},
+            {"methods", body.value("methods", json::array({"*"}))}
+        };
+        const auto algorithm = body.value("alg", "HS256");
+        std::string token;
+        if (algorithm == "HS256") {
+            token = sign_token_hs256(claims, hmac_secret);
+        } else if (algorithm == "EdDSA") {
+            token = sign_token_ed25519(claims, ed25519_seed);
+        } else {
+            reply(res, 400, {{"error", "alg must be HS256 or EdDSA"}});
+            return;
+        }
+        reply(res, 200, {{"token", token}, {"jti", jti}, {"exp", exp}});
+    });
+
+    server.Post("/token/revoke", [&](const httplib::Request& req, httplib::Response& res) {
+        auto body = json::parse(req.body, nullptr, false);
+        if (!body.is_object() || !body.contains("jti") || !body["jti"].is_string()) {
+            reply(res, 400, {{"error", "jti is required"}});
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        revoked.insert(body["jti"].get<std::string>());
+        res.status = 204;
+    });
+
+    server.Get("/token/revoked", [&](const httplib::Request&, httplib::Response& res) {
+        std::lock_guard<std::mutex> lock(mutex);
+        reply(res, 200, {{"revoked", revoked}});
+    });
+
+    std::cout << "Fake payment service listening on port " << port << std::endl;
+    if (!server.listen("0.0.0.0", port)) {
+        std::cerr << "Failed to listen on port " << port << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,335 @@
+// Seeds Postgres with a reproducible synthetic dataset for benchmarks.
+//
+//   DATABASE_URL=postgresql://... seed_lots          load the dataset
+//   seed_lots --hot [count]                          print the hottest lot ids
+//
+// The dataset is described by the DATASET_* environment variables read in
+// dataset.h (DATASET_SEED, DATASET_LOTS, DATASET_ZIPF_EXPONENT, DATASET_OWNERS,
+// DATASET_ENDED_DAYS, DATASET_WINDOW_DAYS, DATASET_BIDS); a load generator
+// given the same values targets the same hot lots. Bids are drawn from the
+// popularity distribution and folded into lot_prices, which is where the
+// service keeps the price, version and bid count.
+//
+// The schema must already exist (start the service once) and the lots table
+// must be empty unless DATASET_TRUNCATE=1, which empties every lot table
+// first. End dates are relative to DATASET_BASE_TIME (Unix seconds, default
+// the start of the current UTC day), so the same seed and base time give
+// byte-identical tables.
+#include <libpq-fe.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dataset.h"
+
+namespace {
+
+const char* const kWords[] = {
+    "vintage", "antique", "rare", "signed", "limited", "edition", "original", "handmade", "brass", "silver",
+    "oak", "walnut", "leather", "porcelain", "glass", "ceramic", "bronze", "copper", "silk", "wool",
+    "clock", "compass", "lamp", "chair", "table", "cabinet", "mirror", "vase", "bowl", "print",
+    "painting", "sketch", "poster", "map", "camera", "lens", "watch", "ring", "brooch", "necklace",
+    "guitar", "violin", "record", "book", "manuscript", "coin", "stamp", "medal", "toy", "model",
+    "french", "italian", "japanese", "victorian", "art", "deco", "mid", "century", "modern", "rustic",
+    "restored", "working", "boxed", "mint"};
+constexpr std::size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+constexpr std::size_t kCopyBufferBytes = 1 << 20;
+
+struct SyntheticLot {
+    std::string name;
+    std::optional<std::string> description;
+    std::int64_t start_price_cents{0};
+    std::string owner_id;
+    std::int64_t created_at{0};
+    std::int64_t auction_end_date{0};
+};
+
+void append_words(DatasetRng& rng, std::size_t target_bytes, std::string& out) {
+    while (out.size() < target_bytes) {
+        if (!out.empty()) {
+            out += ' ';
+        }
+        out += kWords[rng.below(kWordCount)];
+    }
+}
+
+// Sizes follow the long tail seen in real listings: short titles, a median
+// description of a few hundred bytes and the occasional essay.
+SyntheticLot make_lot(const DatasetSpec& spec, const ZipfSampler& owners, int id, std::int64_t base_time) {
+    auto rng = dataset_rng(spec, DatasetStream::Lot, static_cast<std::uint64_t>(id));
+    SyntheticLot lot;
+    lot.start_price_cents = std::max<std::int64_t>(100, std::llround(rng.lognormal(50.0, 1.2) * 100.0));
+
+    auto name_bytes = static_cast<std::size_t>(std::clamp(rng.lognormal(28.0, 0.5), 8.0, 200.0));
+    append_words(rng, name_bytes, lot.name);
+    lot.name += " #" + std::to_string(id);
+
+    if (rng.uniform() >= 0.1) {
+        auto description_bytes = static_cast<std::size_t>(std::clamp(rng.lognormal(300.0, 1.0), 16.0, 16384.0));
+        lot.description.emplace();
+        append_words(rng, description_bytes, *lot.description);
+    }
+
+    lot.owner_id = "user-" + std::to_string(owners.sample(rng));
+
+    const std::int64_t window_seconds = static_cast<std::int64_t>(spec.ended_days + spec.window_days) * 86400;
+    lot.auction_end_date = base_time - static_cast<std::int64_t>(spec.ended_days) * 86400 +
+                           static_cast<std::int64_t>(rng.below(static_cast<std::uint64_t>(window_seconds)));
+    lot.created_at = lot.auction_end_date - 86400 - static_cast<std::int64_t>(rng.below(13 * 86400));
+    return lot;
+}
+
+std::string format_timestamp(std::int64_t seconds) {
+    std::time_t time = static_cast<std::time_t>(seconds);
+    std::tm utc{};
+    gmtime_r(&time, &utc);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S+00", &utc);
+    return buffer;
+}
+
+std::string format_cents(std::int64_t cents) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%lld.%02lld", static_cast<long long>(cents / 100),
+                  static_cast<long long>(cents % 100));
+    return buffer;
+}
+
+struct ConnectionDeleter {
+    void operator()(PGconn* conn) const { PQfinish(conn); }
+};
+using Connection = std::unique_ptr<PGconn, ConnectionDeleter>;
+
+struct ResultDeleter {
+    void operator()(PGresult* result) const { PQclear(result); }
+};
+using Result = std::unique_ptr<PGresult, ResultDeleter>;
+
+Result exec(PGconn* conn, const std::string& sql, ExecStatusType expected = PGRES_COMMAND_OK) {
+    Result result(PQexec(conn, sql.c_str()));
+    if (PQresultStatus(result.get()) != expected) {
+        throw std::runtime_error(sql + ": " + PQerrorMessage(conn));
+    }
+    return result;
+}
+
+// Streams rows in COPY text format, flushing in large chunks.
+class CopyWriter {
+public:
+    CopyWriter(PGconn* conn, const std::string& statement) : conn_(conn) {
+        exec(conn_, statement, PGRES_COPY_IN);
+        buffer_.reserve(kCopyBufferBytes + 64 * 1024);
+    }
+
+    void field(std::string_view value) {
+        separate();
+        for (char c : value) {
+            switch (c) {
+                case '\\':
+                    buffer_ += "\\\\";
+                    break;
+                case '\t':
+                    buffer_ += "\\t";
+                    break;
+                case '\n':
+                    buffer_ += "\\n";
+                    break;
+                case '\r':
+                    buffer_ += "\\r";
+                    break;
+                default:
+                    buffer_ += c;
+            }
+        }
+    }
+
+    void null() {
+        separate();
+        buffer_ += "\\N";
+    }
+
+    void end_row() {
+        buffer_ += '\n';
+        first_field_ = true;
+        ++rows_;
+        if (buffer_.size() >= kCopyBufferBytes) {
+            flush();
+        }
+    }
+
+    long long finish() {
+        flush();
+        if (PQputCopyEnd(conn_, nullptr) != 1) {
+            throw std::runtime_error(std::string("COPY end failed: ") + PQerrorMessage(conn_));
+        }
+        Result result(PQgetResult(conn_));
+        if (PQresultStatus(result.get()) != PGRES_COMMAND_OK) {
+            throw std::runtime_error(std::string("COPY failed: ") + PQerrorMessage(conn_));
+        }
+        while (PGresult* extra = PQgetResult(conn_)) {
+            PQclear(extra);
+        }
+        return rows_;
+    }
+
+private:
+    void separate() {
+        if (!first_field_) {
+            buffer_ += '\t';
+        }
+        first_field_ = false;
+    }
+
+    void flush() {
+        if (buffer_.empty()) {
+            return;
+        }
+        if (PQputCopyData(conn_, buffer_.data(), static_cast<int>(buffer_.size())) != 1) {
+            throw std::runtime_error(std::string("COPY data failed: ") + PQerrorMessage(conn_));
+        }
+        buffer_.clear();
+    }
+
+    PGconn* conn_;
+    std::string buffer_;
+    bool first_field_{true};
+    long long rows_{0};
+};
+
+std::int64_t base_time_from_env() {
+    if (const char* value = std::getenv("DATASET_BASE_TIME"); value && *value) {
+        return std::strtoll(value, nullptr, 10);
+    }
+    auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::system_clock::now().time_since_epoch()).count();
+    return now - now % 86400;
+}
+
+void print_hot_lots(const DatasetSpec& spec, long long count) {
+    LotPopularity popularity(spec);
+    count = std::min<long long>(count, spec.lots);
+    for (long long rank = 1; rank <= count; ++rank) {
+        std::cout << popularity.lot_id_for_rank(static_cast<std::uint64_t>(rank)) << '\n';
+    }
+}
+
+void seed(const DatasetSpec& spec, const char* database_url) {
+    Connection conn(PQconnectdb(database_url));
+    if (PQstatus(conn.get()) != CONNECTION_OK) {
+        throw std::runtime_error(std::string("Connection failed: ") + PQerrorMessage(conn.get()));
+    }
+    const auto base_time = base_time_from_env();
+    const auto started = std::chrono::steady_clock::now();
+
+    // Bids only decide how many times each lot was outbid; the prices they
+    // reached are replayed per lot below.
+    std::vector<std::int32_t> bid_counts(static_cast<std::size_t>(spec.lots) + 1, 0);
+    if (spec.bids > 0 && spec.lots > 0) {
+        LotPopularity popularity(spec);
+        auto rng = dataset_rng(spec, DatasetStream::Bids);
+        for (long long i = 0; i < spec.bids; ++i) {
+            ++bid_counts[static_cast<std::size_t>(popularity.sample(rng))];
+        }
+    }
+
+    exec(conn.get(), "BEGIN");
+    auto schema = exec(conn.get(), "SELECT to_regclass('lots') IS NOT NULL AND to_regclass('lot_prices') IS NOT NULL",
+                       PGRES_TUPLES_OK);
+    if (std::string_view(PQgetvalue(schema.get(), 0, 0)) != "t") {
+        throw std::runtime_error("Schema not found; start the service once to create it");
+    }
+    const char* truncate = std::getenv("DATASET_TRUNCATE");
+    if (truncate && std::string_view(truncate) == "1") {
+        exec(conn.get(), "TRUNCATE lots, lot_prices, lots_archive, outbox RESTART IDENTITY");
+    } else {
+        auto existing = exec(conn.get(), "SELECT EXISTS (SELECT 1 FROM lots)", PGRES_TUPLES_OK);
+        if (std::string_view(PQgetvalue(existing.get(), 0, 0)) == "t") {
+            throw std::runtime_error("Table lots is not empty; set DATASET_TRUNCATE=1 to replace its contents");
+        }
+    }
+
+    ZipfSampler owners(static_cast<std::uint64_t>(spec.owners), 1.0);
+    std::vector<std::int64_t> start_prices(static_cast<std::size_t>(spec.lots) + 1, 0);
+    CopyWriter lots(conn.get(),
+                    "COPY lots (id, name, description, start_price, owner_id, created_at, auction_end_date) FROM STDIN");
+    for (int id = 1; id <= spec.lots; ++id) {
+        auto lot = make_lot(spec, owners, id, base_time);
+        start_prices[static_cast<std::size_t>(id)] = lot.start_price_cents;
+        lots.field(std::to_string(id));
+        lots.field(lot.name);
+        if (lot.description) {
+            lots.field(*lot.description);
+        } else {
+            lots.null();
+        }
+        lots.field(format_cents(lot.start_price_cents));
+        lots.field(lot.owner_id);
+        lots.field(format_timestamp(lot.created_at));
+        lots.field(format_timestamp(lot.auction_end_date));
+        lots.end_row();
+    }
+    lots.finish();
+
+    CopyWriter prices(conn.get(), "COPY lot_prices (lot_id, current_price, version, bid_count) FROM STDIN");
+    for (int id = 1; id <= spec.lots; ++id) {
+        auto price = start_prices[static_cast<std::size_t>(id)];
+        const auto bids = bid_counts[static_cast<std::size_t>(id)];
+        auto rng = dataset_rng(spec, DatasetStream::BidIncrements, static_cast<std::uint64_t>(id));
+        for (std::int32_t i = 0; i < bids; ++i) {
+            // Each bid beats the previous price by 1-10%, and by at least a cent.
+            price += std::max<std::int64_t>(1, std::llround(static_cast<double>(price) * (0.01 + 0.09 * rng.uniform())));
+        }
+        prices.field(std::to_string(id));
+        prices.field(format_cents(price));
+        prices.field(std::to_string(bids));
+        prices.field(std::to_string(bids));
+        prices.end_row();
+    }
+    prices.finish();
+
+    if (spec.lots > 0) {
+        exec(conn.get(), "SELECT setval(pg_get_serial_sequence('lots', 'id'), " + std::to_string(spec.lots) + ")",
+             PGRES_TUPLES_OK);
+    }
+    exec(conn.get(), "COMMIT");
+    exec(conn.get(), "ANALYZE lots, lot_prices");
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::printf("seed=%llu lots=%d bids=%lld base_time=%lld elapsed=%.2fs rate=%.0f lots/min\n",
+                static_cast<unsigned long long>(spec.seed), spec.lots, spec.bids, static_cast<long long>(base_time),
+                seconds, seconds > 0 ? spec.lots / seconds * 60.0 : 0.0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const auto spec = dataset_spec_from_env();
+        if (argc > 1 && std::string_view(argv[1]) == "--hot") {
+            print_hot_lots(spec, argc > 2 ? std::atoll(argv[2]) : 100);
+            return 0;
+        }
+        const char* url = std::getenv("DATABASE_URL");
+        if (!url) {
+            std::fprintf(stderr, "DATABASE_URL is not set\n");
+            return 1;
+        }
+        seed(spec, url);
+        return 0;
+    } catch (const std::exception& ex) {
+        std::fprintf(stderr, "seed_lots: %s\n", ex.what());
+        return 1;
+    }
+}